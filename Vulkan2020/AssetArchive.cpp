@@ -0,0 +1,231 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "Lz4.h"
+
+namespace
+{
+	uint64_t AlignEntry( uint64_t offset )
+	{
+		return ( offset + ARCHIVE_ENTRY_ALIGNMENT - 1 ) & ~( ARCHIVE_ENTRY_ALIGNMENT - 1 );
+	}
+
+	// Files read a range at a time (FileUtils::ReadFileRange), which must stay raw to be served in place
+	bool IsReadByRange( const std::string& path )
+	{
+		return std::filesystem::path( path ).extension() == ".vtex";
+	}
+}
+
+bool AssetArchive::Open( const std::string& path )
+{
+	Close();
+
+	// Entries are read in whatever order assets load, so no sequential read-ahead
+	if ( !File.Open( path, MappedFile::AccessPattern::Normal ) || File.GetSize() < sizeof( ArchiveHeader ) )
+	{
+		Close();
+		return false;
+	}
+
+	ArchiveHeader header;
+	memcpy( &header, File.GetData(), sizeof( ArchiveHeader ) );
+
+	const uint64_t fileSize = File.GetSize();
+
+	if ( memcmp( header.identifier, ARCHIVE_IDENTIFIER, sizeof( ARCHIVE_IDENTIFIER ) ) != 0 || header.version != ARCHIVE_VERSION ||
+		header.tocOffset > fileSize || header.entryCount > ( fileSize - header.tocOffset ) / sizeof( ArchiveEntry ) ||
+		header.stringsOffset > fileSize || header.stringsSize > fileSize - header.stringsOffset )
+	{
+		Close();
+		return false;
+	}
+
+	Entries.resize( header.entryCount );
+	memcpy( Entries.data(), File.GetData() + header.tocOffset, Entries.size() * sizeof( ArchiveEntry ) );
+
+	const char* strings = reinterpret_cast< const char* >( File.GetData() + header.stringsOffset );
+
+	for ( uint32_t i = 0; i < header.entryCount; ++i )
+	{
+		const ArchiveEntry& entry = Entries[i];
+
+		bool bValid = uint64_t( entry.pathOffset ) + entry.pathLength <= header.stringsSize
+			&& entry.dataOffset <= fileSize && entry.storedSize <= fileSize - entry.dataOffset
+			&& ( entry.compression == static_cast< uint32_t >( ArchiveCompression::LZ4 ) || ( entry.compression == static_cast< uint32_t >( ArchiveCompression::None ) && entry.storedSize == entry.size ) );
+
+		if ( !bValid )
+		{
+			Close();
+			return false;
+		}
+
+		EntryIndices.emplace( std::string( strings + entry.pathOffset, entry.pathLength ), i );
+	}
+
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	File.Close();
+	Entries.clear();
+	EntryIndices.clear();
+}
+
+const ArchiveEntry* AssetArchive::Find( const std::string& path ) const
+{
+	auto found = EntryIndices.find( path );
+	return found != EntryIndices.end() ? &Entries[found->second] : nullptr;
+}
+
+bool AssetArchive::Read( const ArchiveEntry& entry, std::vector<uint8_t>& data ) const
+{
+	data.resize( static_cast< size_t >( entry.size ) );
+
+	if ( entry.compression == static_cast< uint32_t >( ArchiveCompression::LZ4 ) )
+	{
+		return Lz4::Decompress( GetStoredData( entry ), static_cast< size_t >( entry.storedSize ), data.data(), data.size() );
+	}
+
+	if ( entry.size > 0 )
+	{
+		memcpy( data.data(), GetStoredData( entry ), data.size() );
+	}
+
+	return true;
+}
+
+bool AssetArchive::Pack( const std::string& sourceDirectory, const std::string& outputPath, bool bCompress )
+{
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	std::vector<std::string> paths;
+
+	for ( fs::recursive_directory_iterator it( sourceDirectory, error ), end; !error && it != end; it.increment( error ) )
+	{
+		// Don't pack the archive into itself when it is written inside the source tree
+		if ( it->is_regular_file() && !fs::equivalent( it->path(), outputPath, error ) )
+		{
+			paths.push_back( it->path().lexically_relative( sourceDirectory ).generic_string() );
+		}
+
+		error.clear();
+	}
+
+	// Path order keeps each directory's assets contiguous
+	std::sort( paths.begin(), paths.end() );
+
+	ArchiveHeader header = {};
+	memcpy( header.identifier, ARCHIVE_IDENTIFIER, sizeof( ARCHIVE_IDENTIFIER ) );
+	header.version = ARCHIVE_VERSION;
+	header.entryCount = static_cast< uint32_t >( paths.size() );
+	header.tocOffset = sizeof( ArchiveHeader );
+	header.stringsOffset = header.tocOffset + paths.size() * sizeof( ArchiveEntry );
+
+	std::string strings;
+	std::vector<ArchiveEntry> entries( paths.size() );
+
+	for ( size_t i = 0; i < paths.size(); ++i )
+	{
+		entries[i] = {};
+		entries[i].pathOffset = static_cast< uint32_t >( strings.size() );
+		entries[i].pathLength = static_cast< uint32_t >( paths[i].size() );
+		strings += paths[i];
+	}
+
+	header.stringsSize = strings.size();
+
+	std::ofstream file( outputPath, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		std::cerr << "failed to create " << outputPath << std::endl;
+		return false;
+	}
+
+	// The table of contents is rewritten once every entry's offset and size is known
+	file.write( reinterpret_cast< const char* >( &header ), sizeof( ArchiveHeader ) );
+	file.write( reinterpret_cast< const char* >( entries.data() ), entries.size() * sizeof( ArchiveEntry ) );
+	file.write( strings.data(), strings.size() );
+
+	uint64_t offset = header.stringsOffset + header.stringsSize;
+	uint64_t rawBytes = 0;
+	std::vector<uint8_t> compressed;
+	const char padding[ARCHIVE_ENTRY_ALIGNMENT] = {};
+
+	for ( size_t i = 0; i < paths.size(); ++i )
+	{
+		MappedFile source( ( fs::path( sourceDirectory ) / paths[i] ).string() );
+		if ( !source.IsOpen() )
+		{
+			std::cerr << "failed to read " << paths[i] << std::endl;
+			return false;
+		}
+
+		ArchiveEntry& entry = entries[i];
+		entry.size = source.GetSize();
+		entry.storedSize = source.GetSize();
+		entry.compression = static_cast< uint32_t >( ArchiveCompression::None );
+
+		const uint8_t* pStored = source.GetData();
+
+		// Already compressed formats (JPEG, PNG, BC blocks) rarely gain anything; keep LZ4 only when it pays
+		if ( bCompress && entry.size > 0 && !IsReadByRange( paths[i] ) )
+		{
+			compressed.resize( Lz4::CompressBound( source.GetSize() ) );
+			size_t compressedSize = Lz4::Compress( source.GetData(), source.GetSize(), compressed.data(), compressed.size() );
+
+			if ( compressedSize > 0 && compressedSize <= entry.size - entry.size / 8 )
+			{
+				entry.storedSize = compressedSize;
+				entry.compression = static_cast< uint32_t >( ArchiveCompression::LZ4 );
+				pStored = compressed.data();
+			}
+		}
+
+		uint64_t alignedOffset = AlignEntry( offset );
+		file.write( padding, static_cast< std::streamsize >( alignedOffset - offset ) );
+
+		entry.dataOffset = alignedOffset;
+		if ( entry.storedSize > 0 )
+		{
+			file.write( reinterpret_cast< const char* >( pStored ), static_cast< std::streamsize >( entry.storedSize ) );
+		}
+
+		offset = alignedOffset + entry.storedSize;
+		rawBytes += entry.size;
+	}
+
+	file.seekp( static_cast< std::streamoff >( header.tocOffset ) );
+	file.write( reinterpret_cast< const char* >( entries.data() ), entries.size() * sizeof( ArchiveEntry ) );
+
+	if ( !file.good() )
+	{
+		std::cerr << "failed to write " << outputPath << std::endl;
+		return false;
+	}
+
+	std::cout << outputPath << ": " << paths.size() << " files, " << rawBytes << " bytes packed into " << offset << std::endl;
+
+	return true;
+}
+
+int AssetArchive::RunCommandLine( int argc, char** argv )
+{
+	if ( argc < 2 )
+	{
+		std::cerr << "usage: Vulkan2020 -pack <source directory> <output.vpak> [-nocompress]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	bool bCompress = !( argc > 2 && strcmp( argv[2], "-nocompress" ) == 0 );
+
+	return Pack( argv[0], argv[1], bCompress ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Packed asset archive (.vpak): a header, the table of contents and the path strings up front,
+// then each entry's data aligned to ARCHIVE_ENTRY_ALIGNMENT, sorted by path so a directory's
+// assets sit next to each other on disk. Entries are stored raw, or LZ4 block compressed when
+// that saves at least an eighth; .vtex files, which streaming reads a few levels at a time, are
+// always raw. The whole archive is one mapped file, so loading hundreds of assets costs one open
+// instead of hundreds.
+constexpr uint8_t ARCHIVE_IDENTIFIER[8] = { 0xAB, 'V', 'P', 'A', 'K', 0xBB, '\r', '\n' };
+constexpr uint32_t ARCHIVE_VERSION = 1;
+constexpr uint64_t ARCHIVE_ENTRY_ALIGNMENT = 16;	// raw entries are served in place; keeps SPIR-V and .vtex levels aligned
+
+enum class ArchiveCompression : uint32_t
+{
+	None = 0,
+	LZ4 = 1,
+};
+
+struct ArchiveHeader
+{
+	uint8_t identifier[8];
+	uint32_t version;
+	uint32_t entryCount;
+	uint64_t tocOffset;		// entryCount ArchiveEntry records
+	uint64_t stringsOffset;	// entry paths, not null terminated
+	uint64_t stringsSize;
+};
+
+struct ArchiveEntry
+{
+	uint64_t dataOffset;
+	uint64_t storedSize;	// bytes in the archive
+	uint64_t size;			// bytes once decompressed
+	uint32_t pathOffset;	// into the string table; '/' separated, relative to the archive root
+	uint32_t pathLength;
+	uint32_t compression;	// ArchiveCompression
+	uint32_t reserved;
+};
+
+class AssetArchive
+{
+public:
+	bool Open( const std::string& path );
+	void Close();
+
+	const ArchiveEntry* Find( const std::string& path ) const;
+
+	// Raw entries only: the entry's bytes inside the mapping
+	const uint8_t* GetStoredData( const ArchiveEntry& entry ) const { return File.GetData() + entry.dataOffset; }
+
+	// Decompresses or copies the entry into data
+	bool Read( const ArchiveEntry& entry, std::vector<uint8_t>& data ) const;
+
+	uint32_t GetEntryCount() const { return static_cast< uint32_t >( Entries.size() ); }
+
+	// Packs every file under sourceDirectory, paths relative to it
+	static bool Pack( const std::string& sourceDirectory, const std::string& outputPath, bool bCompress );
+
+	// Vulkan2020 -pack <source directory> <output.vpak> [-nocompress]; argv excludes the program name and -pack
+	static int RunCommandLine( int argc, char** argv );
+
+private:
+	MappedFile File;
+	std::vector<ArchiveEntry> Entries;
+	std::unordered_map<std::string, uint32_t> EntryIndices;
+};
\ No newline at end of file
@@ -0,0 +1,756 @@
+#include "AssetDatabase.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+#include "FileUtils.h"
+#include "JobPool.h"
+#include "MappedFile.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+
+namespace
+{
+	constexpr const char* DATABASE_NAME = "assets.db";
+
+	// Bump when a cooker's output changes for the same inputs, so existing artifacts are rebuilt
+	constexpr uint32_t TEXTURE_COOKER_VERSION = 1;
+	constexpr uint32_t MESH_COOKER_VERSION = 3;
+	constexpr uint32_t SHADER_COOKER_VERSION = 1;
+
+	// Mirrors Shaders/compileShaders.bat; anything not listed compiles with glslc's defaults
+	const std::pair<const char*, const char*> SHADER_ARGUMENTS[] =
+	{
+		{ "bindlessFrag.frag", "--target-env=vulkan1.2" },
+		{ "bindlessIndirectFrag.frag", "--target-env=vulkan1.2" },
+	};
+
+	// Normal maps and other non colour data are cooked linear
+	const char* const LINEAR_TEXTURE_SUFFIXES[] = { "_n", "_nrm", "_normal" };
+
+	void PrintUsage()
+	{
+		std::cerr << "usage: Vulkan2020 -build <asset root>... [-bc1|-bc3|-bc] [-force] [-threads <count>]" << std::endl;
+	}
+
+	std::string GetExtension( const std::string& path )
+	{
+		std::string extension = std::filesystem::path( path ).extension().string();
+		std::transform( extension.begin(), extension.end(), extension.begin(), []( char c ) { return static_cast< char >( tolower( c ) ); } );
+
+		return extension;
+	}
+
+	// 64 bit FNV-1a, continued from hash
+	uint64_t HashBytes( const void* pData, size_t size, uint64_t hash = 14695981039346656037ull )
+	{
+		const uint8_t* pBytes = static_cast< const uint8_t* >( pData );
+
+		for ( size_t i = 0; i < size; ++i )
+		{
+			hash = ( hash ^ pBytes[i] ) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	bool StatFile( const std::string& path, uint64_t& size, int64_t& writeTime )
+	{
+		std::error_code error;
+
+		size = std::filesystem::file_size( path, error );
+		if ( error )
+		{
+			return false;
+		}
+
+		writeTime = static_cast< int64_t >( std::filesystem::last_write_time( path, error ).time_since_epoch().count() );
+
+		return !error;
+	}
+
+	// Path of a file referenced from includingPath, relative to the root like includingPath
+	std::string ResolveReference( const std::string& includingPath, const std::string& reference )
+	{
+		return ( std::filesystem::path( includingPath ).parent_path() / reference ).lexically_normal().generic_string();
+	}
+
+	// Every whitespace separated name following keyword at the start of a line, e.g. "mtllib a.mtl b.mtl"
+	void FindLineReferences( const MappedFile& file, const char* keyword, std::vector<std::string>& references )
+	{
+		const char* pText = reinterpret_cast< const char* >( file.GetData() );
+		const char* pEnd = pText + file.GetSize();
+		const size_t keywordLength = strlen( keyword );
+
+		while ( pText < pEnd )
+		{
+			const char* pLineEnd = std::find( pText, pEnd, '\n' );
+
+			while ( pText < pLineEnd && ( *pText == ' ' || *pText == '\t' ) )
+			{
+				++pText;
+			}
+
+			if ( static_cast< size_t >( pLineEnd - pText ) > keywordLength && memcmp( pText, keyword, keywordLength ) == 0 && isspace( static_cast< unsigned char >( pText[keywordLength] ) ) )
+			{
+				std::istringstream line( std::string( pText + keywordLength, pLineEnd ) );
+				std::string reference;
+
+				while ( line >> reference )
+				{
+					references.push_back( reference );
+				}
+			}
+
+			pText = pLineEnd + ( pLineEnd < pEnd ? 1 : 0 );
+		}
+	}
+
+	// #include "name" lines; the quotes are stripped
+	void FindShaderIncludes( const MappedFile& file, std::vector<std::string>& includes )
+	{
+		std::vector<std::string> references;
+		FindLineReferences( file, "#include", references );
+
+		for ( const std::string& reference : references )
+		{
+			if ( reference.size() > 2 && ( reference.front() == '"' || reference.front() == '<' ) )
+			{
+				includes.push_back( reference.substr( 1, reference.size() - 2 ) );
+			}
+		}
+	}
+
+	std::string GetCompilerPath()
+	{
+		const char* pSDK = getenv( "VULKAN_SDK" );
+		if ( pSDK == nullptr )
+		{
+			return "glslc";
+		}
+
+#ifdef _WIN32
+		return std::string( pSDK ) + "/Bin/glslc.exe";
+#else
+		return std::string( pSDK ) + "/bin/glslc";
+#endif
+	}
+}
+
+void AssetDatabase::Load( const std::string& rootDirectory )
+{
+	root = rootDirectory;
+	files.clear();
+	artifacts.clear();
+
+	std::ifstream file( GetFullPath( DATABASE_NAME ) );
+	std::string line;
+
+	uint32_t version = 0;
+	if ( !std::getline( file, line ) || sscanf( line.c_str(), "assetdb %u", &version ) != 1 || version != DATABASE_VERSION )
+	{
+		return;
+	}
+
+	// Paths go last on each line since they may contain spaces
+	ArtifactRecord* pArtifact = nullptr;
+
+	while ( std::getline( file, line ) )
+	{
+		std::istringstream fields( line );
+		std::string tag;
+		fields >> tag;
+
+		if ( tag == "file" )
+		{
+			FileRecord record;
+			fields >> record.size >> record.writeTime >> std::hex >> record.hash >> std::dec;
+
+			std::string path;
+			if ( fields.get() == ' ' && std::getline( fields, path ) )
+			{
+				files[path] = record;
+			}
+		}
+		else if ( tag == "artifact" )
+		{
+			uint32_t type = 0;
+			ArtifactRecord record;
+			fields >> type >> std::hex >> record.paramsHash >> std::dec;
+			record.type = static_cast< ArtifactType >( type );
+
+			std::string path;
+			pArtifact = ( fields.get() == ' ' && std::getline( fields, path ) ) ? &( artifacts[path] = record ) : nullptr;
+		}
+		else if ( tag == "dep" && pArtifact != nullptr )
+		{
+			Dependency dependency;
+			fields >> std::hex >> dependency.hash >> std::dec;
+
+			if ( fields.get() == ' ' && std::getline( fields, dependency.path ) )
+			{
+				pArtifact->dependencies.push_back( dependency );
+			}
+		}
+	}
+}
+
+bool AssetDatabase::Save() const
+{
+	// Written to the side and renamed over, so an interrupted build never leaves a truncated database
+	std::string path = GetFullPath( DATABASE_NAME );
+	std::string tempPath = path + ".tmp";
+
+	{
+		std::ofstream file( tempPath, std::ios::trunc );
+		if ( !file.is_open() )
+		{
+			return false;
+		}
+
+		file << "assetdb " << DATABASE_VERSION << "\n";
+
+		for ( const auto& entry : files )
+		{
+			file << "file " << entry.second.size << " " << entry.second.writeTime << " " << std::hex << entry.second.hash << std::dec << " " << entry.first << "\n";
+		}
+
+		for ( const auto& entry : artifacts )
+		{
+			file << "artifact " << static_cast< uint32_t >( entry.second.type ) << " " << std::hex << entry.second.paramsHash << std::dec << " " << entry.first << "\n";
+
+			for ( const Dependency& dependency : entry.second.dependencies )
+			{
+				file << "dep " << std::hex << dependency.hash << std::dec << " " << dependency.path << "\n";
+			}
+		}
+
+		if ( !file.good() )
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename( tempPath, path, error );
+
+	return !error;
+}
+
+AssetDatabase::Statistics AssetDatabase::Build( const BuildOptions& options )
+{
+	Statistics stats;
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Every source under the root, sorted so builds and the database are deterministic
+	std::vector<std::pair<std::string, ArtifactType>> sources;
+	std::unordered_set<std::string> outputs;
+
+	std::error_code error;
+	for ( std::filesystem::recursive_directory_iterator it( root, std::filesystem::directory_options::skip_permission_denied, error ), end; !error && it != end; it.increment( error ) )
+	{
+		ArtifactType type;
+		std::string path = it->path().lexically_relative( root ).generic_string();
+
+		if ( it->is_regular_file( error ) && GetArtifactType( path, type ) )
+		{
+			sources.emplace_back( path, type );
+		}
+	}
+
+	std::sort( sources.begin(), sources.end() );
+
+	// Two sources cooking to the same file (brick.png next to brick.jpg) would overwrite each other; the first one wins
+	sources.erase( std::remove_if( sources.begin(), sources.end(), [&outputs]( const std::pair<std::string, ArtifactType>& source )
+	{
+		if ( outputs.insert( GetOutputPath( source.second, source.first ) ).second )
+		{
+			return false;
+		}
+
+		std::cerr << "skipping " << source.first << ": its output is already produced by another source" << std::endl;
+		return true;
+	} ), sources.end() );
+
+	// Records of deleted sources are dropped; their outputs are left where they are
+	std::unordered_set<std::string> sourcePaths;
+	for ( const auto& source : sources )
+	{
+		sourcePaths.insert( source.first );
+	}
+
+	for ( auto it = artifacts.begin(); it != artifacts.end(); )
+	{
+		it = sourcePaths.count( it->first ) ? std::next( it ) : artifacts.erase( it );
+	}
+
+	JobPool jobs;
+	jobs.Init( options.threadCount == 0 ? 0 : std::max( options.threadCount, 2u ) - 1 );
+
+	// Refresh the record of every file a source or an artifact refers to. Only files whose size or
+	// write time moved are read again, which is what keeps a one file change down to seconds.
+	std::unordered_set<std::string> referencedPaths = sourcePaths;
+	std::vector<std::string> paths( sourcePaths.begin(), sourcePaths.end() );
+
+	for ( const auto& artifact : artifacts )
+	{
+		for ( const Dependency& dependency : artifact.second.dependencies )
+		{
+			if ( referencedPaths.insert( dependency.path ).second )
+			{
+				paths.push_back( dependency.path );
+			}
+		}
+	}
+
+	std::vector<FileRecord> records( paths.size() );
+	std::vector<uint32_t> staleRecords;
+	std::vector<bool> bExists( paths.size() );
+
+	for ( uint32_t i = 0; i < paths.size(); ++i )
+	{
+		FileRecord& record = records[i];
+		bExists[i] = StatFile( GetFullPath( paths[i] ), record.size, record.writeTime );
+
+		auto found = files.find( paths[i] );
+		if ( bExists[i] && found != files.end() && found->second.size == record.size && found->second.writeTime == record.writeTime )
+		{
+			record.hash = found->second.hash;
+		}
+		else if ( bExists[i] )
+		{
+			staleRecords.push_back( i );
+		}
+	}
+
+	jobs.ParallelFor( static_cast< uint32_t >( staleRecords.size() ), [&]( uint32_t job )
+	{
+		uint32_t i = staleRecords[job];
+		if ( !FileUtils::HashFileContents( GetFullPath( paths[i] ), records[i].hash ) )
+		{
+			records[i].hash = MISSING_FILE_HASH;
+		}
+	} );
+
+	stats.filesHashed = static_cast< uint32_t >( staleRecords.size() );
+
+	files.clear();
+	for ( uint32_t i = 0; i < paths.size(); ++i )
+	{
+		if ( bExists[i] )
+		{
+			files[paths[i]] = records[i];
+		}
+	}
+
+	// An artifact is dirty if it is new, was built with other parameters, lost its output or any file it was built from changed
+	std::vector<uint32_t> dirty;
+
+	for ( uint32_t i = 0; i < sources.size(); ++i )
+	{
+		const std::string& path = sources[i].first;
+		const ArtifactType type = sources[i].second;
+
+		auto found = artifacts.find( path );
+		bool bDirty = options.bForce || found == artifacts.end() || found->second.type != type || found->second.paramsHash != GetParamsHash( type, path, options ) || !std::filesystem::exists( GetFullPath( GetOutputPath( type, path ) ), error );
+
+		for ( size_t dependency = 0; !bDirty && dependency < found->second.dependencies.size(); ++dependency )
+		{
+			auto file = files.find( found->second.dependencies[dependency].path );
+			bDirty = ( file == files.end() ? MISSING_FILE_HASH : file->second.hash ) != found->second.dependencies[dependency].hash;
+		}
+
+		if ( bDirty )
+		{
+			dirty.push_back( i );
+		}
+	}
+
+	// Cook. Jobs only read the records; what they find is merged afterwards. With several textures in
+	// flight each mip chain stays on its job's thread rather than spawning a thread per core of its own.
+	std::vector<CookResult> results( dirty.size() );
+	const uint32_t mipThreadCount = dirty.size() > 1 ? 1 : 0;
+
+	jobs.ParallelFor( static_cast< uint32_t >( dirty.size() ), [&]( uint32_t job )
+	{
+		const std::string& path = sources[dirty[job]].first;
+		const ArtifactType type = sources[dirty[job]].second;
+		CookResult& result = results[job];
+
+		// Hash before cooking: a source edited mid cook then looks changed next time rather than built
+		for ( const std::string& dependencyPath : FindDependencies( type, path ) )
+		{
+			result.dependencies.push_back( Dependency{ dependencyPath, GetFileHash( dependencyPath, result.newFiles ) } );
+		}
+
+		result.bSuccess = Cook( type, path, options, mipThreadCount );
+	} );
+
+	jobs.Cleanup();
+
+	for ( uint32_t job = 0; job < dirty.size(); ++job )
+	{
+		const std::string& path = sources[dirty[job]].first;
+		CookResult& result = results[job];
+
+		for ( auto& newFile : result.newFiles )
+		{
+			files[newFile.first] = newFile.second;
+		}
+
+		if ( result.bSuccess )
+		{
+			ArtifactRecord& record = artifacts[path];
+			record.type = sources[dirty[job]].second;
+			record.paramsHash = GetParamsHash( record.type, path, options );
+			record.dependencies = std::move( result.dependencies );
+
+			++stats.rebuilt;
+		}
+		else
+		{
+			// No record, so the next build tries again
+			artifacts.erase( path );
+
+			++stats.failed;
+		}
+	}
+
+	stats.artifacts = static_cast< uint32_t >( sources.size() );
+	stats.upToDate = stats.artifacts - static_cast< uint32_t >( dirty.size() );
+	stats.seconds = std::chrono::duration<float, std::chrono::seconds::period>( std::chrono::high_resolution_clock::now() - startTime ).count();
+
+	return stats;
+}
+
+int AssetDatabase::RunCommandLine( int argc, char** argv )
+{
+	std::vector<std::string> roots;
+	BuildOptions options;
+
+	for ( int i = 0; i < argc; ++i )
+	{
+		if ( strcmp( argv[i], "-bc1" ) == 0 )
+		{
+			options.textureCompression = TextureCooker::Compression::BC1;
+		}
+		else if ( strcmp( argv[i], "-bc3" ) == 0 )
+		{
+			options.textureCompression = TextureCooker::Compression::BC3;
+		}
+		else if ( strcmp( argv[i], "-bc" ) == 0 )
+		{
+			options.textureCompression = TextureCooker::Compression::Auto;
+		}
+		else if ( strcmp( argv[i], "-force" ) == 0 )
+		{
+			options.bForce = true;
+		}
+		else if ( strcmp( argv[i], "-threads" ) == 0 && i + 1 < argc )
+		{
+			options.threadCount = static_cast< uint32_t >( std::max( atoi( argv[++i] ), 0 ) );
+		}
+		else if ( argv[i][0] != '-' )
+		{
+			roots.push_back( argv[i] );
+		}
+		else
+		{
+			PrintUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ( roots.empty() )
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	bool bSuccess = true;
+
+	for ( const std::string& rootDirectory : roots )
+	{
+		AssetDatabase database;
+		database.Load( rootDirectory );
+
+		Statistics stats = database.Build( options );
+
+		if ( !database.Save() )
+		{
+			std::cerr << "failed to write " << database.GetFullPath( DATABASE_NAME ) << std::endl;
+			bSuccess = false;
+		}
+
+		std::cout << rootDirectory << ": " << stats.artifacts << " artifacts, " << stats.rebuilt << " rebuilt, " << stats.upToDate << " up to date, "
+			<< stats.failed << " failed, " << stats.filesHashed << " files hashed in " << stats.seconds << "s" << std::endl;
+
+		bSuccess = bSuccess && stats.failed == 0;
+	}
+
+	return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+uint64_t AssetDatabase::GetFileHash( const std::string& path, std::vector<std::pair<std::string, FileRecord>>& newFiles ) const
+{
+	auto found = files.find( path );
+	if ( found != files.end() )
+	{
+		return found->second.hash;
+	}
+
+	// A dependency no record mentioned yet, e.g. a material file added to an OBJ
+	FileRecord record;
+	std::string fullPath = GetFullPath( path );
+
+	if ( !StatFile( fullPath, record.size, record.writeTime ) || !FileUtils::HashFileContents( fullPath, record.hash ) )
+	{
+		return MISSING_FILE_HASH;
+	}
+
+	newFiles.emplace_back( path, record );
+
+	return record.hash;
+}
+
+std::vector<std::string> AssetDatabase::FindDependencies( ArtifactType type, const std::string& sourcePath ) const
+{
+	std::vector<std::string> dependencies = { sourcePath };
+
+	if ( type == ArtifactType::MeshCache )
+	{
+		// The mesh cache bakes in material colours, so the OBJ's material libraries count
+		MappedFile file( GetFullPath( sourcePath ) );
+		std::vector<std::string> libraries;
+		FindLineReferences( file, "mtllib", libraries );
+
+		for ( const std::string& library : libraries )
+		{
+			dependencies.push_back( ResolveReference( sourcePath, library ) );
+		}
+	}
+	else if ( type == ArtifactType::SPIRV )
+	{
+		// Includes are followed transitively; glslc resolves them against the including file's directory
+		for ( size_t next = 0; next < dependencies.size(); ++next )
+		{
+			MappedFile file( GetFullPath( dependencies[next] ) );
+			std::vector<std::string> includes;
+			FindShaderIncludes( file, includes );
+
+			for ( const std::string& include : includes )
+			{
+				std::string path = ResolveReference( dependencies[next], include );
+
+				if ( std::find( dependencies.begin(), dependencies.end(), path ) == dependencies.end() )
+				{
+					dependencies.push_back( path );
+				}
+			}
+		}
+	}
+
+	return dependencies;
+}
+
+bool AssetDatabase::Cook( ArtifactType type, const std::string& sourcePath, const BuildOptions& options, uint32_t mipThreadCount ) const
+{
+	std::string fullSourcePath = GetFullPath( sourcePath );
+	std::string fullOutputPath = GetFullPath( GetOutputPath( type, sourcePath ) );
+
+	switch ( type )
+	{
+	case ArtifactType::CookedTexture:
+	{
+		TextureCooker::CookOptions cookOptions = GetCookOptions( sourcePath, options );
+		cookOptions.threadCount = mipThreadCount;
+
+		return TextureCooker::CookTexture( fullSourcePath, fullOutputPath, cookOptions );
+	}
+
+	case ArtifactType::MeshCache:
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Submesh> submeshes;
+		std::vector<MeshLod> lods;
+		std::vector<Meshlet> meshlets;
+		MeshBounds bounds;
+
+		try
+		{
+			FileUtils::LoadModel( fullSourcePath.c_str(), vertices, indices, &submeshes, &bounds );
+		}
+		catch ( const std::exception& e )
+		{
+			std::cerr << "failed to load " << sourcePath << ": " << e.what() << std::endl;
+			return false;
+		}
+
+		MeshSimplifier::GenerateLods( vertices, indices, static_cast< uint32_t >( indices.size() ), bounds.radius, lods );
+		MeshletBuilder::BuildMeshlets( vertices, indices, submeshes, lods, meshlets );
+
+		if ( !FileUtils::WriteMeshCache( fullOutputPath, vertices, indices, submeshes, lods, meshlets, bounds ) )
+		{
+			std::cerr << "failed to write " << fullOutputPath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	case ArtifactType::SPIRV:
+	{
+		std::string command = "\"" + GetCompilerPath() + "\" " + GetShaderArguments( sourcePath ) + " \"" + fullSourcePath + "\" -o \"" + fullOutputPath + "\"";
+
+#ifdef _WIN32
+		// cmd.exe strips the first and last quote of the line, so wrap it in one more pair
+		command = "\"" + command + "\"";
+#endif
+
+		if ( system( command.c_str() ) != 0 )
+		{
+			std::cerr << "failed to compile " << sourcePath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+	}
+
+	return false;
+}
+
+std::string AssetDatabase::GetFullPath( const std::string& path ) const
+{
+	return ( std::filesystem::path( root ) / path ).generic_string();
+}
+
+bool AssetDatabase::GetArtifactType( const std::string& sourcePath, ArtifactType& type )
+{
+	std::string extension = GetExtension( sourcePath );
+
+	if ( extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".tga" || extension == ".bmp" )
+	{
+		type = ArtifactType::CookedTexture;
+	}
+	else if ( extension == ".obj" )
+	{
+		type = ArtifactType::MeshCache;
+	}
+	else if ( extension == ".vert" || extension == ".frag" || extension == ".comp" || extension == ".geom" || extension == ".tesc" || extension == ".tese" )
+	{
+		type = ArtifactType::SPIRV;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+std::string AssetDatabase::GetOutputPath( ArtifactType type, const std::string& sourcePath )
+{
+	std::filesystem::path path( sourcePath );
+
+	switch ( type )
+	{
+	case ArtifactType::CookedTexture:
+		return path.replace_extension( ".vtex" ).generic_string();
+
+	case ArtifactType::MeshCache:
+		return path.replace_extension( ".vmesh" ).generic_string();
+
+	case ArtifactType::SPIRV:
+		// The original pair is shader.vert/shader.frag -> vert.spv/frag.spv; everything else keeps its name
+		if ( path.stem() == "shader" )
+		{
+			return ( path.parent_path() / ( path.extension().string().substr( 1 ) + ".spv" ) ).generic_string();
+		}
+
+		return path.replace_extension( ".spv" ).generic_string();
+	}
+
+	return std::string();
+}
+
+uint64_t AssetDatabase::GetParamsHash( ArtifactType type, const std::string& sourcePath, const BuildOptions& options )
+{
+	uint64_t hash = HashBytes( &type, sizeof( type ) );
+
+	switch ( type )
+	{
+	case ArtifactType::CookedTexture:
+	{
+		TextureCooker::CookOptions cookOptions = GetCookOptions( sourcePath, options );
+		hash = HashBytes( &TEXTURE_COOKER_VERSION, sizeof( TEXTURE_COOKER_VERSION ), hash );
+		hash = HashBytes( &cookOptions.compression, sizeof( cookOptions.compression ), hash );
+		hash = HashBytes( &cookOptions.bSRGB, sizeof( cookOptions.bSRGB ), hash );
+		break;
+	}
+
+	case ArtifactType::MeshCache:
+	{
+		const uint32_t vertexStride = sizeof( Vertex );
+		hash = HashBytes( &MESH_COOKER_VERSION, sizeof( MESH_COOKER_VERSION ), hash );
+		hash = HashBytes( &VMESH_VERSION, sizeof( VMESH_VERSION ), hash );
+		hash = HashBytes( &vertexStride, sizeof( vertexStride ), hash );
+		break;
+	}
+
+	case ArtifactType::SPIRV:
+	{
+		const char* pArguments = GetShaderArguments( sourcePath );
+		hash = HashBytes( &SHADER_COOKER_VERSION, sizeof( SHADER_COOKER_VERSION ), hash );
+		hash = HashBytes( pArguments, strlen( pArguments ), hash );
+		break;
+	}
+	}
+
+	return hash;
+}
+
+TextureCooker::CookOptions AssetDatabase::GetCookOptions( const std::string& sourcePath, const BuildOptions& options )
+{
+	TextureCooker::CookOptions cookOptions;
+	cookOptions.compression = options.textureCompression;
+
+	std::string stem = std::filesystem::path( sourcePath ).stem().string();
+	std::transform( stem.begin(), stem.end(), stem.begin(), []( char c ) { return static_cast< char >( tolower( c ) ); } );
+
+	for ( const char* pSuffix : LINEAR_TEXTURE_SUFFIXES )
+	{
+		size_t suffixLength = strlen( pSuffix );
+		if ( stem.size() > suffixLength && stem.compare( stem.size() - suffixLength, suffixLength, pSuffix ) == 0 )
+		{
+			cookOptions.bSRGB = false;
+		}
+	}
+
+	return cookOptions;
+}
+
+const char* AssetDatabase::GetShaderArguments( const std::string& sourcePath )
+{
+	std::string name = std::filesystem::path( sourcePath ).filename().string();
+
+	for ( const auto& arguments : SHADER_ARGUMENTS )
+	{
+		if ( name == arguments.first )
+		{
+			return arguments.second;
+		}
+	}
+
+	return "";
+}
\ No newline at end of file
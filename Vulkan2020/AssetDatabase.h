@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TextureCooker.h"
+
+// Records, for every artifact derived from the sources under an asset root, the content hash of
+// each file it was built from and the parameters it was built with, so a build only redoes what
+// changed. Outputs sit next to their source, where the loaders already look for them:
+//   image (.jpg .jpeg .png .tga .bmp)	-> .vtex	cooked texture, see TextureCooker
+//   .obj and its mtllib files			-> .vmesh	mesh cache, see FileUtils::WriteMeshCache
+//   GLSL and its #includes				-> .spv		compiled with glslc
+// The records live in <root>/assets.db. Hashes are cached against file size and write time so
+// unchanged sources aren't reread. No artifact is an input to another, so every dirty artifact
+// is independent and they all cook in parallel on a JobPool.
+// Run through the main executable: Vulkan2020 -build <asset root>... [-bc1|-bc3|-bc] [-force] [-threads <count>]
+class AssetDatabase
+{
+public:
+	enum class ArtifactType : uint32_t
+	{
+		CookedTexture,
+		MeshCache,
+		SPIRV,
+	};
+
+	struct BuildOptions
+	{
+		TextureCooker::Compression textureCompression = TextureCooker::Compression::None;
+		bool bForce = false;		// rebuild everything regardless of the records
+		uint32_t threadCount = 0;	// including the calling thread, at least 2; 0 uses every hardware thread
+	};
+
+	struct Statistics
+	{
+		uint32_t artifacts = 0;
+		uint32_t upToDate = 0;
+		uint32_t rebuilt = 0;
+		uint32_t failed = 0;
+		uint32_t filesHashed = 0;	// sources whose size or write time changed, so they were reread
+		float seconds = 0.0f;
+	};
+
+	// Reads <rootDirectory>/assets.db; a missing or unreadable database just means everything is rebuilt
+	void Load( const std::string& rootDirectory );
+	bool Save() const;
+
+	// Scans the root for sources and cooks every artifact that is missing or out of date
+	Statistics Build( const BuildOptions& options );
+
+	// argv excludes the program name and the -build switch; returns the process exit code
+	static int RunCommandLine( int argc, char** argv );
+
+private:
+	struct FileRecord
+	{
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+		uint64_t hash = 0;
+	};
+
+	struct Dependency
+	{
+		std::string path;	// relative to the root
+		uint64_t hash;		// when the artifact was built; MISSING_FILE_HASH if the file didn't exist
+	};
+
+	struct ArtifactRecord
+	{
+		ArtifactType type = ArtifactType::CookedTexture;
+		uint64_t paramsHash = 0;
+		std::vector<Dependency> dependencies;	// the source itself first
+	};
+
+	// What one cook job hands back; merged into the records once every job has finished
+	struct CookResult
+	{
+		bool bSuccess = false;
+		std::vector<Dependency> dependencies;
+		std::vector<std::pair<std::string, FileRecord>> newFiles;
+	};
+
+	uint64_t GetFileHash( const std::string& path, std::vector<std::pair<std::string, FileRecord>>& newFiles ) const;
+	std::vector<std::string> FindDependencies( ArtifactType type, const std::string& sourcePath ) const;
+	bool Cook( ArtifactType type, const std::string& sourcePath, const BuildOptions& options, uint32_t mipThreadCount ) const;
+	std::string GetFullPath( const std::string& path ) const;
+
+	static bool GetArtifactType( const std::string& sourcePath, ArtifactType& type );
+	static std::string GetOutputPath( ArtifactType type, const std::string& sourcePath );
+	static uint64_t GetParamsHash( ArtifactType type, const std::string& sourcePath, const BuildOptions& options );
+	static TextureCooker::CookOptions GetCookOptions( const std::string& sourcePath, const BuildOptions& options );
+	static const char* GetShaderArguments( const std::string& sourcePath );
+
+	static constexpr uint32_t DATABASE_VERSION = 1;
+	static constexpr uint64_t MISSING_FILE_HASH = 0;
+
+	std::string root;
+	std::unordered_map<std::string, FileRecord> files;			// every source and dependency seen, by path relative to the root
+	std::unordered_map<std::string, ArtifactRecord> artifacts;	// by source path relative to the root
+};
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "BindlessTextureTable.h"
+
+#include <cassert>
+
+void BindlessTextureTable::Init( VkDevice vulkanDevice, DescriptorLayoutCache& layoutCache, uint32_t maxTextures )
+{
+	device = vulkanDevice;
+	capacity = maxTextures;
+
+	VkDescriptorSetLayoutBinding textureBinding = {};
+	textureBinding.binding = 0;
+	textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureBinding.descriptorCount = capacity;
+	textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	textureBinding.pImmutableSamplers = nullptr;
+
+	// Unused slots are never written, and slots are (re)written while command buffers referencing the set are pending
+	VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+	layout = layoutCache.GetLayout( { textureBinding }, { bindingFlags }, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT );
+
+	descriptorAllocator.Init( device, 1, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast< float >( capacity ) } }, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT );
+	descriptorSet = descriptorAllocator.Allocate( layout );
+}
+
+void BindlessTextureTable::Cleanup()
+{
+	// The layout belongs to the DescriptorLayoutCache
+	descriptorAllocator.Cleanup();
+
+	layout = VK_NULL_HANDLE;
+	descriptorSet = VK_NULL_HANDLE;
+	nextSlot = 0;
+	registeredCount = 0;
+	freeSlots.clear();
+}
+
+uint32_t BindlessTextureTable::RegisterTexture( VkImageView imageView, VkSampler sampler )
+{
+	uint32_t slot;
+
+	if ( !freeSlots.empty() )
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		assert( nextSlot < capacity && "bindless texture table is full!" );
+		slot = nextSlot++;
+	}
+
+	++registeredCount;
+
+	UpdateTexture( slot, imageView, sampler );
+
+	return slot;
+}
+
+void BindlessTextureTable::UpdateTexture( uint32_t slot, VkImageView imageView, VkSampler sampler )
+{
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = imageView;
+	imageInfo.sampler = sampler;
+
+	VkWriteDescriptorSet descriptorWrite = {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.dstArrayElement = slot;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets( device, 1, &descriptorWrite, 0, nullptr );
+}
+
+void BindlessTextureTable::UnregisterTexture( uint32_t slot )
+{
+	assert( slot < nextSlot && "unregistering a bindless slot that was never handed out!" );
+
+	// Partially bound: the stale descriptor is simply never indexed again until the slot is reused
+	freeSlots.push_back( slot );
+	--registeredCount;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "DescriptorAllocator.h"
+#include "LayoutCache.h"
+
+// One large, partially bound, update-after-bind array of combined image samplers that every
+// texture registers into. Shaders index it with the per-draw material index, so the whole
+// table is bound once per command buffer instead of one descriptor set per draw.
+// Requires descriptor indexing; see VulkanGraphicsInstance::CheckDescriptorIndexingSupport.
+class BindlessTextureTable
+{
+public:
+	static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+	void Init( VkDevice device, DescriptorLayoutCache& layoutCache, uint32_t maxTextures );
+	void Cleanup();
+
+	uint32_t RegisterTexture( VkImageView imageView, VkSampler sampler );
+	void UpdateTexture( uint32_t slot, VkImageView imageView, VkSampler sampler );
+	void UnregisterTexture( uint32_t slot );
+
+	VkDescriptorSetLayout GetLayout() const { return layout; }
+	VkDescriptorSet GetDescriptorSet() const { return descriptorSet; }
+
+	uint32_t GetCapacity() const { return capacity; }
+	uint32_t GetRegisteredCount() const { return registeredCount; }
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	DescriptorAllocator descriptorAllocator;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+	uint32_t capacity = 0;
+	uint32_t nextSlot = 0;
+	uint32_t registeredCount = 0;
+	std::vector<uint32_t> freeSlots;
+};
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	uint16_t PackRGB565( const uint8_t* color )
+	{
+		return static_cast< uint16_t >( ( ( color[0] * 31 + 127 ) / 255 ) << 11 | ( ( color[1] * 63 + 127 ) / 255 ) << 5 | ( color[2] * 31 + 127 ) / 255 );
+	}
+
+	void UnpackRGB565( uint16_t packed, int* color )
+	{
+		int r = ( packed >> 11 ) & 31;
+		int g = ( packed >> 5 ) & 63;
+		int b = packed & 31;
+
+		color[0] = ( r << 3 ) | ( r >> 2 );
+		color[1] = ( g << 2 ) | ( g >> 4 );
+		color[2] = ( b << 3 ) | ( b >> 2 );
+	}
+
+	void WriteLE16( uint8_t* output, uint16_t value )
+	{
+		output[0] = static_cast< uint8_t >( value & 0xFF );
+		output[1] = static_cast< uint8_t >( value >> 8 );
+	}
+
+	// Copies a 4x4 RGBA8 block out of an image, clamping at the right/bottom edge
+	void FetchBlock( const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[64] )
+	{
+		for ( uint32_t y = 0; y < 4; ++y )
+		{
+			uint32_t srcY = std::min( blockY * 4 + y, height - 1 );
+
+			for ( uint32_t x = 0; x < 4; ++x )
+			{
+				uint32_t srcX = std::min( blockX * 4 + x, width - 1 );
+				memcpy( block + ( y * 4 + x ) * 4, pixels + ( srcY * width + srcX ) * 4, 4 );
+			}
+		}
+	}
+}
+
+void BlockCompressor::CompressBlockBC1( const uint8_t block[64], uint8_t* output )
+{
+	uint8_t minColor[3] = { 255, 255, 255 };
+	uint8_t maxColor[3] = { 0, 0, 0 };
+
+	for ( int i = 0; i < 16; ++i )
+	{
+		for ( int channel = 0; channel < 3; ++channel )
+		{
+			minColor[channel] = std::min( minColor[channel], block[i * 4 + channel] );
+			maxColor[channel] = std::max( maxColor[channel], block[i * 4 + channel] );
+		}
+	}
+
+	// Pull the endpoints in by 1/16 of the range; the box corners are rarely real texel colours
+	for ( int channel = 0; channel < 3; ++channel )
+	{
+		int inset = ( maxColor[channel] - minColor[channel] ) >> 4;
+		minColor[channel] = static_cast< uint8_t >( std::min( minColor[channel] + inset, 255 ) );
+		maxColor[channel] = static_cast< uint8_t >( std::max( maxColor[channel] - inset, 0 ) );
+	}
+
+	uint16_t color0 = PackRGB565( maxColor );
+	uint16_t color1 = PackRGB565( minColor );
+
+	// color0 > color1 selects four colour mode; equal endpoints means a flat block, all indices 0
+	if ( color0 < color1 )
+	{
+		std::swap( color0, color1 );
+	}
+
+	WriteLE16( output, color0 );
+	WriteLE16( output + 2, color1 );
+
+	uint32_t indices = 0;
+
+	if ( color0 != color1 )
+	{
+		int palette[4][3];
+		UnpackRGB565( color0, palette[0] );
+		UnpackRGB565( color1, palette[1] );
+
+		for ( int channel = 0; channel < 3; ++channel )
+		{
+			palette[2][channel] = ( 2 * palette[0][channel] + palette[1][channel] ) / 3;
+			palette[3][channel] = ( palette[0][channel] + 2 * palette[1][channel] ) / 3;
+		}
+
+		for ( int i = 0; i < 16; ++i )
+		{
+			int bestIndex = 0;
+			int bestDistance = INT32_MAX;
+
+			for ( int candidate = 0; candidate < 4; ++candidate )
+			{
+				int dr = block[i * 4 + 0] - palette[candidate][0];
+				int dg = block[i * 4 + 1] - palette[candidate][1];
+				int db = block[i * 4 + 2] - palette[candidate][2];
+				int distance = dr * dr + dg * dg + db * db;
+
+				if ( distance < bestDistance )
+				{
+					bestDistance = distance;
+					bestIndex = candidate;
+				}
+			}
+
+			indices |= static_cast< uint32_t >( bestIndex ) << ( i * 2 );
+		}
+	}
+
+	memcpy( output + 4, &indices, sizeof( indices ) );
+}
+
+void BlockCompressor::CompressBlockBC3( const uint8_t block[64], uint8_t* output )
+{
+	uint8_t minAlpha = 255;
+	uint8_t maxAlpha = 0;
+
+	for ( int i = 0; i < 16; ++i )
+	{
+		minAlpha = std::min( minAlpha, block[i * 4 + 3] );
+		maxAlpha = std::max( maxAlpha, block[i * 4 + 3] );
+	}
+
+	// alpha0 > alpha1 selects the eight value ramp: alpha0, alpha1, then six interpolated steps
+	output[0] = maxAlpha;
+	output[1] = minAlpha;
+
+	uint64_t indices = 0;
+
+	if ( maxAlpha != minAlpha )
+	{
+		int palette[8];
+		palette[0] = maxAlpha;
+		palette[1] = minAlpha;
+
+		for ( int step = 1; step < 7; ++step )
+		{
+			palette[step + 1] = ( ( 7 - step ) * maxAlpha + step * minAlpha ) / 7;
+		}
+
+		for ( int i = 0; i < 16; ++i )
+		{
+			int bestIndex = 0;
+			int bestDistance = INT32_MAX;
+
+			for ( int candidate = 0; candidate < 8; ++candidate )
+			{
+				int distance = std::abs( block[i * 4 + 3] - palette[candidate] );
+
+				if ( distance < bestDistance )
+				{
+					bestDistance = distance;
+					bestIndex = candidate;
+				}
+			}
+
+			indices |= static_cast< uint64_t >( bestIndex ) << ( i * 3 );
+		}
+	}
+
+	for ( int byte = 0; byte < 6; ++byte )
+	{
+		output[2 + byte] = static_cast< uint8_t >( indices >> ( byte * 8 ) );
+	}
+
+	CompressBlockBC1( block, output + 8 );
+}
+
+bool BlockCompressor::CompressTexture( const TextureData& source, VkFormat targetFormat, TextureData& compressed )
+{
+	bool bBC3 = false;
+
+	switch ( targetFormat )
+	{
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		break;
+
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+		bBC3 = true;
+		break;
+
+	default:
+		return false;
+	}
+
+	if ( source.format != VK_FORMAT_R8G8B8A8_UNORM && source.format != VK_FORMAT_R8G8B8A8_SRGB )
+	{
+		return false;
+	}
+
+	const uint32_t bytesPerBlock = bBC3 ? 16 : 8;
+
+	compressed.format = targetFormat;
+	compressed.width = source.width;
+	compressed.height = source.height;
+	compressed.mips.clear();
+
+	size_t totalSize = 0;
+	for ( const TextureMipLevel& sourceMip : source.mips )
+	{
+		TextureMipLevel mip;
+		mip.width = sourceMip.width;
+		mip.height = sourceMip.height;
+		mip.offset = totalSize;
+		mip.size = TextureFormats::GetLevelSize( targetFormat, mip.width, mip.height );
+
+		compressed.mips.push_back( mip );
+		totalSize += mip.size;
+	}
+
+	compressed.data.resize( totalSize );
+
+	for ( size_t level = 0; level < source.mips.size(); ++level )
+	{
+		const TextureMipLevel& sourceMip = source.mips[level];
+		const uint8_t* pixels = source.data.data() + sourceMip.offset;
+		uint8_t* output = compressed.data.data() + compressed.mips[level].offset;
+
+		uint32_t blocksWide = ( sourceMip.width + 3 ) / 4;
+		uint32_t blocksHigh = ( sourceMip.height + 3 ) / 4;
+
+		for ( uint32_t blockY = 0; blockY < blocksHigh; ++blockY )
+		{
+			for ( uint32_t blockX = 0; blockX < blocksWide; ++blockX )
+			{
+				uint8_t block[64];
+				FetchBlock( pixels, sourceMip.width, sourceMip.height, blockX, blockY, block );
+
+				if ( bBC3 )
+				{
+					CompressBlockBC3( block, output );
+				}
+				else
+				{
+					CompressBlockBC1( block, output );
+				}
+
+				output += bytesPerBlock;
+			}
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
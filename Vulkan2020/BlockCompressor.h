@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "TextureFormats.h"
+
+// Minimal BC1/BC3 encoders for the texture cooker. Endpoints come from the block's colour
+// bounding box (inset slightly), so quality is below a full PCA/cluster fit, but it is fast and
+// has no dependencies. Anything better should be cooked with an external tool into a .ktx.
+namespace BlockCompressor
+{
+	// 8 bytes per 4x4 block, opaque four colour mode
+	void CompressBlockBC1( const uint8_t block[64], uint8_t* output );
+
+	// 16 bytes per 4x4 block: interpolated alpha block followed by a BC1 colour block
+	void CompressBlockBC3( const uint8_t block[64], uint8_t* output );
+
+	// Encodes every level of an RGBA8 chain; targetFormat must be a BC1 RGBA or BC3 format
+	bool CompressTexture( const TextureData& source, VkFormat targetFormat, TextureData& compressed );
+}
\ No newline at end of file
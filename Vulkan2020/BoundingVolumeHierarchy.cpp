@@ -0,0 +1,932 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace
+{
+	const uint32_t BIN_COUNT = 16;
+
+	// Past this depth splits fall back to the median, which bounds the depth and so the traversal stacks
+	const uint32_t MAX_SAH_DEPTH = 40;
+	const uint32_t STACK_SIZE = 2 * ( MAX_SAH_DEPTH + 32 );
+
+	// Refit sorts its queue below this share of the nodes (1 / n) and scans every node's flag above it
+	const uint32_t SORTED_REFIT_FRACTION = 64;
+
+	// Rebuild once refitting has grown the summed node area (relative to the root) this much past a fresh build
+	const float REBUILD_AREA_GROWTH = 1.5f;
+
+	// Half the surface area, which is all the heuristic needs
+	float GetArea( const glm::vec3& boxMin, const glm::vec3& boxMax )
+	{
+		const glm::vec3 size = glm::max( boxMax - boxMin, glm::vec3( 0.0f ) );
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	struct Bin
+	{
+		glm::vec3 min = glm::vec3( std::numeric_limits<float>::max() );
+		glm::vec3 max = glm::vec3( -std::numeric_limits<float>::max() );
+		uint32_t count = 0;
+
+		void Grow( const glm::vec3& boxMin, const glm::vec3& boxMax )
+		{
+			min = glm::min( min, boxMin );
+			max = glm::max( max, boxMax );
+		}
+	};
+
+	// Entry distance of the ray into the box, if it enters within [0, maxDistance]
+	bool IntersectRayBox( const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boxMin, const glm::vec3& boxMax, float maxDistance, float& entryDistance )
+	{
+		const glm::vec3 t0 = ( boxMin - origin ) * inverseDirection;
+		const glm::vec3 t1 = ( boxMax - origin ) * inverseDirection;
+		const glm::vec3 tNear = glm::min( t0, t1 );
+		const glm::vec3 tFar = glm::max( t0, t1 );
+
+		entryDistance = std::max( std::max( tNear.x, tNear.y ), std::max( tNear.z, 0.0f ) );
+		const float exitDistance = std::min( std::min( tFar.x, tFar.y ), std::min( tFar.z, maxDistance ) );
+
+		return entryDistance <= exitDistance;
+	}
+
+	bool IntersectRaySphere( const glm::vec3& origin, const glm::vec3& direction, const glm::vec4& sphere, float& hitDistance )
+	{
+		const glm::vec3 offset = origin - glm::vec3( sphere );
+		const float c = glm::dot( offset, offset ) - sphere.w * sphere.w;
+
+		if ( c <= 0.0f )
+		{
+			hitDistance = 0.0f;
+			return true;
+		}
+
+		const float a = glm::dot( direction, direction );
+		const float b = glm::dot( offset, direction );
+		const float discriminant = b * b - a * c;
+
+		// Outside and heading away, or passing beside it
+		if ( b >= 0.0f || discriminant < 0.0f )
+		{
+			return false;
+		}
+
+		hitDistance = ( -b - std::sqrt( discriminant ) ) / a;
+		return true;
+	}
+
+	float GetSquaredDistanceToBox( const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax )
+	{
+		const glm::vec3 offset = point - glm::clamp( point, boxMin, boxMax );
+		return glm::dot( offset, offset );
+	}
+
+	bool SphereOverlapsBox( const glm::vec4& sphere, const glm::vec3& boxMin, const glm::vec3& boxMax )
+	{
+		return GetSquaredDistanceToBox( glm::vec3( sphere ), boxMin, boxMax ) <= sphere.w * sphere.w;
+	}
+}
+
+void BoundingVolumeHierarchy::Build( const glm::vec4* pSpheres, uint32_t count )
+{
+	Clear();
+
+	if ( count == 0 )
+	{
+		return;
+	}
+
+	// Partitioning moves the spheres along with their item indices, so every pass reads them in order
+	Spheres.assign( pSpheres, pSpheres + count );
+	ItemOrder.resize( count );
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		ItemOrder[i] = i;
+	}
+
+	Nodes.reserve( count );
+	NodeParents.reserve( count );
+
+	Nodes.push_back( Node{ glm::vec3( 0.0f ), 0, glm::vec3( 0.0f ), count, 0 } );
+	NodeParents.push_back( NO_NODE );
+
+	std::vector<std::pair<uint32_t, uint32_t>> stack;	// node, depth
+	stack.push_back( { 0, 0 } );
+
+	while ( !stack.empty() )
+	{
+		const uint32_t nodeIndex = stack.back().first;
+		const uint32_t depth = stack.back().second;
+		stack.pop_back();
+
+		const uint32_t first = Nodes[nodeIndex].firstItem;
+		const uint32_t itemCount = Nodes[nodeIndex].itemCount;
+
+		glm::vec3 boxMin( std::numeric_limits<float>::max() );
+		glm::vec3 boxMax( -std::numeric_limits<float>::max() );
+		glm::vec3 centerMin = boxMin;
+		glm::vec3 centerMax = boxMax;
+
+		for ( uint32_t i = first; i < first + itemCount; ++i )
+		{
+			const glm::vec3 center = glm::vec3( Spheres[i] );
+			const float radius = Spheres[i].w;
+
+			boxMin = glm::min( boxMin, center - radius );
+			boxMax = glm::max( boxMax, center + radius );
+			centerMin = glm::min( centerMin, center );
+			centerMax = glm::max( centerMax, center );
+		}
+
+		Nodes[nodeIndex].min = boxMin;
+		Nodes[nodeIndex].max = boxMax;
+
+		if ( itemCount <= MAX_LEAF_ITEMS )
+		{
+			continue;
+		}
+
+		uint32_t leftCount = 0;
+
+		if ( depth < MAX_SAH_DEPTH )
+		{
+			leftCount = Partition( first, itemCount, centerMin, centerMax );
+		}
+
+		if ( leftCount == 0 || leftCount == itemCount )
+		{
+			// Coincident centres or too deep: split at the median of the widest axis
+			const glm::vec3 extent = centerMax - centerMin;
+			const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : ( extent.y >= extent.z ? 1 : 2 );
+
+			leftCount = itemCount / 2;
+			SplitAtMedian( first, itemCount, leftCount, axis );
+		}
+
+		const uint32_t leftChild = static_cast< uint32_t >( Nodes.size() );
+		Nodes[nodeIndex].leftChild = leftChild;
+
+		Nodes.push_back( Node{ glm::vec3( 0.0f ), first, glm::vec3( 0.0f ), leftCount, 0 } );
+		Nodes.push_back( Node{ glm::vec3( 0.0f ), first + leftCount, glm::vec3( 0.0f ), itemCount - leftCount, 0 } );
+		NodeParents.push_back( nodeIndex );
+		NodeParents.push_back( nodeIndex );
+
+		stack.push_back( { leftChild + 1, depth + 1 } );
+		stack.push_back( { leftChild, depth + 1 } );
+	}
+
+	ItemLeaves.resize( count );
+
+	for ( uint32_t nodeIndex = 0; nodeIndex < Nodes.size(); ++nodeIndex )
+	{
+		const Node& node = Nodes[nodeIndex];
+
+		if ( node.IsLeaf() )
+		{
+			for ( uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i )
+			{
+				ItemLeaves[ItemOrder[i]] = nodeIndex;
+			}
+		}
+	}
+
+	NodeDirtyFlags.assign( Nodes.size(), 0 );
+
+	NodeAreaSum = SumNodeAreas();
+	const float rootArea = GetArea( Nodes[0].min, Nodes[0].max );
+	BuiltNodeAreaRatio = rootArea > 0.0f ? NodeAreaSum / rootArea : 0.0f;
+}
+
+uint32_t BoundingVolumeHierarchy::Partition( uint32_t first, uint32_t count, const glm::vec3& centerMin, const glm::vec3& centerMax )
+{
+	// Bin the centres along the widest axis only (Wald's binned build); bins grow by the spheres' boxes, which is
+	// what the areas measure. Most nodes are small, so they get fewer bins rather than sweeping over empty ones.
+	const glm::vec3 extent = centerMax - centerMin;
+	const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : ( extent.y >= extent.z ? 1 : 2 );
+
+	if ( extent[axis] <= 0.0f )
+	{
+		return 0;
+	}
+
+	const uint32_t binCount = std::min( BIN_COUNT, count );
+	const float binScale = binCount / extent[axis];
+	const float axisMin = centerMin[axis];
+
+	auto getBin = [=]( const glm::vec4& sphere )
+	{
+		return std::min( static_cast< uint32_t >( ( sphere[axis] - axisMin ) * binScale ), binCount - 1 );
+	};
+
+	Bin bins[BIN_COUNT];
+
+	for ( uint32_t i = first; i < first + count; ++i )
+	{
+		const glm::vec4& sphere = Spheres[i];
+		Bin& bin = bins[getBin( sphere )];
+
+		bin.count++;
+		bin.Grow( glm::vec3( sphere ) - sphere.w, glm::vec3( sphere ) + sphere.w );
+	}
+
+	// Right to left sweep first, so the left to right one can evaluate every plane
+	float rightAreas[BIN_COUNT];
+	uint32_t rightCounts[BIN_COUNT];
+	Bin right;
+
+	for ( uint32_t b = binCount - 1; b > 0; --b )
+	{
+		right.Grow( bins[b].min, bins[b].max );
+		right.count += bins[b].count;
+		rightAreas[b] = right.count > 0 ? GetArea( right.min, right.max ) : 0.0f;
+		rightCounts[b] = right.count;
+	}
+
+	float bestCost = std::numeric_limits<float>::max();
+	uint32_t bestSplit = 0;
+	Bin left;
+
+	for ( uint32_t b = 0; b < binCount - 1; ++b )
+	{
+		left.Grow( bins[b].min, bins[b].max );
+		left.count += bins[b].count;
+
+		if ( left.count == 0 || rightCounts[b + 1] == 0 )
+		{
+			continue;
+		}
+
+		const float cost = GetArea( left.min, left.max ) * left.count + rightAreas[b + 1] * rightCounts[b + 1];
+
+		if ( cost < bestCost )
+		{
+			bestCost = cost;
+			bestSplit = b + 1;
+		}
+	}
+
+	if ( bestSplit == 0 )
+	{
+		return 0;
+	}
+
+	// In place, swapping the spheres and their item indices together
+	uint32_t leftEnd = first;
+	uint32_t rightBegin = first + count;
+
+	while ( leftEnd < rightBegin )
+	{
+		if ( getBin( Spheres[leftEnd] ) < bestSplit )
+		{
+			++leftEnd;
+		}
+		else
+		{
+			--rightBegin;
+			std::swap( Spheres[leftEnd], Spheres[rightBegin] );
+			std::swap( ItemOrder[leftEnd], ItemOrder[rightBegin] );
+		}
+	}
+
+	return leftEnd - first;
+}
+
+void BoundingVolumeHierarchy::SplitAtMedian( uint32_t first, uint32_t count, uint32_t leftCount, int axis )
+{
+	std::vector<uint32_t> positions( count );
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		positions[i] = first + i;
+	}
+
+	std::nth_element( positions.begin(), positions.begin() + leftCount, positions.end(),
+		[this, axis]( uint32_t a, uint32_t b ) { return Spheres[a][axis] < Spheres[b][axis]; } );
+
+	std::vector<glm::vec4> spheres( count );
+	std::vector<uint32_t> items( count );
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		spheres[i] = Spheres[positions[i]];
+		items[i] = ItemOrder[positions[i]];
+	}
+
+	std::copy( spheres.begin(), spheres.end(), Spheres.begin() + first );
+	std::copy( items.begin(), items.end(), ItemOrder.begin() + first );
+}
+
+void BoundingVolumeHierarchy::Clear()
+{
+	Nodes.clear();
+	NodeParents.clear();
+	Spheres.clear();
+	ItemOrder.clear();
+	ItemLeaves.clear();
+	DirtyNodes.clear();
+	NodeDirtyFlags.clear();
+
+	NodeAreaSum = 0.0f;
+	BuiltNodeAreaRatio = 0.0f;
+}
+
+void BoundingVolumeHierarchy::MarkMoved( uint32_t first, uint32_t count )
+{
+	assert( first + count <= ItemLeaves.size() && "item not in the hierarchy!" );
+
+	for ( uint32_t item = first; item < first + count; ++item )
+	{
+		const uint32_t leaf = ItemLeaves[item];
+
+		if ( NodeDirtyFlags[leaf] == 0 )
+		{
+			NodeDirtyFlags[leaf] = 1;
+			DirtyNodes.push_back( leaf );
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::Refit( const glm::vec4* pSpheres )
+{
+	if ( DirtyNodes.empty() )
+	{
+		return;
+	}
+
+	// Queue every ancestor once; a walk stops at the first one another leaf already queued
+	const size_t leafCount = DirtyNodes.size();
+
+	for ( size_t i = 0; i < leafCount; ++i )
+	{
+		for ( uint32_t parent = NodeParents[DirtyNodes[i]]; parent != NO_NODE && NodeDirtyFlags[parent] == 0; parent = NodeParents[parent] )
+		{
+			NodeDirtyFlags[parent] = 1;
+			DirtyNodes.push_back( parent );
+		}
+	}
+
+	// Children are stored after their parent, so descending order refits children first. When a good share
+	// of the tree is queued, scanning the flags is cheaper than sorting the queue.
+	auto refitNode = [this, pSpheres]( uint32_t nodeIndex )
+	{
+		if ( Nodes[nodeIndex].IsLeaf() )
+		{
+			RefitLeaf( nodeIndex, pSpheres );
+		}
+		else
+		{
+			RefitInternal( nodeIndex );
+		}
+
+		NodeDirtyFlags[nodeIndex] = 0;
+	};
+
+	if ( DirtyNodes.size() > Nodes.size() / SORTED_REFIT_FRACTION )
+	{
+		for ( uint32_t nodeIndex = static_cast< uint32_t >( Nodes.size() ); nodeIndex-- > 0; )
+		{
+			if ( NodeDirtyFlags[nodeIndex] != 0 )
+			{
+				refitNode( nodeIndex );
+			}
+		}
+	}
+	else
+	{
+		std::sort( DirtyNodes.begin(), DirtyNodes.end(), []( uint32_t a, uint32_t b ) { return a > b; } );
+
+		for ( uint32_t nodeIndex : DirtyNodes )
+		{
+			refitNode( nodeIndex );
+		}
+	}
+
+	DirtyNodes.clear();
+}
+
+void BoundingVolumeHierarchy::RefitAll( const glm::vec4* pSpheres )
+{
+	for ( uint32_t nodeIndex = static_cast< uint32_t >( Nodes.size() ); nodeIndex-- > 0; )
+	{
+		if ( Nodes[nodeIndex].IsLeaf() )
+		{
+			RefitLeaf( nodeIndex, pSpheres );
+		}
+		else
+		{
+			RefitInternal( nodeIndex );
+		}
+
+		NodeDirtyFlags[nodeIndex] = 0;
+	}
+
+	DirtyNodes.clear();
+
+	// Start the running sum afresh rather than carry the rounding of every incremental update
+	NodeAreaSum = SumNodeAreas();
+}
+
+void BoundingVolumeHierarchy::RefitLeaf( uint32_t nodeIndex, const glm::vec4* pSpheres )
+{
+	Node& node = Nodes[nodeIndex];
+	const float oldArea = GetArea( node.min, node.max );
+
+	node.min = glm::vec3( std::numeric_limits<float>::max() );
+	node.max = glm::vec3( -std::numeric_limits<float>::max() );
+
+	for ( uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i )
+	{
+		const glm::vec4& sphere = pSpheres[ItemOrder[i]];
+		Spheres[i] = sphere;
+
+		node.min = glm::min( node.min, glm::vec3( sphere ) - sphere.w );
+		node.max = glm::max( node.max, glm::vec3( sphere ) + sphere.w );
+	}
+
+	NodeAreaSum += GetArea( node.min, node.max ) - oldArea;
+}
+
+void BoundingVolumeHierarchy::RefitInternal( uint32_t nodeIndex )
+{
+	Node& node = Nodes[nodeIndex];
+	const Node& left = Nodes[node.leftChild];
+	const Node& right = Nodes[node.leftChild + 1];
+	const float oldArea = GetArea( node.min, node.max );
+
+	node.min = glm::min( left.min, right.min );
+	node.max = glm::max( left.max, right.max );
+
+	NodeAreaSum += GetArea( node.min, node.max ) - oldArea;
+}
+
+bool BoundingVolumeHierarchy::NeedsRebuild() const
+{
+	if ( Nodes.empty() )
+	{
+		return false;
+	}
+
+	const float rootArea = GetArea( Nodes[0].min, Nodes[0].max );
+
+	return rootArea > 0.0f && NodeAreaSum / rootArea > BuiltNodeAreaRatio * REBUILD_AREA_GROWTH;
+}
+
+float BoundingVolumeHierarchy::SumNodeAreas() const
+{
+	float sum = 0.0f;
+
+	for ( const Node& node : Nodes )
+	{
+		sum += GetArea( node.min, node.max );
+	}
+
+	return sum;
+}
+
+BoundingVolumeHierarchy::CullResult BoundingVolumeHierarchy::CullFrustum( const FrustumCulling::Frustum& frustum, uint8_t* pFlags, uint8_t cullFlag ) const
+{
+	CullResult result;
+
+	if ( Nodes.empty() )
+	{
+		return result;
+	}
+
+	struct Entry
+	{
+		uint32_t node;
+		uint32_t planeMask;
+	};
+
+	Entry stack[STACK_SIZE];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = { 0, FrustumCulling::ALL_PLANES };
+
+	while ( stackSize > 0 )
+	{
+		const Entry entry = stack[--stackSize];
+		const Node& node = Nodes[entry.node];
+
+		uint32_t planeMask = entry.planeMask;
+		const FrustumCulling::Containment containment = FrustumCulling::ClassifyBox( frustum, node.min, node.max, planeMask );
+		++result.nodesTested;
+
+		if ( containment != FrustumCulling::Containment::Intersecting )
+		{
+			// The whole subtree is a contiguous run of items, so it's settled without visiting its nodes
+			const bool bOutside = containment == FrustumCulling::Containment::Outside;
+
+			for ( uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i )
+			{
+				uint8_t& flags = pFlags[ItemOrder[i]];
+				flags = bOutside ? ( flags | cullFlag ) : ( flags & ~cullFlag );
+			}
+
+			result.visibleItems += bOutside ? 0 : node.itemCount;
+			continue;
+		}
+
+		if ( node.IsLeaf() )
+		{
+			uint8_t leafFlags[MAX_LEAF_ITEMS];
+
+			for ( uint32_t i = 0; i < node.itemCount; ++i )
+			{
+				leafFlags[i] = pFlags[ItemOrder[node.firstItem + i]];
+			}
+
+			result.visibleItems += FrustumCulling::CullSpheres( &Spheres[node.firstItem], node.itemCount, frustum, leafFlags, cullFlag );
+			result.itemsTested += node.itemCount;
+
+			for ( uint32_t i = 0; i < node.itemCount; ++i )
+			{
+				pFlags[ItemOrder[node.firstItem + i]] = leafFlags[i];
+			}
+
+			continue;
+		}
+
+		assert( stackSize + 2 <= STACK_SIZE && "hierarchy too deep!" );
+		stack[stackSize++] = { node.leftChild + 1, planeMask };
+		stack[stackSize++] = { node.leftChild, planeMask };
+	}
+
+	return result;
+}
+
+uint32_t BoundingVolumeHierarchy::Raycast( const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& hitDistance ) const
+{
+	uint32_t hitItem = INVALID_ITEM;
+	float closest = maxDistance;
+
+	if ( Nodes.empty() )
+	{
+		return hitItem;
+	}
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	float entryDistance;
+
+	if ( !IntersectRayBox( origin, inverseDirection, Nodes[0].min, Nodes[0].max, closest, entryDistance ) )
+	{
+		return hitItem;
+	}
+
+	struct Entry
+	{
+		uint32_t node;
+		float entryDistance;
+	};
+
+	Entry stack[STACK_SIZE];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = { 0, entryDistance };
+
+	while ( stackSize > 0 )
+	{
+		const Entry entry = stack[--stackSize];
+
+		// A closer hit found since this node was pushed
+		if ( entry.entryDistance > closest )
+		{
+			continue;
+		}
+
+		const Node& node = Nodes[entry.node];
+
+		if ( node.IsLeaf() )
+		{
+			for ( uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i )
+			{
+				float distance;
+
+				if ( IntersectRaySphere( origin, direction, Spheres[i], distance ) && distance <= closest )
+				{
+					closest = distance;
+					hitItem = ItemOrder[i];
+				}
+			}
+
+			continue;
+		}
+
+		float leftDistance;
+		float rightDistance;
+		const bool bLeftHit = IntersectRayBox( origin, inverseDirection, Nodes[node.leftChild].min, Nodes[node.leftChild].max, closest, leftDistance );
+		const bool bRightHit = IntersectRayBox( origin, inverseDirection, Nodes[node.leftChild + 1].min, Nodes[node.leftChild + 1].max, closest, rightDistance );
+
+		assert( stackSize + 2 <= STACK_SIZE && "hierarchy too deep!" );
+
+		// Nearer child on top, so its hits can prune the farther one
+		if ( bLeftHit && bRightHit && leftDistance > rightDistance )
+		{
+			stack[stackSize++] = { node.leftChild, leftDistance };
+			stack[stackSize++] = { node.leftChild + 1, rightDistance };
+		}
+		else
+		{
+			if ( bRightHit )
+			{
+				stack[stackSize++] = { node.leftChild + 1, rightDistance };
+			}
+
+			if ( bLeftHit )
+			{
+				stack[stackSize++] = { node.leftChild, leftDistance };
+			}
+		}
+	}
+
+	if ( hitItem != INVALID_ITEM )
+	{
+		hitDistance = closest;
+	}
+
+	return hitItem;
+}
+
+void BoundingVolumeHierarchy::QuerySphere( const glm::vec4& sphere, std::vector<uint32_t>& items ) const
+{
+	if ( Nodes.empty() )
+	{
+		return;
+	}
+
+	uint32_t stack[STACK_SIZE];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while ( stackSize > 0 )
+	{
+		const Node& node = Nodes[stack[--stackSize]];
+
+		if ( !SphereOverlapsBox( sphere, node.min, node.max ) )
+		{
+			continue;
+		}
+
+		if ( node.IsLeaf() )
+		{
+			for ( uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i )
+			{
+				const glm::vec3 offset = glm::vec3( Spheres[i] ) - glm::vec3( sphere );
+				const float reach = Spheres[i].w + sphere.w;
+
+				if ( glm::dot( offset, offset ) <= reach * reach )
+				{
+					items.push_back( ItemOrder[i] );
+				}
+			}
+
+			continue;
+		}
+
+		assert( stackSize + 2 <= STACK_SIZE && "hierarchy too deep!" );
+		stack[stackSize++] = node.leftChild + 1;
+		stack[stackSize++] = node.leftChild;
+	}
+}
+
+void BoundingVolumeHierarchy::QueryBox( const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& items ) const
+{
+	if ( Nodes.empty() )
+	{
+		return;
+	}
+
+	uint32_t stack[STACK_SIZE];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while ( stackSize > 0 )
+	{
+		const Node& node = Nodes[stack[--stackSize]];
+
+		if ( glm::any( glm::lessThan( node.max, boxMin ) ) || glm::any( glm::greaterThan( node.min, boxMax ) ) )
+		{
+			continue;
+		}
+
+		if ( node.IsLeaf() )
+		{
+			for ( uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i )
+			{
+				if ( SphereOverlapsBox( Spheres[i], boxMin, boxMax ) )
+				{
+					items.push_back( ItemOrder[i] );
+				}
+			}
+
+			continue;
+		}
+
+		assert( stackSize + 2 <= STACK_SIZE && "hierarchy too deep!" );
+		stack[stackSize++] = node.leftChild + 1;
+		stack[stackSize++] = node.leftChild;
+	}
+}
+
+BoundingVolumeHierarchy::Statistics BoundingVolumeHierarchy::GetStatistics() const
+{
+	Statistics statistics;
+	statistics.items = GetItemCount();
+	statistics.nodes = static_cast< uint32_t >( Nodes.size() );
+
+	if ( Nodes.empty() )
+	{
+		return statistics;
+	}
+
+	const float rootArea = GetArea( Nodes[0].min, Nodes[0].max );
+	std::vector<uint32_t> depths( Nodes.size(), 0 );
+
+	// Parents come first, so every parent's depth is known by the time its children are reached
+	for ( uint32_t nodeIndex = 0; nodeIndex < Nodes.size(); ++nodeIndex )
+	{
+		const Node& node = Nodes[nodeIndex];
+
+		if ( nodeIndex > 0 )
+		{
+			depths[nodeIndex] = depths[NodeParents[nodeIndex]] + 1;
+		}
+
+		statistics.maxDepth = std::max( statistics.maxDepth, depths[nodeIndex] );
+
+		const float relativeArea = rootArea > 0.0f ? GetArea( node.min, node.max ) / rootArea : 1.0f;
+
+		if ( node.IsLeaf() )
+		{
+			statistics.leaves++;
+			statistics.sahCost += relativeArea * node.itemCount;
+		}
+		else
+		{
+			statistics.sahCost += relativeArea;
+		}
+	}
+
+	return statistics;
+}
+
+int BoundingVolumeHierarchy::RunBenchmark( int argc, char** argv )
+{
+	std::vector<uint32_t> counts;
+
+	for ( int i = 0; i < argc; ++i )
+	{
+		int count = atoi( argv[i] );
+		if ( count <= 0 )
+		{
+			std::cerr << "usage: Vulkan2020 -benchbvh [object count]..." << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		counts.push_back( static_cast< uint32_t >( count ) );
+	}
+
+	if ( counts.empty() )
+	{
+		counts = { 10000, 100000, 1000000 };
+	}
+
+	using Clock = std::chrono::high_resolution_clock;
+	auto millisecondsSince = []( Clock::time_point startTime ) { return std::chrono::duration<double, std::milli>( Clock::now() - startTime ).count(); };
+
+	const uint32_t QUERY_COUNT = 10000;
+
+	std::cout << FrustumCulling::GetSIMDPathName() << " build" << std::endl;
+
+	for ( uint32_t count : counts )
+	{
+		// Same density at every size: a cube holding about one object per 64 cubic units
+		const float halfSize = std::cbrt( static_cast< float >( count ) ) * 2.0f;
+
+		std::mt19937 random( count );
+		std::uniform_real_distribution<float> position( -halfSize, halfSize );
+		std::uniform_real_distribution<float> radius( 0.5f, 1.5f );
+		std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+
+		std::vector<glm::vec4> spheres( count );
+		for ( glm::vec4& sphere : spheres )
+		{
+			sphere = glm::vec4( position( random ), position( random ), position( random ), radius( random ) );
+		}
+
+		const int iterations = count <= 100000 ? 10 : 2;
+		BoundingVolumeHierarchy hierarchy;
+
+		auto startTime = Clock::now();
+		for ( int i = 0; i < iterations; ++i )
+		{
+			hierarchy.Build( spheres.data(), count );
+		}
+		const double buildMilliseconds = millisecondsSince( startTime ) / iterations;
+
+		const Statistics statistics = hierarchy.GetStatistics();
+
+		// 1% of the objects take a small step, as in a mostly static scene
+		std::vector<uint32_t> moved( count / 100 );
+		for ( uint32_t& item : moved )
+		{
+			item = static_cast< uint32_t >( random() % count );
+		}
+
+		startTime = Clock::now();
+		for ( int i = 0; i < iterations; ++i )
+		{
+			for ( uint32_t item : moved )
+			{
+				spheres[item] += glm::vec4( unit( random ), unit( random ), unit( random ), 0.0f ) * 0.1f;
+				hierarchy.MarkMoved( item, 1 );
+			}
+
+			hierarchy.Refit( spheres.data() );
+		}
+		const double refitMilliseconds = millisecondsSince( startTime ) / iterations;
+
+		for ( glm::vec4& sphere : spheres )
+		{
+			sphere += glm::vec4( unit( random ), unit( random ), unit( random ), 0.0f ) * 0.1f;
+		}
+
+		startTime = Clock::now();
+		for ( int i = 0; i < iterations; ++i )
+		{
+			hierarchy.RefitAll( spheres.data() );
+		}
+		const double refitAllMilliseconds = millisecondsSince( startTime ) / iterations;
+
+		// 60 degree camera in the middle of the scene, seeing about a tenth of it
+		const glm::vec3 eye( 0.0f );
+		const float farDistance = halfSize;
+		const float tanHalfFov = std::tan( glm::radians( 30.0f ) );
+
+		FrustumCulling::Frustum frustum;
+		frustum.planes[0] = glm::vec4( glm::normalize( glm::vec3( 1.0f, 0.0f, tanHalfFov ) ), 0.0f );
+		frustum.planes[1] = glm::vec4( glm::normalize( glm::vec3( -1.0f, 0.0f, tanHalfFov ) ), 0.0f );
+		frustum.planes[2] = glm::vec4( glm::normalize( glm::vec3( 0.0f, 1.0f, tanHalfFov ) ), 0.0f );
+		frustum.planes[3] = glm::vec4( glm::normalize( glm::vec3( 0.0f, -1.0f, tanHalfFov ) ), 0.0f );
+		frustum.planes[4] = glm::vec4( 0.0f, 0.0f, 1.0f, -0.1f );
+		frustum.planes[5] = glm::vec4( 0.0f, 0.0f, -1.0f, farDistance );
+
+		std::vector<uint8_t> flags( count, 0 );
+		CullResult cullResult;
+
+		startTime = Clock::now();
+		for ( int i = 0; i < iterations; ++i )
+		{
+			cullResult = hierarchy.CullFrustum( frustum, flags.data(), 1 );
+		}
+		const double cullMilliseconds = millisecondsSince( startTime ) / iterations;
+
+		uint32_t linearVisible = 0;
+
+		startTime = Clock::now();
+		for ( int i = 0; i < iterations; ++i )
+		{
+			linearVisible = FrustumCulling::CullSpheres( spheres.data(), count, frustum, flags.data(), 1 );
+		}
+		const double linearCullMilliseconds = millisecondsSince( startTime ) / iterations;
+
+		uint32_t rayHits = 0;
+
+		startTime = Clock::now();
+		for ( uint32_t i = 0; i < QUERY_COUNT; ++i )
+		{
+			const glm::vec3 origin( position( random ), position( random ), position( random ) );
+			const glm::vec3 direction( unit( random ), unit( random ), unit( random ) );
+			float distance;
+
+			rayHits += hierarchy.Raycast( origin, direction, std::numeric_limits<float>::max(), distance ) != INVALID_ITEM ? 1 : 0;
+		}
+		const double rayMicroseconds = millisecondsSince( startTime ) * 1000.0 / QUERY_COUNT;
+
+		std::vector<uint32_t> found;
+		size_t foundTotal = 0;
+
+		startTime = Clock::now();
+		for ( uint32_t i = 0; i < QUERY_COUNT; ++i )
+		{
+			found.clear();
+			hierarchy.QuerySphere( glm::vec4( position( random ), position( random ), position( random ), 8.0f ), found );
+			foundTotal += found.size();
+		}
+		const double rangeMicroseconds = millisecondsSince( startTime ) * 1000.0 / QUERY_COUNT;
+
+		std::cout << count << " objects: " << statistics.nodes << " nodes, depth " << statistics.maxDepth << ", SAH cost " << statistics.sahCost << std::endl;
+		std::cout << "  build " << buildMilliseconds << " ms, refit 1% " << refitMilliseconds << " ms, refit all " << refitAllMilliseconds << " ms" << std::endl;
+		std::cout << "  frustum cull " << cullMilliseconds << " ms (" << cullResult.visibleItems << " visible, " << cullResult.nodesTested << " nodes, " << cullResult.itemsTested << " spheres tested)"
+			<< ", linear " << linearCullMilliseconds << " ms (" << linearVisible << " visible)" << std::endl;
+		std::cout << "  raycast " << rayMicroseconds << " us (" << rayHits * 100.0 / QUERY_COUNT << "% hit), range query " << rangeMicroseconds << " us (" << static_cast< double >( foundTotal ) / QUERY_COUNT << " found)" << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "FrustumCulling.h"
+
+// Axis aligned box tree over bounding spheres (xyz centre, w radius) for the scene's visibility and
+// spatial queries. Items are indices into the caller's sphere array; the tree keeps its own copy of
+// the spheres in tree order so traversals read them sequentially.
+//
+// Built top down with a binned surface area heuristic. Nodes are stored depth first with both
+// children of a node next to each other, and every node covers a contiguous run of items, so a
+// subtree found entirely inside the frustum is marked visible without visiting its nodes.
+//
+// Moving items don't need a rebuild: MarkMoved queues the leaves holding them and Refit recomputes
+// those leaves and their ancestors. Refitting keeps the topology, so the tree loosens as items move
+// far from where it was built; NeedsRebuild reports when the summed node area has grown enough that
+// building again is worth it.
+class BoundingVolumeHierarchy
+{
+public:
+	static constexpr uint32_t INVALID_ITEM = UINT32_MAX;
+
+	struct CullResult
+	{
+		uint32_t visibleItems = 0;
+		uint32_t nodesTested = 0;
+		uint32_t itemsTested = 0;	// spheres tested one by one, in leaves crossing the frustum
+	};
+
+	struct Statistics
+	{
+		uint32_t items = 0;
+		uint32_t nodes = 0;
+		uint32_t leaves = 0;
+		uint32_t maxDepth = 0;
+		float sahCost = 0.0f;		// expected node visits plus item tests for a random ray, relative to the root
+	};
+
+	void Build( const glm::vec4* pSpheres, uint32_t count );
+	void Clear();
+
+	// Queues items [first, first + count) for the next Refit
+	void MarkMoved( uint32_t first, uint32_t count );
+	// Rereads the spheres of every leaf queued since the last Refit and grows or shrinks their ancestors to match
+	void Refit( const glm::vec4* pSpheres );
+	// Rereads every sphere; cheaper than queueing when most items moved
+	void RefitAll( const glm::vec4* pSpheres );
+	bool NeedsRebuild() const;
+
+	uint32_t GetItemCount() const { return static_cast< uint32_t >( ItemOrder.size() ); }
+
+	// Sets cullFlag in pFlags[item] for every item outside the frustum and clears it for the rest
+	CullResult CullFrustum( const FrustumCulling::Frustum& frustum, uint8_t* pFlags, uint8_t cullFlag ) const;
+
+	// Nearest item whose sphere the ray hits within maxDistance, or INVALID_ITEM. direction needn't be normalised;
+	// hitDistance is in units of its length, and 0 when the origin is inside the sphere.
+	uint32_t Raycast( const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& hitDistance ) const;
+
+	// Appends every item whose sphere overlaps the query volume
+	void QuerySphere( const glm::vec4& sphere, std::vector<uint32_t>& items ) const;
+	void QueryBox( const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& items ) const;
+
+	Statistics GetStatistics() const;
+
+	// Build, refit and query timings on random scenes; returns the process exit code
+	static int RunBenchmark( int argc, char** argv );
+
+private:
+	static constexpr uint32_t MAX_LEAF_ITEMS = 4;	// one 4 wide FrustumCulling::CullSpheres batch
+	static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+	struct Node
+	{
+		glm::vec3 min;
+		uint32_t firstItem;		// into ItemOrder and Spheres
+		glm::vec3 max;
+		uint32_t itemCount;		// of the whole subtree
+		uint32_t leftChild;		// the right child follows it; 0 for a leaf, since the root is nobody's child
+
+		bool IsLeaf() const { return leftChild == 0; }
+	};
+
+	// Reorders tree positions [first, first + count) and returns how many go to the left child; 0 when no plane separates them
+	uint32_t Partition( uint32_t first, uint32_t count, const glm::vec3& centerMin, const glm::vec3& centerMax );
+	void SplitAtMedian( uint32_t first, uint32_t count, uint32_t leftCount, int axis );
+	void RefitLeaf( uint32_t nodeIndex, const glm::vec4* pSpheres );
+	void RefitInternal( uint32_t nodeIndex );
+	float SumNodeAreas() const;
+
+	std::vector<Node> Nodes;
+	std::vector<uint32_t> NodeParents;
+	std::vector<glm::vec4> Spheres;			// by tree position
+	std::vector<uint32_t> ItemOrder;		// item at each tree position
+	std::vector<uint32_t> ItemLeaves;		// leaf node holding each item
+
+	std::vector<uint32_t> DirtyNodes;		// queued for Refit
+	std::vector<uint8_t> NodeDirtyFlags;
+
+	float NodeAreaSum = 0.0f;				// over every node, maintained by Refit
+	float BuiltNodeAreaRatio = 0.0f;		// NodeAreaSum / root area right after Build
+};
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "DepthPyramid.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+#include "ShaderClass.h"
+#include "VulkanGraphicsInstance.h"
+
+namespace
+{
+	constexpr uint32_t REDUCE_GROUP_SIZE = 8;	// local_size_x and local_size_y of both reduce shaders
+
+	uint32_t PreviousPowerOfTwo( uint32_t value )
+	{
+		uint32_t result = 1;
+		while ( result * 2 <= value )
+		{
+			result *= 2;
+		}
+
+		return result;
+	}
+
+	VkPipeline CreateReducePipeline( VulkanGraphicsInstance* pInstance, VkPipelineLayout layout, const char* shaderName )
+	{
+		VulkanComputeShader reduceShader( pInstance, shaderName );
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = reduceShader.GetCreateInfo();
+		pipelineInfo.layout = layout;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		VkPipeline pipeline;
+		VkResult result = vkCreateComputePipelines( *pInstance->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline );
+		assert( VK_SUCCESS == result && "failed to create depth reduce pipeline!" );
+
+		return pipeline;
+	}
+}
+
+bool DepthPyramid::IsSupported( VkPhysicalDevice device, VkSampleCountFlagBits samples )
+{
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties( device, &deviceProperties );
+
+	return ( deviceProperties.limits.sampledImageDepthSampleCounts & samples ) != 0;
+}
+
+void DepthPyramid::Init( VulkanGraphicsInstance* pInstance, DescriptorLayoutCache& layoutCache, PipelineLayoutCache& pipelineLayoutCache, VkSampleCountFlagBits depthSamples )
+{
+	pGraphicsInstance = pInstance;
+	device = *pInstance->GetDevice();
+
+	// Binding 0 is the level read, binding 1 the level written
+	VkDescriptorSetLayoutBinding sourceBinding = {};
+	sourceBinding.binding = 0;
+	sourceBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	sourceBinding.descriptorCount = 1;
+	sourceBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	sourceBinding.pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutBinding destinationBinding = {};
+	destinationBinding.binding = 1;
+	destinationBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	destinationBinding.descriptorCount = 1;
+	destinationBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	destinationBinding.pImmutableSamplers = nullptr;
+
+	setLayout = layoutCache.GetLayout( { sourceBinding, destinationBinding } );
+	pipelineLayout = pipelineLayoutCache.GetLayout( { setLayout }, {} );
+
+	reducePipeline = CreateReducePipeline( pInstance, pipelineLayout, "shaders/depthReduce.spv" );
+
+	if ( depthSamples != VK_SAMPLE_COUNT_1_BIT )
+	{
+		resolvePipeline = CreateReducePipeline( pInstance, pipelineLayout, "shaders/depthReduceMS.spv" );
+	}
+
+	// Texels are only ever fetched whole, from the level asked for; every depth is kept as it is
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.mipLodBias = 0.0f;
+
+	sampler = pInstance->GetSamplerCache().Acquire( samplerInfo );
+
+	// One set per level; a 16k depth buffer has 15
+	descriptorAllocator.Init( device, 16, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f }, { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f } } );
+}
+
+void DepthPyramid::Cleanup()
+{
+	Destroy();
+
+	// The layouts belong to the caches
+	vkDestroyPipeline( device, reducePipeline, nullptr );
+	reducePipeline = VK_NULL_HANDLE;
+
+	if ( resolvePipeline != VK_NULL_HANDLE )
+	{
+		vkDestroyPipeline( device, resolvePipeline, nullptr );
+		resolvePipeline = VK_NULL_HANDLE;
+	}
+
+	pGraphicsInstance->GetSamplerCache().Release( sampler );
+	sampler = VK_NULL_HANDLE;
+
+	descriptorAllocator.Cleanup();
+}
+
+void DepthPyramid::Create( VkImageView depthView, VkExtent2D depthExtent )
+{
+	// Power of two levels halve exactly, so each texel of a level covers exactly 2x2 of the one before
+	extent.width = PreviousPowerOfTwo( depthExtent.width );
+	extent.height = PreviousPowerOfTwo( depthExtent.height );
+
+	levelCount = 1;
+	while ( ( std::max( extent.width, extent.height ) >> levelCount ) > 0 )
+	{
+		++levelCount;
+	}
+
+	pGraphicsInstance->CreateImage( extent.width, extent.height, levelCount, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pyramidImage, pyramidMemory );
+	pyramidView = pGraphicsInstance->CreateImageView( pyramidImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, levelCount );
+
+	LevelViews.resize( levelCount );
+	for ( uint32_t level = 0; level < levelCount; ++level )
+	{
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = pyramidImage;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = level;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkResult result = vkCreateImageView( device, &viewInfo, nullptr, &LevelViews[level] );
+		assert( VK_SUCCESS == result && "failed to create depth pyramid level view!" );
+	}
+
+	LevelSets.resize( levelCount );
+	for ( uint32_t level = 0; level < levelCount; ++level )
+	{
+		LevelSets[level] = descriptorAllocator.Allocate( setLayout );
+
+		VkDescriptorImageInfo sourceInfo = {};
+		sourceInfo.sampler = sampler;
+		sourceInfo.imageView = level == 0 ? depthView : LevelViews[level - 1];
+		sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo destinationInfo = {};
+		destinationInfo.imageView = LevelViews[level];
+		destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = LevelSets[level];
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pImageInfo = &sourceInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = LevelSets[level];
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &destinationInfo;
+
+		vkUpdateDescriptorSets( device, static_cast< uint32_t >( descriptorWrites.size() ), descriptorWrites.data(), 0, nullptr );
+	}
+}
+
+void DepthPyramid::Destroy()
+{
+	if ( pyramidImage == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	for ( VkImageView view : LevelViews )
+	{
+		vkDestroyImageView( device, view, nullptr );
+	}
+	LevelViews.clear();
+
+	vkDestroyImageView( device, pyramidView, nullptr );
+	vkDestroyImage( device, pyramidImage, nullptr );
+	vkFreeMemory( device, pyramidMemory, nullptr );
+
+	pyramidImage = VK_NULL_HANDLE;
+	pyramidView = VK_NULL_HANDLE;
+
+	// Only ever called with the device idle, so nothing still uses the sets
+	LevelSets.clear();
+	descriptorAllocator.ResetPools();
+
+	extent = {};
+	levelCount = 0;
+}
+
+void DepthPyramid::RecordBuild( VkCommandBuffer commandBuffer )
+{
+	// The last build is only read by compute shaders, earlier in the queue; its contents go
+	VkImageMemoryBarrier discardBarrier = {};
+	discardBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	discardBarrier.srcAccessMask = 0;
+	discardBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	discardBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	discardBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	discardBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	discardBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	discardBarrier.image = pyramidImage;
+	discardBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	discardBarrier.subresourceRange.baseMipLevel = 0;
+	discardBarrier.subresourceRange.levelCount = levelCount;
+	discardBarrier.subresourceRange.baseArrayLayer = 0;
+	discardBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &discardBarrier );
+
+	VkImageMemoryBarrier levelBarrier = discardBarrier;
+	levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	levelBarrier.subresourceRange.levelCount = 1;
+
+	for ( uint32_t level = 0; level < levelCount; ++level )
+	{
+		const uint32_t levelWidth = std::max( extent.width >> level, 1u );
+		const uint32_t levelHeight = std::max( extent.height >> level, 1u );
+
+		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, level == 0 && resolvePipeline != VK_NULL_HANDLE ? resolvePipeline : reducePipeline );
+		vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &LevelSets[level], 0, nullptr );
+		vkCmdDispatch( commandBuffer, ( levelWidth + REDUCE_GROUP_SIZE - 1 ) / REDUCE_GROUP_SIZE, ( levelHeight + REDUCE_GROUP_SIZE - 1 ) / REDUCE_GROUP_SIZE, 1 );
+
+		// Read by the next level, and by the cull shader once the last one is done
+		levelBarrier.subresourceRange.baseMipLevel = level;
+		vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &levelBarrier );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "DescriptorAllocator.h"
+#include "LayoutCache.h"
+
+class VulkanGraphicsInstance;
+
+// Hierarchical depth (Hi-Z) for GPUCuller's occlusion test: an R32_SFLOAT mip chain in which every
+// texel holds the farthest depth of the screen region it covers, so an object whose nearest depth is
+// behind every texel its screen rectangle touches can't be visible.
+//
+// Level 0 is the depth buffer's extent rounded down to powers of two, and each of its texels takes the
+// maximum over every depth sample it overlaps (depthReduceMS.comp reads each sample of a multisampled
+// depth buffer); every further level is the 2x2 maximum of the one before (depthReduce.comp). The whole
+// chain is rebuilt with one dispatch per level, from the depth buffer as it is when RecordBuild is recorded.
+//
+// The image follows the swapchain: Create with the depth resources, Destroy in CleanupSwapChain.
+class DepthPyramid
+{
+public:
+	void Init( VulkanGraphicsInstance* pInstance, DescriptorLayoutCache& layoutCache, PipelineLayoutCache& pipelineLayoutCache, VkSampleCountFlagBits depthSamples );
+	void Cleanup();
+
+	// depthView is sampled in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, its depth aspect only
+	void Create( VkImageView depthView, VkExtent2D depthExtent );
+	void Destroy();
+
+	// Outside a render pass, once the depth writes it should see are available to compute shaders.
+	// Leaves the pyramid in VK_IMAGE_LAYOUT_GENERAL, readable by compute shaders.
+	void RecordBuild( VkCommandBuffer commandBuffer );
+
+	// Every level, for textureLod; with GetSampler, which never filters between texels or levels
+	VkImageView GetView() const { return pyramidView; }
+	VkSampler GetSampler() const { return sampler; }
+	VkExtent2D GetExtent() const { return extent; }
+	uint32_t GetLevelCount() const { return levelCount; }
+
+	// Whether the device can sample depth buffers with this many samples, as the reduce shaders do
+	static bool IsSupported( VkPhysicalDevice device, VkSampleCountFlagBits samples );
+
+private:
+	VulkanGraphicsInstance* pGraphicsInstance = nullptr;
+	VkDevice device = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;	// owned by the DescriptorLayoutCache
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;	// owned by the PipelineLayoutCache
+	VkPipeline reducePipeline = VK_NULL_HANDLE;
+	VkPipeline resolvePipeline = VK_NULL_HANDLE;		// level 0 from a multisampled depth buffer, else reducePipeline
+	VkSampler sampler = VK_NULL_HANDLE;					// from the SamplerCache
+	DescriptorAllocator descriptorAllocator;
+
+	VkImage pyramidImage = VK_NULL_HANDLE;
+	VkDeviceMemory pyramidMemory = VK_NULL_HANDLE;
+	VkImageView pyramidView = VK_NULL_HANDLE;
+	std::vector<VkImageView> LevelViews;
+	std::vector<VkDescriptorSet> LevelSets;	// level 0 reads the depth buffer, every other level the one before
+
+	VkExtent2D extent = {};
+	uint32_t levelCount = 0;
+};
\ No newline at end of file
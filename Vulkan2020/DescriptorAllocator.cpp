@@ -0,0 +1,144 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+void DescriptorAllocator::Init( VkDevice vulkanDevice, uint32_t initialSetsPerPool, const std::vector<PoolSizeRatio>& poolRatios, VkDescriptorPoolCreateFlags flags )
+{
+	device = vulkanDevice;
+	poolFlags = flags;
+	ratios = poolRatios;
+	setsPerPool = initialSetsPerPool;
+}
+
+void DescriptorAllocator::Cleanup()
+{
+	for ( VkDescriptorPool pool : usedPools )
+	{
+		vkDestroyDescriptorPool( device, pool, nullptr );
+	}
+
+	for ( VkDescriptorPool pool : freePools )
+	{
+		vkDestroyDescriptorPool( device, pool, nullptr );
+	}
+
+	usedPools.clear();
+	freePools.clear();
+	currentPool = VK_NULL_HANDLE;
+	setsAllocated = 0;
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate( VkDescriptorSetLayout layout )
+{
+	std::vector<VkDescriptorSet> sets;
+	Allocate( { layout }, sets );
+
+	return sets[0];
+}
+
+void DescriptorAllocator::Allocate( const std::vector<VkDescriptorSetLayout>& layouts, std::vector<VkDescriptorSet>& sets )
+{
+	if ( currentPool == VK_NULL_HANDLE )
+	{
+		currentPool = GrabPool();
+	}
+
+	sets.resize( layouts.size() );
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = currentPool;
+	allocInfo.descriptorSetCount = static_cast< uint32_t >( layouts.size() );
+	allocInfo.pSetLayouts = layouts.data();
+
+	VkResult result = vkAllocateDescriptorSets( device, &allocInfo, sets.data() );
+
+	if ( result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL )
+	{
+		// Current pool is full, chain a new one and retry once
+		currentPool = GrabPool();
+		allocInfo.descriptorPool = currentPool;
+
+		result = vkAllocateDescriptorSets( device, &allocInfo, sets.data() );
+	}
+
+	assert( VK_SUCCESS == result && "failed to allocate descriptor sets!" );
+
+	setsAllocated += static_cast< uint32_t >( layouts.size() );
+}
+
+void DescriptorAllocator::ResetPools()
+{
+	for ( VkDescriptorPool pool : usedPools )
+	{
+		vkResetDescriptorPool( device, pool, 0 );
+		freePools.push_back( pool );
+	}
+
+	usedPools.clear();
+	currentPool = VK_NULL_HANDLE;
+	setsAllocated = 0;
+}
+
+DescriptorAllocator::Statistics DescriptorAllocator::GetStatistics() const
+{
+	Statistics stats;
+	stats.setsAllocated = setsAllocated;
+	stats.poolsInUse = static_cast< uint32_t >( usedPools.size() );
+	stats.poolsFree = static_cast< uint32_t >( freePools.size() );
+	stats.poolsCreated = poolsCreated;
+
+	return stats;
+}
+
+VkDescriptorPool DescriptorAllocator::GrabPool()
+{
+	VkDescriptorPool pool;
+
+	if ( !freePools.empty() )
+	{
+		pool = freePools.back();
+		freePools.pop_back();
+	}
+	else
+	{
+		pool = CreatePool( setsPerPool );
+
+		// Each new pool in the chain is bigger, so large scenes settle on a handful of pools
+		setsPerPool = std::min( setsPerPool + setsPerPool / 2, MAX_SETS_PER_POOL );
+	}
+
+	usedPools.push_back( pool );
+
+	return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool( uint32_t setCount )
+{
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	poolSizes.reserve( ratios.size() );
+
+	for ( const PoolSizeRatio& ratio : ratios )
+	{
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = ratio.type;
+		poolSize.descriptorCount = std::max( 1u, static_cast< uint32_t >( ratio.ratio * setCount ) );
+		poolSizes.push_back( poolSize );
+	}
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = poolFlags;
+	poolInfo.poolSizeCount = static_cast< uint32_t >( poolSizes.size() );
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = setCount;
+
+	VkDescriptorPool pool;
+	VkResult result = vkCreateDescriptorPool( device, &poolInfo, nullptr, &pool );
+	assert( VK_SUCCESS == result && "failed to create descriptor pool!" );
+
+	++poolsCreated;
+
+	return pool;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+// Hands out descriptor sets from a chain of pools. When the current pool is exhausted a new
+// one is grabbed (recycled or created, each larger than the last), so callers never see
+// VK_ERROR_OUT_OF_POOL_MEMORY. Sets are never freed individually; ResetPools returns every
+// pool to the free list at once.
+class DescriptorAllocator
+{
+public:
+	struct PoolSizeRatio
+	{
+		VkDescriptorType type;
+		float ratio; // descriptors of this type per set
+	};
+
+	struct Statistics
+	{
+		uint32_t setsAllocated = 0;	// since the last ResetPools
+		uint32_t poolsInUse = 0;
+		uint32_t poolsFree = 0;
+		uint32_t poolsCreated = 0;	// lifetime total
+	};
+
+	void Init( VkDevice device, uint32_t initialSetsPerPool, const std::vector<PoolSizeRatio>& poolRatios, VkDescriptorPoolCreateFlags flags = 0 );
+	void Cleanup();
+
+	VkDescriptorSet Allocate( VkDescriptorSetLayout layout );
+	void Allocate( const std::vector<VkDescriptorSetLayout>& layouts, std::vector<VkDescriptorSet>& sets );
+
+	void ResetPools();
+
+	Statistics GetStatistics() const;
+
+private:
+	VkDescriptorPool GrabPool();
+	VkDescriptorPool CreatePool( uint32_t setCount );
+
+	static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkDescriptorPoolCreateFlags poolFlags = 0;
+	std::vector<PoolSizeRatio> ratios;
+	uint32_t setsPerPool = 0;
+
+	VkDescriptorPool currentPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorPool> usedPools;
+	std::vector<VkDescriptorPool> freePools;
+
+	uint32_t setsAllocated = 0;
+	uint32_t poolsCreated = 0;
+};
\ No newline at end of file
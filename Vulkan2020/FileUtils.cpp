@@ -1,14 +1,115 @@
 #include "FileUtils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <streambuf>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+// DecodeTextureInto points stb_image at caller-owned memory (usually a mapped staging buffer):
+// the first allocation of exactly the decoded size is served from there, so the common JPEG
+// and PNG paths decode in place. Anything else falls through to the heap.
+struct DecodeTarget
+{
+	void* pMemory = nullptr;
+	size_t size = 0;
+	bool bTaken = false;
+};
+
+static thread_local DecodeTarget decodeTarget;
+
+static void* DecodeMalloc( size_t size )
+{
+	if ( decodeTarget.pMemory != nullptr && !decodeTarget.bTaken && size == decodeTarget.size )
+	{
+		decodeTarget.bTaken = true;
+		return decodeTarget.pMemory;
+	}
+
+	return malloc( size );
+}
+
+static void* DecodeRealloc( void* pMemory, size_t size )
+{
+	if ( pMemory != nullptr && pMemory == decodeTarget.pMemory )
+	{
+		// The target can't grow; move its contents to the heap
+		void* pMoved = malloc( size );
+		if ( pMoved != nullptr )
+		{
+			memcpy( pMoved, pMemory, std::min( size, decodeTarget.size ) );
+		}
+
+		return pMoved;
+	}
+
+	return realloc( pMemory, size );
+}
+
+static void DecodeFree( void* pMemory )
+{
+	if ( pMemory != nullptr && pMemory == decodeTarget.pMemory )
+	{
+		return;
+	}
+
+	free( pMemory );
+}
+
+#define STBI_MALLOC( size ) DecodeMalloc( size )
+#define STBI_REALLOC( pMemory, size ) DecodeRealloc( pMemory, size )
+#define STBI_FREE( pMemory ) DecodeFree( pMemory )
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// Lets stream based parsers (tinyobjloader) read a mapped file in place
+struct MemoryStreamBuffer : public std::streambuf
+{
+	MemoryStreamBuffer( const uint8_t* pData, size_t size )
+	{
+		char* pBegin = const_cast< char* >( reinterpret_cast< const char* >( pData ) );
+		setg( pBegin, pBegin, pBegin + size );
+	}
+};
+
+// tinyobjloader's MaterialFileReader opens loose files; this one resolves .mtl files through the archives too
+class VirtualMaterialReader : public tinyobj::MaterialReader
+{
+public:
+	explicit VirtualMaterialReader( const std::string& baseDir )
+		: BaseDir( baseDir )
+	{}
+
+	virtual bool operator()( const std::string& matId, std::vector<tinyobj::material_t>* materials, std::map<std::string, int>* matMap, std::string* warn, std::string* err ) override
+	{
+		FileView file;
+		if ( !VirtualFileSystem::Open( BaseDir + matId, file ) )
+		{
+			if ( warn != nullptr )
+			{
+				*warn += "Material file [ " + BaseDir + matId + " ] not found.\n";
+			}
+
+			return false;
+		}
+
+		MemoryStreamBuffer streamBuffer( file.GetData(), file.GetSize() );
+		std::istream stream( &streamBuffer );
+
+		tinyobj::LoadMtl( matMap, materials, &stream, warn, err );
+
+		return true;
+	}
+
+private:
+	std::string BaseDir;
+};
+
 static std::string GetBaseDir( const std::string& filepath )
 {
 	if ( filepath.find_last_of( "/\\" ) != std::string::npos )
@@ -16,26 +117,43 @@ static std::string GetBaseDir( const std::string& filepath )
 	return "";
 }
 
-std::vector<char> FileUtils::ReadFile( const std::string& filename )
+static VMeshBounds ToFileBounds( const MeshBounds& bounds )
 {
-	std::ifstream file( filename, std::ios::ate | std::ios::binary );
+	return VMeshBounds{
+		{ bounds.min.x, bounds.min.y, bounds.min.z },
+		{ bounds.max.x, bounds.max.y, bounds.max.z },
+		{ bounds.center.x, bounds.center.y, bounds.center.z },
+		bounds.radius
+	};
+}
 
-	assert( file.is_open() && "failed to open file!" );
+static MeshBounds FromFileBounds( const VMeshBounds& fileBounds )
+{
+	MeshBounds bounds;
+	bounds.min = glm::vec3( fileBounds.min[0], fileBounds.min[1], fileBounds.min[2] );
+	bounds.max = glm::vec3( fileBounds.max[0], fileBounds.max[1], fileBounds.max[2] );
+	bounds.center = glm::vec3( fileBounds.center[0], fileBounds.center[1], fileBounds.center[2] );
+	bounds.radius = fileBounds.radius;
 
-	size_t fileSize = ( size_t )file.tellg();
-	std::vector<char> buffer( fileSize );
+	return bounds;
+}
 
-	file.seekg( 0 );
-	file.read( buffer.data(), fileSize );
+std::vector<char> FileUtils::ReadFile( const std::string& filename )
+{
+	FileView file;
+	VirtualFileSystem::Open( filename, file );
 
-	file.close();
+	assert( file.IsOpen() && "failed to open file!" );
 
-	return buffer;
+	return std::vector<char>( file.GetData(), file.GetData() + file.GetSize() );
 }
 
 void* FileUtils::OpenTexture( const char* filename, int& texWidth, int& texHeight, int& texChannels )
 {
-	stbi_uc* pixels = stbi_load( ( std::string( TEXTURE_PATH ) + filename ).c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha );
+	FileView file;
+	VirtualFileSystem::Open( std::string( TEXTURE_PATH ) + filename, file );
+
+	stbi_uc* pixels = file.IsOpen() ? stbi_load_from_memory( file.GetData(), static_cast< int >( file.GetSize() ), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha ) : nullptr;
 
 	assert( pixels && "failed to load texture image!" );
 
@@ -47,24 +165,373 @@ void FileUtils::CloseTexture( void* pData )
 	stbi_image_free( pData );
 }
 
-void FileUtils::LoadModel( const char* filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices )
+bool FileUtils::ReadTextureInfo( const uint8_t* pFileData, size_t fileSize, uint32_t& texWidth, uint32_t& texHeight )
+{
+	int width;
+	int height;
+	int channels;
+
+	if ( pFileData == nullptr || !stbi_info_from_memory( pFileData, static_cast< int >( fileSize ), &width, &height, &channels ) )
+	{
+		return false;
+	}
+
+	texWidth = static_cast< uint32_t >( width );
+	texHeight = static_cast< uint32_t >( height );
+
+	return true;
+}
+
+bool FileUtils::DecodeTextureInto( const uint8_t* pFileData, size_t fileSize, void* pDestination, size_t destinationSize )
+{
+	decodeTarget.pMemory = pDestination;
+	decodeTarget.size = destinationSize;
+	decodeTarget.bTaken = false;
+
+	int width;
+	int height;
+	int channels;
+	stbi_uc* pixels = pFileData != nullptr ? stbi_load_from_memory( pFileData, static_cast< int >( fileSize ), &width, &height, &channels, STBI_rgb_alpha ) : nullptr;
+
+	bool bSuccess = pixels != nullptr && static_cast< size_t >( width ) * height * 4 == destinationSize;
+
+	// stb finished in a heap buffer (format conversion, 16 bit source, ...): one copy into place
+	if ( bSuccess && pixels != pDestination )
+	{
+		memcpy( pDestination, pixels, destinationSize );
+	}
+
+	if ( pixels != nullptr && pixels != pDestination )
+	{
+		stbi_image_free( pixels );
+	}
+
+	decodeTarget = DecodeTarget();
+
+	return bSuccess;
+}
+
+bool FileUtils::HashFileContents( const std::string& filename, uint64_t& hash )
+{
+	FileView file;
+	if ( !VirtualFileSystem::Open( filename, file ) )
+	{
+		return false;
+	}
+
+	// 64 bit FNV-1a
+	hash = 14695981039346656037ull;
+
+	for ( size_t i = 0; i < file.GetSize(); ++i )
+	{
+		hash = ( hash ^ file.GetData()[i] ) * 1099511628211ull;
+	}
+
+	return true;
+}
+
+bool FileUtils::FileExists( const std::string& filename )
+{
+	return VirtualFileSystem::Exists( filename );
+}
+
+bool FileUtils::LoadKTX( const char* filename, TextureData& textureData )
+{
+	// KTX 1.1: 12 byte identifier, 13 uint32 header fields, key/value data, then per mip a uint32 size followed by the level
+	static const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const uint32_t KTX_ENDIAN_REF = 0x04030201;
+
+	struct KTXHeader
+	{
+		uint8_t identifier[12];
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+
+	// Mapped rather than read, so the levels are copied once, from the page cache into textureData
+	FileView file;
+	if ( !VirtualFileSystem::Open( std::string( TEXTURE_PATH ) + filename, file ) || file.GetSize() < sizeof( KTXHeader ) )
+	{
+		return false;
+	}
+
+	KTXHeader header;
+	memcpy( &header, file.GetData(), sizeof( KTXHeader ) );
+
+	if ( memcmp( header.identifier, KTX_IDENTIFIER, sizeof( KTX_IDENTIFIER ) ) != 0 || header.endianness != KTX_ENDIAN_REF )
+	{
+		return false;
+	}
+
+	// Only plain 2D textures; arrays, cubemaps and volumes go through other paths
+	if ( header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1 )
+	{
+		return false;
+	}
+
+	textureData.format = TextureFormats::FromGLInternalFormat( header.glInternalFormat );
+	if ( textureData.format == VK_FORMAT_UNDEFINED )
+	{
+		return false;
+	}
+
+	textureData.width = header.pixelWidth;
+	textureData.height = header.pixelHeight;
+
+	uint32_t levelCount = std::max( header.numberOfMipmapLevels, 1u );
+	size_t readOffset = sizeof( KTXHeader ) + header.bytesOfKeyValueData;
+
+	textureData.mips.clear();
+	textureData.data.clear();
+	textureData.data.reserve( file.GetSize() - readOffset );
+
+	for ( uint32_t level = 0; level < levelCount; ++level )
+	{
+		if ( readOffset + sizeof( uint32_t ) > file.GetSize() )
+		{
+			return false;
+		}
+
+		uint32_t imageSize;
+		memcpy( &imageSize, file.GetData() + readOffset, sizeof( uint32_t ) );
+		readOffset += sizeof( uint32_t );
+
+		TextureMipLevel mip;
+		mip.width = std::max( textureData.width >> level, 1u );
+		mip.height = std::max( textureData.height >> level, 1u );
+		mip.offset = textureData.data.size();
+		mip.size = imageSize;
+
+		if ( imageSize != TextureFormats::GetLevelSize( textureData.format, mip.width, mip.height ) || readOffset + imageSize > file.GetSize() )
+		{
+			return false;
+		}
+
+		textureData.data.insert( textureData.data.end(), file.GetData() + readOffset, file.GetData() + readOffset + imageSize );
+		textureData.mips.push_back( mip );
+
+		// mipPadding: levels start on 4 byte boundaries
+		readOffset += ( imageSize + 3 ) & ~size_t( 3 );
+	}
+
+	return true;
+}
+
+bool FileUtils::LoadCookedTexture( const char* filename, TextureData& textureData )
+{
+	std::string path = std::string( TEXTURE_PATH ) + filename;
+
+	VTexHeader header;
+	std::vector<VTexLevel> levels;
+	if ( !ReadCookedTextureIndex( path, header, levels ) )
+	{
+		return false;
+	}
+
+	textureData.format = static_cast< VkFormat >( header.vkFormat );
+	textureData.width = header.pixelWidth;
+	textureData.height = header.pixelHeight;
+	textureData.mips.clear();
+
+	for ( uint32_t level = 0; level < header.levelCount; ++level )
+	{
+		TextureMipLevel mip;
+		mip.width = std::max( header.pixelWidth >> level, 1u );
+		mip.height = std::max( header.pixelHeight >> level, 1u );
+		mip.offset = static_cast< size_t >( levels[level].byteOffset - header.levelDataOffset );
+		mip.size = static_cast< size_t >( levels[level].byteLength );
+
+		textureData.mips.push_back( mip );
+	}
+
+	// Level data is stored in upload layout, so it is read in one go and the mip offsets index straight into it
+	const VTexLevel& largest = levels[0];
+	return ReadFileRange( path, header.levelDataOffset, largest.byteOffset + largest.byteLength - header.levelDataOffset, textureData.data );
+}
+
+bool FileUtils::ReadCookedTextureIndex( const std::string& path, VTexHeader& header, std::vector<VTexLevel>& levels )
+{
+	// Only the header and level index are touched; the levels themselves stay unread
+	FileView file;
+	if ( !VirtualFileSystem::OpenUncompressed( path, file ) || file.GetSize() < sizeof( VTexHeader ) )
+	{
+		return false;
+	}
+
+	uint64_t fileSize = file.GetSize();
+	memcpy( &header, file.GetData(), sizeof( VTexHeader ) );
+
+	if ( memcmp( header.identifier, VTEX_IDENTIFIER, sizeof( VTEX_IDENTIFIER ) ) != 0 || header.version != VTEX_VERSION || header.levelCount == 0 )
+	{
+		return false;
+	}
+
+	if ( header.levelCount > ( fileSize - sizeof( VTexHeader ) ) / sizeof( VTexLevel ) || header.levelDataOffset > fileSize )
+	{
+		return false;
+	}
+
+	levels.resize( header.levelCount );
+	memcpy( levels.data(), file.GetData() + sizeof( VTexHeader ), levels.size() * sizeof( VTexLevel ) );
+
+	VkFormat format = static_cast< VkFormat >( header.vkFormat );
+
+	// Levels must be packed smallest first, which is what lets callers read any tail of the chain with one read
+	for ( uint32_t level = 0; level < header.levelCount; ++level )
+	{
+		uint32_t width = std::max( header.pixelWidth >> level, 1u );
+		uint32_t height = std::max( header.pixelHeight >> level, 1u );
+
+		if ( levels[level].byteOffset < header.levelDataOffset || levels[level].byteOffset + levels[level].byteLength > fileSize ||
+			levels[level].byteLength != TextureFormats::GetLevelSize( format, width, height ) ||
+			( level > 0 && levels[level].byteOffset >= levels[level - 1].byteOffset ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FileUtils::ReadFileRange( const std::string& path, uint64_t offset, uint64_t size, std::vector<uint8_t>& data )
+{
+	// Streamed reads pick a few levels out of a large container, so skip read-ahead and fetch just the range
+	FileView file;
+	if ( !VirtualFileSystem::OpenUncompressed( path, file ) || offset + size > file.GetSize() )
+	{
+		return false;
+	}
+
+	file.Prefetch( static_cast< size_t >( offset ), static_cast< size_t >( size ) );
+	data.assign( file.GetData() + offset, file.GetData() + offset + size );
+
+	return true;
+}
+
+bool FileUtils::WriteCookedTexture( const std::string& path, const TextureData& textureData )
+{
+	const uint32_t levelCount = static_cast< uint32_t >( textureData.mips.size() );
+	auto align = []( uint64_t offset ) { return ( offset + VTEX_LEVEL_ALIGNMENT - 1 ) & ~uint64_t( VTEX_LEVEL_ALIGNMENT - 1 ); };
+
+	VTexHeader header = {};
+	memcpy( header.identifier, VTEX_IDENTIFIER, sizeof( VTEX_IDENTIFIER ) );
+	header.version = VTEX_VERSION;
+	header.vkFormat = static_cast< uint32_t >( textureData.format );
+	header.pixelWidth = textureData.width;
+	header.pixelHeight = textureData.height;
+	header.levelCount = levelCount;
+	header.levelDataOffset = static_cast< uint32_t >( align( sizeof( VTexHeader ) + levelCount * sizeof( VTexLevel ) ) );
+
+	// Like KTX2 the smallest mip goes first, so a partial read of the file yields a usable low res chain
+	std::vector<VTexLevel> levels( levelCount );
+	uint64_t offset = header.levelDataOffset;
+
+	for ( uint32_t level = levelCount; level-- > 0; )
+	{
+		levels[level].byteOffset = offset;
+		levels[level].byteLength = textureData.mips[level].size;
+		offset = align( offset + levels[level].byteLength );
+	}
+
+	std::vector<uint8_t> fileData( static_cast< size_t >( offset ), 0 );
+	memcpy( fileData.data(), &header, sizeof( VTexHeader ) );
+	memcpy( fileData.data() + sizeof( VTexHeader ), levels.data(), levels.size() * sizeof( VTexLevel ) );
+
+	for ( uint32_t level = 0; level < levelCount; ++level )
+	{
+		const TextureMipLevel& mip = textureData.mips[level];
+		memcpy( fileData.data() + levels[level].byteOffset, textureData.data.data() + mip.offset, mip.size );
+	}
+
+	std::ofstream file( path, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		return false;
+	}
+
+	file.write( reinterpret_cast< const char* >( fileData.data() ), fileData.size() );
+
+	return file.good();
+}
+
+MeshBounds FileUtils::ComputeBounds( const std::vector<Vertex>& vertices, const uint32_t* pIndices, size_t indexCount )
+{
+	MeshBounds bounds;
+
+	if ( indexCount == 0 )
+	{
+		return bounds;
+	}
+
+	bounds.min = bounds.max = vertices[pIndices[0]].pos;
+
+	for ( size_t i = 1; i < indexCount; ++i )
+	{
+		bounds.min = glm::min( bounds.min, vertices[pIndices[i]].pos );
+		bounds.max = glm::max( bounds.max, vertices[pIndices[i]].pos );
+	}
+
+	// Not the minimal sphere, but a tighter one than the box's own corners give
+	bounds.center = ( bounds.min + bounds.max ) * 0.5f;
+
+	float radiusSquared = 0.0f;
+
+	for ( size_t i = 0; i < indexCount; ++i )
+	{
+		glm::vec3 offset = vertices[pIndices[i]].pos - bounds.center;
+		radiusSquared = std::max( radiusSquared, glm::dot( offset, offset ) );
+	}
+
+	bounds.radius = std::sqrt( radiusSquared );
+
+	return bounds;
+}
+
+void FileUtils::LoadModel( const char* filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>* pSubmeshes, MeshBounds* pBounds )
 {
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
 	std::string warn, err;
 
-	if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, filename, GetBaseDir( filename ).c_str() ) )
+	// Parse straight out of the mapping or archive; .mtl files resolve against the model's directory as LoadObj( filename ) would
+	FileView file;
+	if ( !VirtualFileSystem::Open( filename, file ) )
+	{
+		throw std::runtime_error( std::string( "failed to open " ) + filename );
+	}
+
+	MemoryStreamBuffer streamBuffer( file.GetData(), file.GetSize() );
+	std::istream stream( &streamBuffer );
+
+	std::string baseDir = GetBaseDir( filename );
+	VirtualMaterialReader materialReader( baseDir.empty() ? baseDir : baseDir + "/" );
+
+	if ( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, &stream, &materialReader ) )
 	{
 		throw std::runtime_error( warn + err );
 	}
 
 	std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
 
+	const size_t firstModelIndex = indices.size();
+
 	for ( const auto& shape : shapes )
 	{
 		size_t faceIndex = 0;
 		size_t vertCt = 0;
+		const size_t firstShapeIndex = indices.size();
 
 		for ( const auto& index : shape.mesh.indices )
 		{
@@ -128,5 +595,180 @@ void FileUtils::LoadModel( const char* filename, std::vector<Vertex>& vertices,
 				vertCt = 0;
 			}
 		}
+
+		if ( pSubmeshes != nullptr && indices.size() > firstShapeIndex )
+		{
+			Submesh submesh;
+			submesh.firstIndex = static_cast< uint32_t >( firstShapeIndex );
+			submesh.indexCount = static_cast< uint32_t >( indices.size() - firstShapeIndex );
+			submesh.bounds = ComputeBounds( vertices, indices.data() + firstShapeIndex, submesh.indexCount );
+			pSubmeshes->push_back( submesh );
+		}
+	}
+
+	if ( pBounds != nullptr )
+	{
+		*pBounds = ComputeBounds( vertices, indices.data() + firstModelIndex, indices.size() - firstModelIndex );
 	}
+}
+
+bool FileUtils::LoadMeshCache( const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>& submeshes, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets, MeshBounds& bounds )
+{
+	FileView file;
+	if ( !VirtualFileSystem::Open( path, file ) || file.GetSize() < sizeof( VMeshHeader ) )
+	{
+		return false;
+	}
+
+	VMeshHeader header;
+	memcpy( &header, file.GetData(), sizeof( VMeshHeader ) );
+
+	if ( memcmp( header.identifier, VMESH_IDENTIFIER, sizeof( VMESH_IDENTIFIER ) ) != 0 || header.version != VMESH_VERSION || header.vertexStride != sizeof( Vertex ) )
+	{
+		return false;
+	}
+
+	if ( header.lodCount > MAX_MESH_LODS )
+	{
+		return false;
+	}
+
+	const size_t submeshBytes = static_cast< size_t >( header.submeshCount ) * sizeof( VMeshSubmesh );
+	const size_t lodBytes = static_cast< size_t >( header.lodCount ) * sizeof( VMeshLod );
+	const size_t meshletBytes = static_cast< size_t >( header.meshletCount ) * sizeof( VMeshMeshlet );
+	const size_t vertexBytes = static_cast< size_t >( header.vertexCount ) * sizeof( Vertex );
+	const size_t indexBytes = static_cast< size_t >( header.indexCount ) * sizeof( uint32_t );
+
+	if ( file.GetSize() < sizeof( VMeshHeader ) + submeshBytes + lodBytes + meshletBytes + vertexBytes + indexBytes )
+	{
+		return false;
+	}
+
+	const uint8_t* pData = file.GetData() + sizeof( VMeshHeader );
+
+	submeshes.resize( header.submeshCount );
+
+	for ( uint32_t i = 0; i < header.submeshCount; ++i )
+	{
+		VMeshSubmesh record;
+		memcpy( &record, pData + i * sizeof( VMeshSubmesh ), sizeof( VMeshSubmesh ) );
+
+		if ( static_cast< uint64_t >( record.firstIndex ) + record.indexCount > header.indexCount )
+		{
+			return false;
+		}
+
+		submeshes[i].firstIndex = record.firstIndex;
+		submeshes[i].indexCount = record.indexCount;
+		submeshes[i].bounds = FromFileBounds( record.bounds );
+	}
+
+	pData += submeshBytes;
+
+	lods.resize( header.lodCount );
+
+	for ( uint32_t i = 0; i < header.lodCount; ++i )
+	{
+		VMeshLod record;
+		memcpy( &record, pData + i * sizeof( VMeshLod ), sizeof( VMeshLod ) );
+
+		if ( static_cast< uint64_t >( record.firstIndex ) + record.indexCount > header.indexCount || static_cast< uint64_t >( record.firstMeshlet ) + record.meshletCount > header.meshletCount )
+		{
+			return false;
+		}
+
+		lods[i] = { record.firstIndex, record.indexCount, record.error, record.firstMeshlet, record.meshletCount };
+	}
+
+	pData += lodBytes;
+
+	meshlets.resize( header.meshletCount );
+
+	for ( uint32_t i = 0; i < header.meshletCount; ++i )
+	{
+		VMeshMeshlet record;
+		memcpy( &record, pData + i * sizeof( VMeshMeshlet ), sizeof( VMeshMeshlet ) );
+
+		if ( static_cast< uint64_t >( record.firstIndex ) + record.indexCount > header.indexCount )
+		{
+			return false;
+		}
+
+		meshlets[i].firstIndex = record.firstIndex;
+		meshlets[i].indexCount = record.indexCount;
+		meshlets[i].sphere = glm::vec4( record.sphere[0], record.sphere[1], record.sphere[2], record.sphere[3] );
+		meshlets[i].cone = glm::vec4( record.cone[0], record.cone[1], record.cone[2], record.cone[3] );
+	}
+
+	pData += meshletBytes;
+
+	vertices.resize( header.vertexCount );
+	indices.resize( header.indexCount );
+
+	memcpy( vertices.data(), pData, vertexBytes );
+	memcpy( indices.data(), pData + vertexBytes, indexBytes );
+
+	// A corrupt cache would otherwise have bounds, meshlets and the GPU fetch past the vertex buffer
+	for ( uint32_t index : indices )
+	{
+		if ( index >= header.vertexCount )
+		{
+			return false;
+		}
+	}
+
+	bounds = FromFileBounds( header.bounds );
+
+	return true;
+}
+
+bool FileUtils::WriteMeshCache( const std::string& path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods, const std::vector<Meshlet>& meshlets, const MeshBounds& bounds )
+{
+	VMeshHeader header = {};
+	memcpy( header.identifier, VMESH_IDENTIFIER, sizeof( VMESH_IDENTIFIER ) );
+	header.version = VMESH_VERSION;
+	header.vertexStride = sizeof( Vertex );
+	header.vertexCount = static_cast< uint32_t >( vertices.size() );
+	header.indexCount = static_cast< uint32_t >( indices.size() );
+	header.submeshCount = static_cast< uint32_t >( submeshes.size() );
+	header.lodCount = static_cast< uint32_t >( lods.size() );
+	header.meshletCount = static_cast< uint32_t >( meshlets.size() );
+	header.bounds = ToFileBounds( bounds );
+
+	std::ofstream file( path, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		return false;
+	}
+
+	file.write( reinterpret_cast< const char* >( &header ), sizeof( VMeshHeader ) );
+
+	for ( const Submesh& submesh : submeshes )
+	{
+		VMeshSubmesh record = { submesh.firstIndex, submesh.indexCount, ToFileBounds( submesh.bounds ) };
+		file.write( reinterpret_cast< const char* >( &record ), sizeof( VMeshSubmesh ) );
+	}
+
+	for ( const MeshLod& lod : lods )
+	{
+		VMeshLod record = { lod.firstIndex, lod.indexCount, lod.error, lod.firstMeshlet, lod.meshletCount };
+		file.write( reinterpret_cast< const char* >( &record ), sizeof( VMeshLod ) );
+	}
+
+	for ( const Meshlet& meshlet : meshlets )
+	{
+		VMeshMeshlet record =
+		{
+			meshlet.firstIndex,
+			meshlet.indexCount,
+			{ meshlet.sphere.x, meshlet.sphere.y, meshlet.sphere.z, meshlet.sphere.w },
+			{ meshlet.cone.x, meshlet.cone.y, meshlet.cone.z, meshlet.cone.w },
+		};
+		file.write( reinterpret_cast< const char* >( &record ), sizeof( VMeshMeshlet ) );
+	}
+
+	file.write( reinterpret_cast< const char* >( vertices.data() ), vertices.size() * sizeof( Vertex ) );
+	file.write( reinterpret_cast< const char* >( indices.data() ), indices.size() * sizeof( uint32_t ) );
+
+	return file.good();
 }
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include <string>
 #include <vector>
 
+#include "MappedFile.h"
+#include "VirtualFileSystem.h"
 #include "ModelClass.h"
+#include "TextureFormats.h"
 
 constexpr const char* TEXTURE_PATH = "../assets/textures/";
 constexpr const char* MODEL_PATH = "../assets/models/";
@@ -14,5 +17,20 @@ struct FileUtils
 	static std::vector<char> ReadFile( const std::string& filename );
 	static void* OpenTexture( const char* filename, int& texWidth, int& texHeight, int& texChannels );
 	static void CloseTexture( void* );
-	static void LoadModel( const char* filename, std::vector<Vertex>& uniqueVertices, std::vector<uint32_t>& indices );
+	static bool ReadTextureInfo( const uint8_t* pFileData, size_t fileSize, uint32_t& texWidth, uint32_t& texHeight );
+	// Decodes to RGBA8 directly into pDestination, which must be exactly texWidth * texHeight * 4 bytes
+	static bool DecodeTextureInto( const uint8_t* pFileData, size_t fileSize, void* pDestination, size_t destinationSize );
+	static bool LoadKTX( const char* filename, TextureData& textureData );
+	static bool LoadCookedTexture( const char* filename, TextureData& textureData );
+	static bool WriteCookedTexture( const std::string& path, const TextureData& textureData );
+	static bool ReadCookedTextureIndex( const std::string& path, VTexHeader& header, std::vector<VTexLevel>& levels );
+	static bool ReadFileRange( const std::string& path, uint64_t offset, uint64_t size, std::vector<uint8_t>& data );
+	static bool FileExists( const std::string& filename );
+	static bool HashFileContents( const std::string& filename, uint64_t& hash );
+	// Appends to vertices and indices; each non-empty OBJ shape becomes one submesh, and pBounds gets the bounds of everything appended
+	static void LoadModel( const char* filename, std::vector<Vertex>& uniqueVertices, std::vector<uint32_t>& indices, std::vector<Submesh>* pSubmeshes = nullptr, MeshBounds* pBounds = nullptr );
+	// Bounds of the vertices indices reference, so a submesh's bounds ignore the rest of the shared vertex buffer
+	static MeshBounds ComputeBounds( const std::vector<Vertex>& vertices, const uint32_t* pIndices, size_t indexCount );
+	static bool LoadMeshCache( const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>& submeshes, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets, MeshBounds& bounds );
+	static bool WriteMeshCache( const std::string& path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods, const std::vector<Meshlet>& meshlets, const MeshBounds& bounds );
 };
\ No newline at end of file
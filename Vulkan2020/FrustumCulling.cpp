@@ -0,0 +1,235 @@
+#include "FrustumCulling.h"
+
+#include <cmath>
+
+#if defined( _M_X64 ) || defined( __SSE__ ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define CULL_SIMD_SSE
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define CULL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	glm::vec4 GetRow( const glm::mat4& matrix, int row )
+	{
+		return glm::vec4( matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row] );
+	}
+
+	glm::vec4 NormalisePlane( const glm::vec4& plane )
+	{
+		return plane / glm::length( glm::vec3( plane ) );
+	}
+
+	float GetPlaneDistance( const glm::vec4& plane, const glm::vec3& point )
+	{
+		return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+	}
+
+	bool IsSphereOutside( const FrustumCulling::Frustum& frustum, const glm::vec4& sphere )
+	{
+		for ( const glm::vec4& plane : frustum.planes )
+		{
+			if ( GetPlaneDistance( plane, glm::vec3( sphere ) ) < -sphere.w )
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void SetFlag( uint8_t& flags, uint8_t flag, bool bSet )
+	{
+		flags = bSet ? ( flags | flag ) : ( flags & ~flag );
+	}
+}
+
+FrustumCulling::Frustum FrustumCulling::ExtractFrustum( const glm::mat4& viewProjection )
+{
+	const glm::vec4 row0 = GetRow( viewProjection, 0 );
+	const glm::vec4 row1 = GetRow( viewProjection, 1 );
+	const glm::vec4 row2 = GetRow( viewProjection, 2 );
+	const glm::vec4 row3 = GetRow( viewProjection, 3 );
+
+	Frustum frustum;
+	frustum.planes[0] = NormalisePlane( row3 + row0 );
+	frustum.planes[1] = NormalisePlane( row3 - row0 );
+	frustum.planes[2] = NormalisePlane( row3 + row1 );
+	frustum.planes[3] = NormalisePlane( row3 - row1 );
+	frustum.planes[4] = NormalisePlane( row3 + row2 );
+	frustum.planes[5] = NormalisePlane( row3 - row2 );
+
+	return frustum;
+}
+
+uint32_t FrustumCulling::CullSpheres( const glm::vec4* pSpheres, uint32_t count, const Frustum& frustum, uint8_t* pFlags, uint8_t cullFlag )
+{
+	uint32_t visibleCount = 0;
+	uint32_t i = 0;
+
+#if defined( CULL_SIMD_SSE )
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+
+	for ( int p = 0; p < 6; ++p )
+	{
+		planeX[p] = _mm_set1_ps( frustum.planes[p].x );
+		planeY[p] = _mm_set1_ps( frustum.planes[p].y );
+		planeZ[p] = _mm_set1_ps( frustum.planes[p].z );
+		planeW[p] = _mm_set1_ps( frustum.planes[p].w );
+	}
+
+	const __m128 signBit = _mm_set1_ps( -0.0f );
+
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		// Four xyzr spheres transposed into one register each of x, y, z and radius
+		__m128 x = _mm_loadu_ps( &pSpheres[i].x );
+		__m128 y = _mm_loadu_ps( &pSpheres[i + 1].x );
+		__m128 z = _mm_loadu_ps( &pSpheres[i + 2].x );
+		__m128 radius = _mm_loadu_ps( &pSpheres[i + 3].x );
+		_MM_TRANSPOSE4_PS( x, y, z, radius );
+
+		const __m128 negativeRadius = _mm_xor_ps( radius, signBit );
+		__m128 outside = _mm_setzero_ps();
+
+		for ( int p = 0; p < 6; ++p )
+		{
+			__m128 distance = _mm_mul_ps( planeX[p], x );
+			distance = _mm_add_ps( distance, _mm_mul_ps( planeY[p], y ) );
+			distance = _mm_add_ps( distance, _mm_mul_ps( planeZ[p], z ) );
+			distance = _mm_add_ps( distance, planeW[p] );
+
+			outside = _mm_or_ps( outside, _mm_cmplt_ps( distance, negativeRadius ) );
+		}
+
+		const int outsideMask = _mm_movemask_ps( outside );
+
+		for ( uint32_t lane = 0; lane < 4; ++lane )
+		{
+			const bool bOutside = ( outsideMask >> lane ) & 1;
+			SetFlag( pFlags[i + lane], cullFlag, bOutside );
+			visibleCount += bOutside ? 0 : 1;
+		}
+	}
+#elif defined( CULL_SIMD_NEON )
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		// vld4q deinterleaves four xyzr spheres into x, y, z and radius registers
+		const float32x4x4_t spheres = vld4q_f32( &pSpheres[i].x );
+		const float32x4_t negativeRadius = vnegq_f32( spheres.val[3] );
+		uint32x4_t outside = vdupq_n_u32( 0 );
+
+		for ( int p = 0; p < 6; ++p )
+		{
+			const glm::vec4& plane = frustum.planes[p];
+
+			float32x4_t distance = vmulq_n_f32( spheres.val[0], plane.x );
+			distance = vaddq_f32( distance, vmulq_n_f32( spheres.val[1], plane.y ) );
+			distance = vaddq_f32( distance, vmulq_n_f32( spheres.val[2], plane.z ) );
+			distance = vaddq_f32( distance, vdupq_n_f32( plane.w ) );
+
+			outside = vorrq_u32( outside, vcltq_f32( distance, negativeRadius ) );
+		}
+
+		uint32_t outsideLanes[4];
+		vst1q_u32( outsideLanes, outside );
+
+		for ( uint32_t lane = 0; lane < 4; ++lane )
+		{
+			const bool bOutside = outsideLanes[lane] != 0;
+			SetFlag( pFlags[i + lane], cullFlag, bOutside );
+			visibleCount += bOutside ? 0 : 1;
+		}
+	}
+#endif
+
+	for ( ; i < count; ++i )
+	{
+		const bool bOutside = IsSphereOutside( frustum, pSpheres[i] );
+		SetFlag( pFlags[i], cullFlag, bOutside );
+		visibleCount += bOutside ? 0 : 1;
+	}
+
+	return visibleCount;
+}
+
+bool FrustumCulling::ContainsSphere( const Frustum& frustum, const glm::vec4& sphere )
+{
+	for ( const glm::vec4& plane : frustum.planes )
+	{
+		if ( GetPlaneDistance( plane, glm::vec3( sphere ) ) < sphere.w )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+FrustumCulling::Containment FrustumCulling::ClassifyBox( const Frustum& frustum, const glm::vec3& boxMin, const glm::vec3& boxMax, uint32_t& planeMask )
+{
+	const glm::vec3 center = ( boxMin + boxMax ) * 0.5f;
+	const glm::vec3 extent = ( boxMax - boxMin ) * 0.5f;
+
+	for ( int p = 0; p < 6; ++p )
+	{
+		if ( ( planeMask & ( 1u << p ) ) == 0 )
+		{
+			continue;
+		}
+
+		const glm::vec4& plane = frustum.planes[p];
+		const float radius = std::abs( plane.x ) * extent.x + std::abs( plane.y ) * extent.y + std::abs( plane.z ) * extent.z;
+		const float distance = GetPlaneDistance( plane, center );
+
+		if ( distance < -radius )
+		{
+			return Containment::Outside;
+		}
+
+		if ( distance >= radius )
+		{
+			planeMask &= ~( 1u << p );
+		}
+	}
+
+	return planeMask == 0 ? Containment::Inside : Containment::Intersecting;
+}
+
+bool FrustumCulling::IsBoxVisible( const Frustum& frustum, const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& transform )
+{
+	// Centre and half extents of the world space box around the transformed one
+	const glm::vec3 localCenter = ( boxMin + boxMax ) * 0.5f;
+	const glm::vec3 localExtent = ( boxMax - boxMin ) * 0.5f;
+
+	const glm::vec3 center = glm::vec3( transform * glm::vec4( localCenter, 1.0f ) );
+	const glm::vec3 extent = glm::abs( glm::vec3( transform[0] ) ) * localExtent.x
+		+ glm::abs( glm::vec3( transform[1] ) ) * localExtent.y
+		+ glm::abs( glm::vec3( transform[2] ) ) * localExtent.z;
+
+	for ( const glm::vec4& plane : frustum.planes )
+	{
+		// Projected half size of the box onto the plane normal
+		const float radius = std::abs( plane.x ) * extent.x + std::abs( plane.y ) * extent.y + std::abs( plane.z ) * extent.z;
+
+		if ( GetPlaneDistance( plane, center ) < -radius )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const char* FrustumCulling::GetSIMDPathName()
+{
+#if defined( CULL_SIMD_SSE )
+	return "SSE";
+#elif defined( CULL_SIMD_NEON )
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
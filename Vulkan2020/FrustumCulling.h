@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// View frustum tests for the per-frame culling pass. Planes face inwards: a point p is on the
+// visible side of a plane when dot( plane.xyz, p ) + plane.w >= 0. Bounding spheres are tested
+// four at a time with SSE or NEON where the build has it, with a scalar loop otherwise.
+namespace FrustumCulling
+{
+	struct Frustum
+	{
+		glm::vec4 planes[6];	// left, right, bottom, top, near, far; normalised, so plane distances are in world units
+	};
+
+	enum class Containment
+	{
+		Outside,
+		Intersecting,
+		Inside,
+	};
+
+	constexpr uint32_t ALL_PLANES = ( 1u << 6 ) - 1;
+
+	// Gribb/Hartmann extraction from a world to clip matrix (projection * view). The near plane
+	// assumes -1..1 clip depth, which is conservative for a 0..1 projection.
+	Frustum ExtractFrustum( const glm::mat4& viewProjection );
+
+	// Sets cullFlag in pFlags[i] when sphere i (xyz centre, w radius) is entirely outside a plane and
+	// clears it otherwise; other flag bits are left alone. Returns how many spheres weren't culled.
+	uint32_t CullSpheres( const glm::vec4* pSpheres, uint32_t count, const Frustum& frustum, uint8_t* pFlags, uint8_t cullFlag );
+
+	// Whether the sphere is entirely inside, so nothing it encloses needs testing
+	bool ContainsSphere( const Frustum& frustum, const glm::vec4& sphere );
+
+	// World space box against the planes set in planeMask (bit i for planes[i]). Clears the bits of the
+	// planes the box is entirely inside, so a hierarchy can skip them for everything the box encloses.
+	Containment ClassifyBox( const Frustum& frustum, const glm::vec3& boxMin, const glm::vec3& boxMax, uint32_t& planeMask );
+
+	// Tests the world space box enclosing a model space box under transform
+	bool IsBoxVisible( const Frustum& frustum, const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& transform );
+
+	// "SSE", "NEON" or "scalar", whichever this build was compiled with
+	const char* GetSIMDPathName();
+}
\ No newline at end of file
@@ -0,0 +1,820 @@
+#include "GPUCulling.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <string>
+
+#include "ModelClass.h"
+#include "Scene.h"
+#include "ShaderClass.h"
+#include "VulkanGraphicsInstance.h"
+
+namespace
+{
+	constexpr uint32_t CULL_GROUP_SIZE = 64;	// local_size_x of cull.comp and occlusionCull.comp; clusterCull.comp runs one group per object instead
+	constexpr uint32_t MIN_CAPACITY = 64;
+
+	uint32_t GrowCapacity( uint32_t capacity, uint32_t count )
+	{
+		capacity = std::max( capacity, MIN_CAPACITY );
+		while ( capacity < count )
+		{
+			capacity *= 2;
+		}
+
+		return capacity;
+	}
+
+	VkDescriptorSetLayoutBinding MakeStorageBinding( uint32_t binding, VkShaderStageFlags stages )
+	{
+		VkDescriptorSetLayoutBinding layoutBinding = {};
+		layoutBinding.binding = binding;
+		layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		layoutBinding.descriptorCount = 1;
+		layoutBinding.stageFlags = stages;
+		layoutBinding.pImmutableSamplers = nullptr;
+
+		return layoutBinding;
+	}
+}
+
+bool GPUCuller::IsSupported( VkPhysicalDevice device )
+{
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures( device, &features );
+
+	if ( !features.multiDrawIndirect || !features.drawIndirectFirstInstance )
+	{
+		return false;
+	}
+
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, nullptr );
+
+	std::vector<VkExtensionProperties> availableExtensions( extensionCount );
+	vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, availableExtensions.data() );
+
+	for ( const VkExtensionProperties& extension : availableExtensions )
+	{
+		if ( std::string( extension.extensionName ) == VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void GPUCuller::Init( VulkanGraphicsInstance* pInstance, DescriptorLayoutCache& layoutCache, PipelineLayoutCache& pipelineLayoutCache, uint32_t framesInFlight, bool bClusters, bool bOcclusion )
+{
+	assert( !( bClusters && bOcclusion ) && "cluster and occlusion culling don't combine!" );
+
+	pGraphicsInstance = pInstance;
+	device = *pInstance->GetDevice();
+	bClusterMode = bClusters;
+	bOcclusionMode = bOcclusion;
+
+	pfnDrawIndexedIndirectCount = reinterpret_cast< PFN_vkCmdDrawIndexedIndirectCountKHR >( vkGetDeviceProcAddr( device, "vkCmdDrawIndexedIndirectCountKHR" ) );
+	assert( pfnDrawIndexedIndirectCount != nullptr && "VK_KHR_draw_indirect_count is not enabled!" );
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties( pInstance->GetPhysicalDevice(), &deviceProperties );
+	maxDrawCount = deviceProperties.limits.maxDrawIndirectCount;
+	maxWorkGroupCount[0] = deviceProperties.limits.maxComputeWorkGroupCount[0];
+	maxWorkGroupCount[1] = deviceProperties.limits.maxComputeWorkGroupCount[1];
+
+	// Objects are also read by the indirect vertex shader, which binds this same layout
+	std::vector<VkDescriptorSetLayoutBinding> bindings =
+	{
+		MakeStorageBinding( 0, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT ),
+		MakeStorageBinding( 1, VK_SHADER_STAGE_COMPUTE_BIT ),
+		MakeStorageBinding( 2, VK_SHADER_STAGE_COMPUTE_BIT ),
+		MakeStorageBinding( 3, VK_SHADER_STAGE_COMPUTE_BIT ),
+	};
+
+	if ( bClusterMode )
+	{
+		bindings.push_back( MakeStorageBinding( 4, VK_SHADER_STAGE_COMPUTE_BIT ) );
+	}
+
+	setLayout = layoutCache.GetLayout( bindings );
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof( CullConstants );
+
+	const char* shaderName = bClusterMode ? "shaders/clusterCull.spv" : "shaders/cull.spv";
+	std::vector<VkDescriptorSetLayout> setLayouts = { setLayout };
+	std::vector<DescriptorAllocator::PoolSizeRatio> poolRatios = { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast< float >( bindings.size() ) } };
+
+	if ( bOcclusionMode )
+	{
+		VkDescriptorSetLayoutBinding pyramidBinding = {};
+		pyramidBinding.binding = 0;
+		pyramidBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pyramidBinding.descriptorCount = 1;
+		pyramidBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pyramidBinding.pImmutableSamplers = nullptr;
+
+		occlusionSetLayout = layoutCache.GetLayout( { pyramidBinding, MakeStorageBinding( 1, VK_SHADER_STAGE_COMPUTE_BIT ) } );
+		setLayouts.push_back( occlusionSetLayout );
+		poolRatios.push_back( { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f } );
+
+		pushConstantRange.size = sizeof( OcclusionConstants );
+		shaderName = "shaders/occlusionCull.spv";
+	}
+
+	static_assert( sizeof( OcclusionConstants ) <= 128, "occlusion constants exceed the guaranteed push constant size!" );
+
+	pipelineLayout = pipelineLayoutCache.GetLayout( setLayouts, { pushConstantRange } );
+
+	VulkanComputeShader cullShader( pInstance, shaderName );
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = cullShader.GetCreateInfo();
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+	VkResult result = vkCreateComputePipelines( device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline );
+	assert( VK_SUCCESS == result && "failed to create cull pipeline!" );
+
+	descriptorAllocator.Init( device, framesInFlight, poolRatios );
+
+	Frames.resize( framesInFlight );
+	for ( FrameResources& frame : Frames )
+	{
+		ReserveObjects( frame, 1 );
+		ReserveMeshes( frame, 1 );
+		ReserveCommands( frame, 1 );
+
+		if ( bClusterMode )
+		{
+			ReserveMeshlets( frame, 1 );
+		}
+
+		frame.descriptorSet = descriptorAllocator.Allocate( setLayout );
+		WriteDescriptorSet( frame );
+	}
+
+	if ( bOcclusionMode )
+	{
+		occlusionSet = descriptorAllocator.Allocate( occlusionSetLayout );
+		ReserveVisibility( 1 );
+	}
+}
+
+void GPUCuller::Cleanup()
+{
+	for ( FrameResources& frame : Frames )
+	{
+		DestroyObjectBuffers( frame );
+		DestroyMeshBuffers( frame );
+		DestroyMeshletBuffer( frame );
+		DestroyCommandBuffer( frame );
+	}
+	Frames.clear();
+
+	DestroyVisibilityBuffer();
+	visibilityCapacity = 0;
+	occlusionSet = VK_NULL_HANDLE;
+	depthPyramidView = VK_NULL_HANDLE;
+	depthPyramidSampler = VK_NULL_HANDLE;
+
+	// The layouts belong to the caches
+	vkDestroyPipeline( device, pipeline, nullptr );
+	pipeline = VK_NULL_HANDLE;
+	descriptorAllocator.Cleanup();
+
+	Stats = Statistics();
+}
+
+void GPUCuller::Prepare( uint32_t frameIndex, Scene& scene, bool bValidate )
+{
+	FrameResources& frame = Frames[frameIndex];
+
+	ReadBack( frame );
+
+	const uint32_t entityCount = scene.GetEntityCount();
+	const uint32_t meshCount = static_cast< uint32_t >( scene.GetMeshes().size() );
+	const Scene::MeshId* pMeshRefs = scene.GetMeshRefs();
+	const uint32_t* pMaterials = scene.GetMaterials();
+	const glm::vec4* pTints = scene.GetTints();
+	const uint8_t* pLodLevels = scene.GetLodLevels();
+	const glm::mat4* pTransforms = scene.GetWorldTransforms();
+	const glm::vec4* pBounds = scene.GetBounds();
+	const uint8_t* pVisibility = scene.GetVisibility();
+
+	// Each mesh's segment holds all its entities, or all their meshlets, in case every one is visible
+	frame.segmentSizes.assign( meshCount, 0 );
+	uint32_t objectCount = 0;
+	uint32_t commandCount = 0;
+
+	for ( uint32_t i = 0; i < entityCount; ++i )
+	{
+		if ( pMeshRefs[i] == Scene::INVALID_MESH || ( pVisibility[i] & Scene::VISIBILITY_HIDDEN ) != 0 )
+		{
+			continue;
+		}
+
+		const uint32_t commands = bClusterMode ? scene.GetMesh( pMeshRefs[i] )->Lods[pLodLevels[i]].meshletCount : 1;
+		frame.segmentSizes[pMeshRefs[i]] += commands;
+		commandCount += commands;
+		++objectCount;
+	}
+
+	assert( ( !bClusterMode || objectCount <= uint64_t( maxWorkGroupCount[0] ) * maxWorkGroupCount[1] ) && "more objects than one cluster cull dispatch can cover!" );
+
+	bool bRecreated = ReserveObjects( frame, objectCount );
+	bRecreated |= ReserveMeshes( frame, meshCount );
+	// The late occlusion pass has a second segment for every mesh, after all the early ones
+	bRecreated |= ReserveCommands( frame, bOcclusionMode ? commandCount * 2 : commandCount );
+
+	if ( bOcclusionMode )
+	{
+		ReserveVisibility( scene.GetSlotCount() );
+	}
+
+	if ( bClusterMode )
+	{
+		bRecreated |= UpdateMeshletTable( frame, scene );
+	}
+
+	if ( bRecreated )
+	{
+		WriteDescriptorSet( frame );
+	}
+
+	static_assert( MAX_LODS == MAX_MESH_LODS, "the mesh table must hold every LOD level!" );
+
+	uint32_t commandOffset = 0;
+	uint32_t meshletOffset = 0;
+
+	for ( uint32_t mesh = 0; mesh < meshCount; ++mesh )
+	{
+		assert( frame.segmentSizes[mesh] <= maxDrawCount && "more entities share a mesh than one indirect draw can cover!" );
+
+		const std::vector<MeshLod>& lods = scene.GetMesh( mesh )->Lods;
+
+		MeshDraw& draw = frame.pMeshes[mesh];
+		draw.commandOffset = commandOffset;
+		draw.padding[0] = 0;
+		draw.padding[1] = 0;
+		draw.padding[2] = 0;
+
+		for ( uint32_t level = 0; level < MAX_LODS; ++level )
+		{
+			if ( level < lods.size() )
+			{
+				draw.lodRanges[level][0] = lods[level].firstIndex;
+				draw.lodRanges[level][1] = lods[level].indexCount;
+				draw.lodMeshlets[level][0] = meshletOffset + lods[level].firstMeshlet;
+				draw.lodMeshlets[level][1] = lods[level].meshletCount;
+			}
+			else if ( level == 0 )
+			{
+				draw.lodRanges[level][0] = 0;
+				draw.lodRanges[level][1] = scene.GetMesh( mesh )->GetIndexCount();
+				draw.lodMeshlets[level][0] = meshletOffset;
+				draw.lodMeshlets[level][1] = 0;
+			}
+			else
+			{
+				draw.lodRanges[level][0] = draw.lodRanges[level - 1][0];
+				draw.lodRanges[level][1] = draw.lodRanges[level - 1][1];
+				draw.lodMeshlets[level][0] = draw.lodMeshlets[level - 1][0];
+				draw.lodMeshlets[level][1] = draw.lodMeshlets[level - 1][1];
+			}
+		}
+
+		commandOffset += frame.segmentSizes[mesh];
+		meshletOffset += static_cast< uint32_t >( scene.GetMesh( mesh )->Meshlets.size() );
+	}
+
+	uint32_t objectIndex = 0;
+	uint32_t cpuVisible = 0;
+
+	for ( uint32_t i = 0; i < entityCount; ++i )
+	{
+		if ( pMeshRefs[i] == Scene::INVALID_MESH || ( pVisibility[i] & Scene::VISIBILITY_HIDDEN ) != 0 )
+		{
+			continue;
+		}
+
+		ObjectData& object = frame.pObjects[objectIndex++];
+		object.model = pTransforms[i];
+		object.sphere = pBounds[i];
+		object.tint = pTints[i];
+		object.mesh = pMeshRefs[i];
+		object.material = pMaterials[i];
+		object.lod = pLodLevels[i];
+		object.entity = Scene::GetSlot( scene.GetEntity( i ) );
+
+		cpuVisible += ( pVisibility[i] & Scene::VISIBILITY_CULLED ) == 0 ? 1 : 0;
+	}
+
+	frame.objectCount = objectCount;
+	frame.clusterCount = bClusterMode ? commandCount : 0;
+	frame.commandCount = commandCount;
+	frame.cpuVisible = cpuVisible;
+	frame.bValidated = bValidate && !bClusterMode && !bOcclusionMode;
+	frame.bSubmitted = false;
+}
+
+void GPUCuller::RecordCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const FrustumCulling::Frustum& frustum, const glm::vec3& cameraPosition )
+{
+	assert( !bOcclusionMode && "occlusion mode culls with RecordOcclusionCull!" );
+
+	FrameResources& frame = Frames[frameIndex];
+	const uint32_t meshCount = static_cast< uint32_t >( frame.segmentSizes.size() );
+
+	if ( meshCount == 0 )
+	{
+		return;
+	}
+
+	vkCmdFillBuffer( commandBuffer, frame.countBuffer, 0, meshCount * sizeof( uint32_t ), 0 );
+
+	VkMemoryBarrier clearBarrier = {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr );
+
+	if ( frame.objectCount > 0 )
+	{
+		CullConstants constants = {};
+		std::copy( std::begin( frustum.planes ), std::end( frustum.planes ), constants.planes );
+		constants.cameraPosition = glm::vec4( cameraPosition, 1.0f );
+		constants.objectCount = frame.objectCount;
+
+		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+		vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr );
+		vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( CullConstants ), &constants );
+
+		if ( bClusterMode )
+		{
+			// A workgroup per object, in rows of up to maxComputeWorkGroupCount[0], which may be as low as 65535;
+			// groups past the last object return straight away
+			const uint32_t rowLength = std::min( frame.objectCount, maxWorkGroupCount[0] );
+			vkCmdDispatch( commandBuffer, rowLength, ( frame.objectCount + rowLength - 1 ) / rowLength, 1 );
+		}
+		else
+		{
+			vkCmdDispatch( commandBuffer, ( frame.objectCount + CULL_GROUP_SIZE - 1 ) / CULL_GROUP_SIZE, 1, 1 );
+		}
+	}
+
+	// The counts come from the clear alone when nothing was dispatched
+	VkMemoryBarrier cullBarrier = {};
+	cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr );
+
+	RecordCountReadback( commandBuffer, frame );
+}
+
+void GPUCuller::RecordOcclusionCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const glm::mat4& view, const glm::mat4& projection, bool bLate )
+{
+	assert( bOcclusionMode && depthPyramidView != VK_NULL_HANDLE && "occlusion culling needs occlusion mode and a depth pyramid!" );
+
+	FrameResources& frame = Frames[frameIndex];
+	const uint32_t meshCount = static_cast< uint32_t >( frame.segmentSizes.size() );
+
+	if ( meshCount == 0 )
+	{
+		return;
+	}
+
+	if ( !bLate )
+	{
+		vkCmdFillBuffer( commandBuffer, frame.countBuffer, 0, GetCountEntries( meshCount ) * sizeof( uint32_t ), 0 );
+
+		// A new visibility buffer starts with nothing visible, so the first late pass draws everything it doesn't cull
+		if ( !bVisibilityCleared )
+		{
+			vkCmdFillBuffer( commandBuffer, visibilityBuffer, 0, VK_WHOLE_SIZE, 0 );
+			bVisibilityCleared = true;
+		}
+
+		// The visibility buffer was last written by the late pass of the frame before, earlier in the queue
+		VkMemoryBarrier clearBarrier = {};
+		clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr );
+	}
+
+	if ( frame.objectCount > 0 )
+	{
+		OcclusionConstants constants = {};
+		constants.view = view;
+		constants.projection = glm::vec4( projection[0][0], projection[1][1], projection[2][2], projection[3][2] );
+		constants.pyramidSize = glm::vec2( depthPyramidExtent.width, depthPyramidExtent.height );
+		constants.objectCount = frame.objectCount;
+		constants.meshCount = meshCount;
+		constants.lateCommandOffset = frame.commandCount;
+		constants.late = bLate ? 1 : 0;
+
+		const std::array<VkDescriptorSet, 2> sets = { frame.descriptorSet, occlusionSet };
+
+		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+		vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, static_cast< uint32_t >( sets.size() ), sets.data(), 0, nullptr );
+		vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( OcclusionConstants ), &constants );
+		vkCmdDispatch( commandBuffer, ( frame.objectCount + CULL_GROUP_SIZE - 1 ) / CULL_GROUP_SIZE, 1, 1 );
+	}
+
+	// The late pass's counts and commands live beside the early pass's, which stay untouched while those draw
+	VkMemoryBarrier cullBarrier = {};
+	cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr );
+
+	if ( bLate )
+	{
+		RecordCountReadback( commandBuffer, frame );
+	}
+}
+
+void GPUCuller::SetDepthPyramid( VkImageView pyramidView, VkSampler pyramidSampler, VkExtent2D pyramidExtent )
+{
+	depthPyramidView = pyramidView;
+	depthPyramidSampler = pyramidSampler;
+	depthPyramidExtent = pyramidExtent;
+
+	WriteOcclusionSet();
+}
+
+void GPUCuller::RecordDraws( VkCommandBuffer commandBuffer, uint32_t frameIndex, const Scene& scene, VkPipelineLayout graphicsLayout, uint32_t objectSet, uint32_t imageIndex, bool bLate )
+{
+	FrameResources& frame = Frames[frameIndex];
+	const uint32_t meshCount = static_cast< uint32_t >( frame.segmentSizes.size() );
+
+	if ( frame.objectCount == 0 )
+	{
+		return;
+	}
+
+	vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsLayout, objectSet, 1, &frame.descriptorSet, 0, nullptr );
+
+	const uint32_t commandStride = sizeof( VkDrawIndexedIndirectCommand );
+	const uint32_t firstCount = bLate ? meshCount : 0;
+	uint32_t commandOffset = bLate ? frame.commandCount : 0;
+
+	for ( uint32_t mesh = 0; mesh < meshCount; ++mesh )
+	{
+		const uint32_t segmentSize = frame.segmentSizes[mesh];
+
+		if ( segmentSize > 0 )
+		{
+			scene.GetMesh( mesh )->BindGeometry( commandBuffer, graphicsLayout, imageIndex );
+			pfnDrawIndexedIndirectCount( commandBuffer, frame.drawBuffer, commandOffset * VkDeviceSize( commandStride ), frame.countBuffer, ( firstCount + mesh ) * sizeof( uint32_t ), segmentSize, commandStride );
+		}
+
+		commandOffset += segmentSize;
+	}
+}
+
+void GPUCuller::ReadBack( FrameResources& frame )
+{
+	if ( !frame.bSubmitted )
+	{
+		return;
+	}
+
+	// The slot's fence has signalled, and the copy was followed by a host barrier
+	const uint32_t meshCount = static_cast< uint32_t >( frame.segmentSizes.size() );
+	uint32_t drawsVisible = 0;
+	uint32_t drawsLate = 0;
+
+	for ( uint32_t mesh = 0; mesh < meshCount; ++mesh )
+	{
+		drawsVisible += frame.pReadback[mesh];
+	}
+
+	if ( bOcclusionMode )
+	{
+		for ( uint32_t mesh = 0; mesh < meshCount; ++mesh )
+		{
+			drawsLate += frame.pReadback[meshCount + mesh];
+		}
+
+		drawsVisible += drawsLate;
+		Stats.objectsOccluded = frame.pReadback[meshCount * 2];
+	}
+
+	Stats.objectsSubmitted = frame.objectCount;
+	Stats.clustersSubmitted = frame.clusterCount;
+	Stats.drawsVisible = drawsVisible;
+	Stats.drawsLate = drawsLate;
+
+	if ( frame.bValidated )
+	{
+		Stats.cpuVisible = frame.cpuVisible;
+		++Stats.framesValidated;
+		Stats.framesMismatched += drawsVisible != frame.cpuVisible ? 1 : 0;
+	}
+
+	frame.bSubmitted = false;
+}
+
+uint32_t GPUCuller::GetCountEntries( uint32_t meshCount ) const
+{
+	return bOcclusionMode ? meshCount * 2 + 1 : meshCount;
+}
+
+void GPUCuller::RecordCountReadback( VkCommandBuffer commandBuffer, FrameResources& frame )
+{
+	VkBufferCopy copyRegion = {};
+	copyRegion.size = GetCountEntries( static_cast< uint32_t >( frame.segmentSizes.size() ) ) * sizeof( uint32_t );
+	vkCmdCopyBuffer( commandBuffer, frame.countBuffer, frame.readbackBuffer, 1, &copyRegion );
+
+	VkMemoryBarrier readbackBarrier = {};
+	readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr );
+
+	frame.bSubmitted = true;
+}
+
+bool GPUCuller::ReserveObjects( FrameResources& frame, uint32_t count )
+{
+	if ( count <= frame.objectCapacity )
+	{
+		return false;
+	}
+
+	// Nothing in the slot is in flight any more, so the old buffers can go straight away
+	DestroyObjectBuffers( frame );
+	frame.objectCapacity = GrowCapacity( frame.objectCapacity, count );
+
+	pGraphicsInstance->CreateBuffer( frame.objectCapacity * sizeof( ObjectData ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.objectBuffer, frame.objectMemory );
+
+	void* pData;
+	vkMapMemory( device, frame.objectMemory, 0, VK_WHOLE_SIZE, 0, &pData );
+	frame.pObjects = static_cast< ObjectData* >( pData );
+
+	return true;
+}
+
+bool GPUCuller::ReserveMeshes( FrameResources& frame, uint32_t count )
+{
+	if ( count <= frame.meshCapacity )
+	{
+		return false;
+	}
+
+	// The counts read back so far were consumed by ReadBack before Prepare grows anything
+	DestroyMeshBuffers( frame );
+	frame.meshCapacity = GrowCapacity( frame.meshCapacity, count );
+
+	pGraphicsInstance->CreateBuffer( frame.meshCapacity * sizeof( MeshDraw ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.meshBuffer, frame.meshMemory );
+	const VkDeviceSize countSize = GetCountEntries( frame.meshCapacity ) * sizeof( uint32_t );
+	pGraphicsInstance->CreateBuffer( countSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.countBuffer, frame.countMemory );
+	pGraphicsInstance->CreateBuffer( countSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.readbackBuffer, frame.readbackMemory );
+
+	void* pData;
+	vkMapMemory( device, frame.meshMemory, 0, VK_WHOLE_SIZE, 0, &pData );
+	frame.pMeshes = static_cast< MeshDraw* >( pData );
+
+	vkMapMemory( device, frame.readbackMemory, 0, VK_WHOLE_SIZE, 0, &pData );
+	frame.pReadback = static_cast< const uint32_t* >( pData );
+
+	return true;
+}
+
+bool GPUCuller::ReserveMeshlets( FrameResources& frame, uint32_t count )
+{
+	if ( count <= frame.meshletCapacity )
+	{
+		return false;
+	}
+
+	DestroyMeshletBuffer( frame );
+	frame.meshletCapacity = GrowCapacity( frame.meshletCapacity, count );
+
+	pGraphicsInstance->CreateBuffer( frame.meshletCapacity * sizeof( MeshletData ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.meshletBuffer, frame.meshletMemory );
+
+	void* pData;
+	vkMapMemory( device, frame.meshletMemory, 0, VK_WHOLE_SIZE, 0, &pData );
+	frame.pMeshlets = static_cast< MeshletData* >( pData );
+
+	return true;
+}
+
+bool GPUCuller::ReserveCommands( FrameResources& frame, uint32_t count )
+{
+	if ( count <= frame.commandCapacity )
+	{
+		return false;
+	}
+
+	DestroyCommandBuffer( frame );
+	frame.commandCapacity = GrowCapacity( frame.commandCapacity, count );
+
+	pGraphicsInstance->CreateBuffer( frame.commandCapacity * sizeof( VkDrawIndexedIndirectCommand ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.drawBuffer, frame.drawMemory );
+
+	return true;
+}
+
+void GPUCuller::ReserveVisibility( uint32_t count )
+{
+	if ( count <= visibilityCapacity )
+	{
+		return;
+	}
+
+	// Every frame in flight reads and writes it, and rarely does the scene outgrow it
+	vkDeviceWaitIdle( device );
+
+	DestroyVisibilityBuffer();
+	visibilityCapacity = GrowCapacity( visibilityCapacity, count );
+
+	pGraphicsInstance->CreateBuffer( visibilityCapacity * sizeof( uint32_t ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, visibilityBuffer, visibilityMemory );
+	bVisibilityCleared = false;
+
+	WriteOcclusionSet();
+}
+
+bool GPUCuller::UpdateMeshletTable( FrameResources& frame, const Scene& scene )
+{
+	// Meshes are only ever added, or all cleared at once, so this is rare
+	if ( frame.meshletSources.size() == scene.GetMeshes().size() && std::equal( frame.meshletSources.begin(), frame.meshletSources.end(), scene.GetMeshes().begin() ) )
+	{
+		return false;
+	}
+
+	frame.meshletSources.assign( scene.GetMeshes().begin(), scene.GetMeshes().end() );
+
+	uint32_t meshletCount = 0;
+	for ( const Model* pModel : frame.meshletSources )
+	{
+		meshletCount += static_cast< uint32_t >( pModel->Meshlets.size() );
+	}
+
+	const bool bRecreated = ReserveMeshlets( frame, meshletCount );
+	MeshletData* pMeshlet = frame.pMeshlets;
+
+	for ( const Model* pModel : frame.meshletSources )
+	{
+		for ( const Meshlet& meshlet : pModel->Meshlets )
+		{
+			pMeshlet->sphere = meshlet.sphere;
+			pMeshlet->cone = meshlet.cone;
+			pMeshlet->firstIndex = meshlet.firstIndex;
+			pMeshlet->indexCount = meshlet.indexCount;
+			pMeshlet->padding[0] = 0;
+			pMeshlet->padding[1] = 0;
+			++pMeshlet;
+		}
+	}
+
+	return bRecreated;
+}
+
+void GPUCuller::DestroyObjectBuffers( FrameResources& frame )
+{
+	if ( frame.objectBuffer == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	vkUnmapMemory( device, frame.objectMemory );
+	vkDestroyBuffer( device, frame.objectBuffer, nullptr );
+	vkFreeMemory( device, frame.objectMemory, nullptr );
+
+	frame.objectBuffer = VK_NULL_HANDLE;
+	frame.pObjects = nullptr;
+}
+
+void GPUCuller::DestroyMeshBuffers( FrameResources& frame )
+{
+	if ( frame.meshBuffer == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	vkUnmapMemory( device, frame.meshMemory );
+	vkDestroyBuffer( device, frame.meshBuffer, nullptr );
+	vkFreeMemory( device, frame.meshMemory, nullptr );
+	vkDestroyBuffer( device, frame.countBuffer, nullptr );
+	vkFreeMemory( device, frame.countMemory, nullptr );
+	vkUnmapMemory( device, frame.readbackMemory );
+	vkDestroyBuffer( device, frame.readbackBuffer, nullptr );
+	vkFreeMemory( device, frame.readbackMemory, nullptr );
+
+	frame.meshBuffer = VK_NULL_HANDLE;
+	frame.countBuffer = VK_NULL_HANDLE;
+	frame.readbackBuffer = VK_NULL_HANDLE;
+	frame.pMeshes = nullptr;
+	frame.pReadback = nullptr;
+}
+
+void GPUCuller::DestroyMeshletBuffer( FrameResources& frame )
+{
+	if ( frame.meshletBuffer == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	vkUnmapMemory( device, frame.meshletMemory );
+	vkDestroyBuffer( device, frame.meshletBuffer, nullptr );
+	vkFreeMemory( device, frame.meshletMemory, nullptr );
+
+	frame.meshletBuffer = VK_NULL_HANDLE;
+	frame.pMeshlets = nullptr;
+}
+
+void GPUCuller::DestroyCommandBuffer( FrameResources& frame )
+{
+	if ( frame.drawBuffer == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	vkDestroyBuffer( device, frame.drawBuffer, nullptr );
+	vkFreeMemory( device, frame.drawMemory, nullptr );
+
+	frame.drawBuffer = VK_NULL_HANDLE;
+}
+
+void GPUCuller::DestroyVisibilityBuffer()
+{
+	if ( visibilityBuffer == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	vkDestroyBuffer( device, visibilityBuffer, nullptr );
+	vkFreeMemory( device, visibilityMemory, nullptr );
+
+	visibilityBuffer = VK_NULL_HANDLE;
+}
+
+void GPUCuller::WriteDescriptorSet( FrameResources& frame )
+{
+	// The set is only bound by command buffers recorded for this slot, none of which is pending now
+	const std::array<VkDescriptorBufferInfo, 5> bufferInfos =
+	{ {
+		{ frame.objectBuffer, 0, VK_WHOLE_SIZE },
+		{ frame.meshBuffer, 0, VK_WHOLE_SIZE },
+		{ frame.drawBuffer, 0, VK_WHOLE_SIZE },
+		{ frame.countBuffer, 0, VK_WHOLE_SIZE },
+		{ frame.meshletBuffer, 0, VK_WHOLE_SIZE },
+	} };
+
+	// The meshlet table only exists in cluster mode
+	std::array<VkWriteDescriptorSet, 5> descriptorWrites = {};
+	const uint32_t bindingCount = bClusterMode ? 5 : 4;
+
+	for ( uint32_t binding = 0; binding < bindingCount; ++binding )
+	{
+		descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[binding].dstSet = frame.descriptorSet;
+		descriptorWrites[binding].dstBinding = binding;
+		descriptorWrites[binding].dstArrayElement = 0;
+		descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[binding].descriptorCount = 1;
+		descriptorWrites[binding].pBufferInfo = &bufferInfos[binding];
+	}
+
+	vkUpdateDescriptorSets( device, bindingCount, descriptorWrites.data(), 0, nullptr );
+}
+
+void GPUCuller::WriteOcclusionSet()
+{
+	// Only rewritten with the device idle, or before the first cull
+	VkDescriptorBufferInfo visibilityInfo = { visibilityBuffer, 0, VK_WHOLE_SIZE };
+
+	VkDescriptorImageInfo pyramidInfo = {};
+	pyramidInfo.sampler = depthPyramidSampler;
+	pyramidInfo.imageView = depthPyramidView;
+	pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+
+	descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrites[0].dstSet = occlusionSet;
+	descriptorWrites[0].dstBinding = 1;
+	descriptorWrites[0].dstArrayElement = 0;
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrites[0].descriptorCount = 1;
+	descriptorWrites[0].pBufferInfo = &visibilityInfo;
+
+	descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrites[1].dstSet = occlusionSet;
+	descriptorWrites[1].dstBinding = 0;
+	descriptorWrites[1].dstArrayElement = 0;
+	descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrites[1].descriptorCount = 1;
+	descriptorWrites[1].pImageInfo = &pyramidInfo;
+
+	// The pyramid comes with the swapchain, after Init
+	const uint32_t writeCount = depthPyramidView != VK_NULL_HANDLE ? 2 : 1;
+	vkUpdateDescriptorSets( device, writeCount, descriptorWrites.data(), 0, nullptr );
+}
\ No newline at end of file
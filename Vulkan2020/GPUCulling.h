@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vulkan/vulkan.h"
+
+#include "DescriptorAllocator.h"
+#include "FrustumCulling.h"
+#include "LayoutCache.h"
+
+class VulkanGraphicsInstance;
+class Scene;
+class Model;
+
+// Frustum culling in a compute shader feeding vkCmdDrawIndexedIndirectCount, so recording the scene
+// costs a fixed number of commands per mesh however many entities there are.
+//
+// Every frame Prepare packs the unhidden entities with a mesh into an object buffer (world matrix,
+// world bounding sphere, tint, mesh, material, LOD) and gives each mesh a segment of the draw command buffer
+// sized to its entity count. The cull shader tests one object per invocation and appends a
+// VkDrawIndexedIndirectCommand for the object's LOD range to its mesh's segment, bumping that mesh's
+// count; the levels of a mesh share its vertex buffer, so they share its segment. firstInstance is
+// the object's index, which the indirect vertex shader uses to read its transform and material.
+// RecordDraws then binds each mesh's geometry and issues one count draw over its segment.
+//
+// In cluster mode the objects are split further, into the meshlets of their LOD (see MeshletBuilder).
+// clusterCull.comp runs one workgroup per object, dispatched in rows: after the object's own frustum test, each
+// invocation takes meshlets and drops those whose normal cone faces away from the camera or whose
+// sphere is outside the frustum, appending one draw per surviving meshlet. Segments are then sized
+// to the meshlets of the mesh's objects instead of to the objects.
+//
+// Occlusion mode splits the frame in two around a DepthPyramid. The early pass draws the objects the
+// last frame found visible, tested against the frustum only; the pyramid is built from the depth they
+// leave, and the late pass tests every object against the frustum and the pyramid, remembers the result
+// for the next frame and draws the ones the early pass left out. Visibility is kept per handle slot
+// (Scene::GetSlot) rather than per object or dense index, which shift whenever entities are created,
+// destroyed or reparented; only an entity that reuses a destroyed one's slot inherits its last result,
+// and is at worst drawn early for nothing, or a pass late. Every mesh has a segment,
+// and a count, for each pass. Cluster mode doesn't combine with it.
+//
+// Buffers are per frame in flight and grow on demand. The draw counts are copied back each frame,
+// so once a frame slot comes round again its counts can be compared with the CPU culler's.
+class GPUCuller
+{
+public:
+	// One per packed object, std430; the cull shader and indirectVert.vert declare the same struct
+	struct ObjectData
+	{
+		glm::mat4 model;
+		glm::vec4 sphere;	// world space: xyz centre, w radius
+		glm::vec4 tint;
+		uint32_t mesh;
+		uint32_t material;
+		uint32_t lod;	// index into the mesh's LOD ranges, from Scene::SelectLods
+		uint32_t entity;	// the entity's handle slot (Scene::GetSlot), which indexes the occlusion visibility buffer
+	};
+
+	struct Statistics
+	{
+		uint32_t objectsSubmitted = 0;	// to the cull shader, in the last frame read back
+		uint32_t drawsVisible = 0;		// draw commands it wrote, over every mesh and both occlusion passes
+		uint32_t drawsLate = 0;			// of those, written by the late occlusion pass
+		uint32_t objectsOccluded = 0;	// inside the frustum but hidden by the depth pyramid, in occlusion mode
+		uint32_t clustersSubmitted = 0;	// meshlets of the submitted objects' LODs, in cluster mode
+		uint32_t cpuVisible = 0;		// what the CPU culler found for the same frame, when it was validated
+		uint32_t framesValidated = 0;	// lifetime totals
+		uint32_t framesMismatched = 0;
+	};
+
+	// bClusters selects cluster mode, which needs every mesh's Meshlets; bOcclusion selects occlusion mode
+	void Init( VulkanGraphicsInstance* pInstance, DescriptorLayoutCache& layoutCache, PipelineLayoutCache& pipelineLayoutCache, uint32_t framesInFlight, bool bClusters, bool bOcclusion );
+	void Cleanup();
+
+	// Set the indirect vertex shader reads the object buffer from (binding 0)
+	VkDescriptorSetLayout GetObjectSetLayout() const { return setLayout; }
+
+	// Once per frame, after the frame slot's fence: reads back the counts of the slot's last frame and packs
+	// the scene into its buffers. With bValidate the scene must have been culled this frame, and the number of
+	// objects the CPU left visible is kept to compare with the GPU's once the counts come back. The CPU has
+	// no per-meshlet counts, and doesn't test occlusion, so cluster and occlusion modes ignore bValidate.
+	void Prepare( uint32_t frameIndex, Scene& scene, bool bValidate );
+
+	// Outside the render pass: clears the counts, runs the cull shader and makes its output available to indirect draws.
+	// cameraPosition is only used by the cone tests of cluster mode. Not for occlusion mode.
+	void RecordCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const FrustumCulling::Frustum& frustum, const glm::vec3& cameraPosition );
+
+	// Occlusion mode's RecordCull, once for each pass and outside the render pass. The early pass clears the counts;
+	// the late one needs the pyramid built since, and copies the counts of both back. view must be rigid, and
+	// projection a symmetric perspective one.
+	void RecordOcclusionCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const glm::mat4& view, const glm::mat4& projection, bool bLate );
+
+	// The pyramid the late pass tests against; again whenever it's recreated, with the device idle
+	void SetDepthPyramid( VkImageView pyramidView, VkSampler pyramidSampler, VkExtent2D pyramidExtent );
+
+	// Inside the render pass with an indirect pipeline bound; objectSet is the object set's index in graphicsLayout.
+	// bLate draws the late occlusion pass's commands.
+	void RecordDraws( VkCommandBuffer commandBuffer, uint32_t frameIndex, const Scene& scene, VkPipelineLayout graphicsLayout, uint32_t objectSet, uint32_t imageIndex, bool bLate = false );
+
+	const Statistics& GetStatistics() const { return Stats; }
+	bool IsClusterMode() const { return bClusterMode; }
+	bool IsOcclusionMode() const { return bOcclusionMode; }
+
+	// Whether the device can run this: VK_KHR_draw_indirect_count, multiDrawIndirect and drawIndirectFirstInstance
+	static bool IsSupported( VkPhysicalDevice device );
+
+private:
+	static constexpr uint32_t MAX_LODS = 4;	// MAX_MESH_LODS
+
+	// Mesh table entry, std430
+	struct MeshDraw
+	{
+		uint32_t commandOffset;	// first command of the mesh's segment
+		uint32_t padding[3];
+		uint32_t lodRanges[MAX_LODS][2];	// firstIndex and indexCount of each level; unused levels repeat the last one
+		uint32_t lodMeshlets[MAX_LODS][2];	// cluster mode: first meshlet in the meshlet table and count, likewise
+	};
+
+	// Meshlet table entry in cluster mode, std430; a copy of Model::Meshlets
+	struct MeshletData
+	{
+		glm::vec4 sphere;
+		glm::vec4 cone;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t padding[2];
+	};
+
+	struct CullConstants
+	{
+		glm::vec4 planes[6];
+		glm::vec4 cameraPosition;
+		uint32_t objectCount;
+	};
+
+	// occlusionCull.comp's, which has no room for the planes beside the view; it tests the frustum in view space
+	struct OcclusionConstants
+	{
+		glm::mat4 view;
+		glm::vec4 projection;	// [0][0], [1][1], [2][2] and [3][2] of the projection matrix
+		glm::vec2 pyramidSize;
+		uint32_t objectCount;
+		uint32_t meshCount;
+		uint32_t lateCommandOffset;
+		uint32_t late;
+	};
+
+	struct FrameResources
+	{
+		VkBuffer objectBuffer = VK_NULL_HANDLE;		// host written
+		VkDeviceMemory objectMemory = VK_NULL_HANDLE;
+		ObjectData* pObjects = nullptr;
+		uint32_t objectCapacity = 0;
+
+		VkBuffer meshBuffer = VK_NULL_HANDLE;		// host written
+		VkDeviceMemory meshMemory = VK_NULL_HANDLE;
+		MeshDraw* pMeshes = nullptr;
+
+		VkBuffer countBuffer = VK_NULL_HANDLE;		// one per mesh, written by the cull shader; see GetCountEntries
+		VkDeviceMemory countMemory = VK_NULL_HANDLE;
+		VkBuffer readbackBuffer = VK_NULL_HANDLE;	// copy of the counts for the host
+		VkDeviceMemory readbackMemory = VK_NULL_HANDLE;
+		const uint32_t* pReadback = nullptr;
+		uint32_t meshCapacity = 0;
+
+		VkBuffer meshletBuffer = VK_NULL_HANDLE;	// host written, cluster mode only
+		VkDeviceMemory meshletMemory = VK_NULL_HANDLE;
+		MeshletData* pMeshlets = nullptr;
+		uint32_t meshletCapacity = 0;
+		std::vector<const Model*> meshletSources;	// the meshes the table holds, by MeshId
+
+		VkBuffer drawBuffer = VK_NULL_HANDLE;		// one segment of draw commands per mesh
+		VkDeviceMemory drawMemory = VK_NULL_HANDLE;
+		uint32_t commandCapacity = 0;
+
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+		// As of the last Prepare of this slot
+		uint32_t objectCount = 0;
+		uint32_t clusterCount = 0;
+		uint32_t commandCount = 0;	// of one occlusion pass, where the late pass's segments start
+		std::vector<uint32_t> segmentSizes;	// commands per mesh, by MeshId: its objects, or their meshlets
+		uint32_t cpuVisible = 0;
+		bool bValidated = false;
+		bool bSubmitted = false;	// RecordCull ran since, so the readback holds its counts
+	};
+
+	void ReadBack( FrameResources& frame );
+	// Counts for meshCount meshes: one per mesh, or in occlusion mode one per mesh and pass and the occluded objects
+	uint32_t GetCountEntries( uint32_t meshCount ) const;
+	void RecordCountReadback( VkCommandBuffer commandBuffer, FrameResources& frame );
+	// Grow the slot's buffers to hold count entries; return whether they were recreated
+	bool ReserveObjects( FrameResources& frame, uint32_t count );
+	bool ReserveMeshes( FrameResources& frame, uint32_t count );
+	bool ReserveMeshlets( FrameResources& frame, uint32_t count );
+	bool ReserveCommands( FrameResources& frame, uint32_t count );
+	// Shared by every frame slot, so growing it waits for the device; clears it at the next cull
+	void ReserveVisibility( uint32_t count );
+	// Rewrites the meshlet table when the scene's meshes changed; returns whether its buffer was recreated
+	bool UpdateMeshletTable( FrameResources& frame, const Scene& scene );
+	void DestroyObjectBuffers( FrameResources& frame );
+	void DestroyMeshBuffers( FrameResources& frame );
+	void DestroyMeshletBuffer( FrameResources& frame );
+	void DestroyCommandBuffer( FrameResources& frame );
+	void DestroyVisibilityBuffer();
+	void WriteDescriptorSet( FrameResources& frame );
+	void WriteOcclusionSet();
+
+	VulkanGraphicsInstance* pGraphicsInstance = nullptr;
+	VkDevice device = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;	// owned by the DescriptorLayoutCache
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;	// owned by the PipelineLayoutCache
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	DescriptorAllocator descriptorAllocator;
+
+	PFN_vkCmdDrawIndexedIndirectCountKHR pfnDrawIndexedIndirectCount = nullptr;
+
+	uint32_t maxDrawCount = 0;	// maxDrawIndirectCount, which bounds a mesh's segment
+	uint32_t maxWorkGroupCount[2] = {};	// maxComputeWorkGroupCount x and y, which bound the objects of cluster mode
+
+	bool bClusterMode = false;
+	bool bOcclusionMode = false;
+
+	// Occlusion mode: set 1 of its pipeline, the depth pyramid and the visibility of every handle slot, written
+	// by each late pass for the next early one
+	VkDescriptorSetLayout occlusionSetLayout = VK_NULL_HANDLE;	// owned by the DescriptorLayoutCache
+	VkDescriptorSet occlusionSet = VK_NULL_HANDLE;
+	VkImageView depthPyramidView = VK_NULL_HANDLE;
+	VkSampler depthPyramidSampler = VK_NULL_HANDLE;
+	VkExtent2D depthPyramidExtent = {};
+	VkBuffer visibilityBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory visibilityMemory = VK_NULL_HANDLE;
+	uint32_t visibilityCapacity = 0;
+	bool bVisibilityCleared = false;
+
+	std::vector<FrameResources> Frames;
+
+	Statistics Stats;
+};
\ No newline at end of file
@@ -1 +0,0 @@
-#pragma once
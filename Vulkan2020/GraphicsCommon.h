@@ -1,4 +1,13 @@
 #pragma once
 
 #include "vulkan/vulkan.h"
-#include <glm/glm.hpp>
\ No newline at end of file
+#include <glm/glm.hpp>
+
+#include <functional>
+
+// boost::hash_combine, used to key the Vulkan object caches
+template<typename T>
+inline void HashCombine( size_t& seed, const T& value )
+{
+	seed ^= std::hash<T>()( value ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+}
\ No newline at end of file
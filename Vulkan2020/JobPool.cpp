@@ -0,0 +1,108 @@
+#include "JobPool.h"
+
+#include <algorithm>
+
+void JobPool::Init( uint32_t threadCount )
+{
+	if ( threadCount == 0 )
+	{
+		threadCount = std::max( std::thread::hardware_concurrency(), 2u ) - 1;
+	}
+
+	bShutdown = false;
+
+	for ( uint32_t i = 0; i < threadCount; ++i )
+	{
+		workers.emplace_back( &JobPool::WorkerMain, this );
+	}
+}
+
+void JobPool::Cleanup()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		bShutdown = true;
+	}
+
+	wakeCondition.notify_all();
+
+	for ( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+
+	workers.clear();
+}
+
+void JobPool::ParallelFor( uint32_t count, const std::function<void( uint32_t )>& job )
+{
+	if ( count == 0 )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		pJob = &job;
+		jobCount = count;
+		nextIndex = 0;
+		++generation;
+	}
+
+	wakeCondition.notify_all();
+
+	RunJobs( &job, count );
+
+	// Every index has been claimed; wait for workers still finishing theirs
+	std::unique_lock<std::mutex> lock( mutex );
+	doneCondition.wait( lock, [this]() { return busyWorkers == 0; } );
+
+	pJob = nullptr;
+	jobCount = 0;
+}
+
+void JobPool::WorkerMain()
+{
+	uint64_t seenGeneration = 0;
+
+	for ( ;; )
+	{
+		const std::function<void( uint32_t )>* pRunJob;
+		uint32_t count;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			wakeCondition.wait( lock, [&]() { return bShutdown || generation != seenGeneration; } );
+
+			if ( bShutdown )
+			{
+				return;
+			}
+
+			seenGeneration = generation;
+			pRunJob = pJob;
+			count = jobCount;
+			++busyWorkers;
+		}
+
+		// Woken after the batch already finished: leave nextIndex alone, the next batch may have reset it
+		if ( pRunJob != nullptr )
+		{
+			RunJobs( pRunJob, count );
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			--busyWorkers;
+		}
+
+		doneCondition.notify_all();
+	}
+}
+
+void JobPool::RunJobs( const std::function<void( uint32_t )>* pRunJob, uint32_t count )
+{
+	for ( uint32_t index = nextIndex++; index < count; index = nextIndex++ )
+	{
+		( *pRunJob )( index );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for fork/join work on the loading path. ParallelFor hands out
+// indices one at a time, so uneven jobs (a 4K JPEG next to a 64x64 PNG) balance themselves.
+class JobPool
+{
+public:
+	// threadCount 0 uses every hardware thread but the caller's, which joins in during ParallelFor
+	void Init( uint32_t threadCount = 0 );
+	void Cleanup();
+
+	// Runs job( i ) for every i in [0, count) on the workers and the calling thread; returns when all are done
+	void ParallelFor( uint32_t count, const std::function<void( uint32_t )>& job );
+
+	uint32_t GetThreadCount() const { return static_cast< uint32_t >( workers.size() ) + 1; }
+
+private:
+	void WorkerMain();
+	void RunJobs( const std::function<void( uint32_t )>* pRunJob, uint32_t count );
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	const std::function<void( uint32_t )>* pJob = nullptr;
+	uint32_t jobCount = 0;
+	std::atomic<uint32_t> nextIndex = { 0 };
+	uint32_t busyWorkers = 0;
+	uint64_t generation = 0;
+	bool bShutdown = false;
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "LayoutCache.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "GraphicsCommon.h"
+
+//////////////////////////////
+// DescriptorLayoutCache
+//////////////////////////////
+
+bool DescriptorLayoutCache::LayoutKey::operator==( const LayoutKey& other ) const
+{
+	if ( flags != other.flags || bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags )
+	{
+		return false;
+	}
+
+	for ( size_t i = 0; i < bindings.size(); ++i )
+	{
+		const VkDescriptorSetLayoutBinding& a = bindings[i];
+		const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+
+		if ( a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags || a.pImmutableSamplers != b.pImmutableSamplers )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t DescriptorLayoutCache::LayoutKeyHash::operator()( const LayoutKey& key ) const
+{
+	size_t seed = 0;
+	HashCombine( seed, key.flags );
+
+	for ( const VkDescriptorSetLayoutBinding& binding : key.bindings )
+	{
+		HashCombine( seed, binding.binding );
+		HashCombine( seed, static_cast< uint32_t >( binding.descriptorType ) );
+		HashCombine( seed, binding.descriptorCount );
+		HashCombine( seed, binding.stageFlags );
+	}
+
+	for ( VkDescriptorBindingFlags bindingFlag : key.bindingFlags )
+	{
+		HashCombine( seed, bindingFlag );
+	}
+
+	return seed;
+}
+
+void DescriptorLayoutCache::Init( VkDevice vulkanDevice )
+{
+	device = vulkanDevice;
+}
+
+void DescriptorLayoutCache::Cleanup()
+{
+	for ( auto& entry : layouts )
+	{
+		vkDestroyDescriptorSetLayout( device, entry.second, nullptr );
+	}
+
+	layouts.clear();
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::GetLayout( const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags, VkDescriptorSetLayoutCreateFlags flags )
+{
+	assert( ( bindingFlags.empty() || bindingFlags.size() == bindings.size() ) && "binding flags must match the bindings one to one!" );
+
+	LayoutKey key;
+	key.bindings = bindings;
+	key.bindingFlags = bindingFlags;
+	key.flags = flags;
+
+	// Order of declaration doesn't change the layout, so normalize it (keeping flags paired with their binding)
+	std::vector<size_t> order( bindings.size() );
+	for ( size_t i = 0; i < order.size(); ++i )
+	{
+		order[i] = i;
+	}
+	std::sort( order.begin(), order.end(), [&bindings]( size_t a, size_t b ) { return bindings[a].binding < bindings[b].binding; } );
+
+	for ( size_t i = 0; i < order.size(); ++i )
+	{
+		key.bindings[i] = bindings[order[i]];
+		if ( !bindingFlags.empty() )
+		{
+			key.bindingFlags[i] = bindingFlags[order[i]];
+		}
+	}
+
+	auto found = layouts.find( key );
+	if ( found != layouts.end() )
+	{
+		return found->second;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = static_cast< uint32_t >( key.bindingFlags.size() );
+	bindingFlagsInfo.pBindingFlags = key.bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = key.bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+	layoutInfo.flags = flags;
+	layoutInfo.bindingCount = static_cast< uint32_t >( key.bindings.size() );
+	layoutInfo.pBindings = key.bindings.data();
+
+	VkDescriptorSetLayout layout;
+	VkResult result = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &layout );
+	assert( VK_SUCCESS == result && "failed to create descriptor set layout!" );
+
+	layouts.emplace( std::move( key ), layout );
+
+	return layout;
+}
+
+//////////////////////////////
+// PipelineLayoutCache
+//////////////////////////////
+
+bool PipelineLayoutCache::LayoutKey::operator==( const LayoutKey& other ) const
+{
+	if ( setLayouts != other.setLayouts || pushConstantRanges.size() != other.pushConstantRanges.size() )
+	{
+		return false;
+	}
+
+	for ( size_t i = 0; i < pushConstantRanges.size(); ++i )
+	{
+		const VkPushConstantRange& a = pushConstantRanges[i];
+		const VkPushConstantRange& b = other.pushConstantRanges[i];
+
+		if ( a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t PipelineLayoutCache::LayoutKeyHash::operator()( const LayoutKey& key ) const
+{
+	size_t seed = 0;
+
+	for ( VkDescriptorSetLayout setLayout : key.setLayouts )
+	{
+		HashCombine( seed, setLayout );
+	}
+
+	for ( const VkPushConstantRange& range : key.pushConstantRanges )
+	{
+		HashCombine( seed, range.stageFlags );
+		HashCombine( seed, range.offset );
+		HashCombine( seed, range.size );
+	}
+
+	return seed;
+}
+
+void PipelineLayoutCache::Init( VkDevice vulkanDevice )
+{
+	device = vulkanDevice;
+}
+
+void PipelineLayoutCache::Cleanup()
+{
+	for ( auto& entry : layouts )
+	{
+		vkDestroyPipelineLayout( device, entry.second, nullptr );
+	}
+
+	layouts.clear();
+}
+
+VkPipelineLayout PipelineLayoutCache::GetLayout( const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges )
+{
+	LayoutKey key = { setLayouts, pushConstantRanges };
+
+	auto found = layouts.find( key );
+	if ( found != layouts.end() )
+	{
+		return found->second;
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast< uint32_t >( setLayouts.size() );
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast< uint32_t >( pushConstantRanges.size() );
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	VkPipelineLayout layout;
+	VkResult result = vkCreatePipelineLayout( device, &pipelineLayoutInfo, nullptr, &layout );
+	assert( VK_SUCCESS == result && "failed to create pipeline layout!" );
+
+	layouts.emplace( std::move( key ), layout );
+
+	return layout;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+// Creates each distinct VkDescriptorSetLayout once. Layouts built from the same bindings are the
+// same handle, which keeps pipeline layouts that use them compatible for descriptor set binding.
+// The cache owns every layout it returns; they live until Cleanup.
+class DescriptorLayoutCache
+{
+public:
+	void Init( VkDevice device );
+	void Cleanup();
+
+	// bindingFlags is either empty or one entry per binding (VkDescriptorSetLayoutBindingFlagsCreateInfo)
+	VkDescriptorSetLayout GetLayout( const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags = {}, VkDescriptorSetLayoutCreateFlags flags = 0 );
+
+	uint32_t GetLayoutCount() const { return static_cast< uint32_t >( layouts.size() ); }
+
+private:
+	struct LayoutKey
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;	// sorted by binding
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+		VkDescriptorSetLayoutCreateFlags flags;
+
+		bool operator==( const LayoutKey& other ) const;
+	};
+
+	struct LayoutKeyHash
+	{
+		size_t operator()( const LayoutKey& key ) const;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+};
+
+// Same idea for VkPipelineLayout, keyed on the set layouts and push constant ranges. Pipelines that
+// share a layout (or a prefix of set layouts) keep their bound descriptor sets across vkCmdBindPipeline.
+class PipelineLayoutCache
+{
+public:
+	void Init( VkDevice device );
+	void Cleanup();
+
+	VkPipelineLayout GetLayout( const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges );
+
+	uint32_t GetLayoutCount() const { return static_cast< uint32_t >( layouts.size() ); }
+
+private:
+	struct LayoutKey
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+
+		bool operator==( const LayoutKey& other ) const;
+	};
+
+	struct LayoutKeyHash
+	{
+		size_t operator()( const LayoutKey& key ) const;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	std::unordered_map<LayoutKey, VkPipelineLayout, LayoutKeyHash> layouts;
+};
\ No newline at end of file
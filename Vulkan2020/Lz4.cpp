@@ -0,0 +1,260 @@
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t LAST_LITERALS = 5;		// a block always ends in at least this many literals
+	constexpr size_t MATCH_FIND_LIMIT = 12;	// and its last match starts at least this far from the end
+	constexpr size_t MAX_OFFSET = 65535;
+	constexpr uint32_t HASH_BITS = 16;
+	constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+	uint32_t Read32( const uint8_t* p )
+	{
+		uint32_t value;
+		memcpy( &value, p, sizeof( value ) );
+		return value;
+	}
+
+	uint32_t Hash( uint32_t sequence )
+	{
+		return ( sequence * 2654435761u ) >> ( 32 - HASH_BITS );
+	}
+
+	// Writes the 255-run continuation of a length whose 4 bit token field is saturated
+	bool WriteLength( size_t length, uint8_t*& op, const uint8_t* opEnd )
+	{
+		for ( ; length >= 255; length -= 255 )
+		{
+			if ( op >= opEnd )
+			{
+				return false;
+			}
+
+			*op++ = 255;
+		}
+
+		if ( op >= opEnd )
+		{
+			return false;
+		}
+
+		*op++ = static_cast< uint8_t >( length );
+		return true;
+	}
+
+	bool ReadLength( const uint8_t*& ip, const uint8_t* ipEnd, size_t& length )
+	{
+		uint8_t byte;
+
+		do
+		{
+			if ( ip >= ipEnd )
+			{
+				return false;
+			}
+
+			byte = *ip++;
+			length += byte;
+		}
+		while ( byte == 255 );
+
+		return true;
+	}
+
+	bool WriteSequence( const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength, uint8_t*& op, const uint8_t* opEnd )
+	{
+		if ( op >= opEnd )
+		{
+			return false;
+		}
+
+		uint8_t* token = op++;
+		*token = static_cast< uint8_t >( std::min<size_t>( literalLength, 15 ) << 4 );
+
+		if ( literalLength >= 15 && !WriteLength( literalLength - 15, op, opEnd ) )
+		{
+			return false;
+		}
+
+		if ( static_cast< size_t >( opEnd - op ) < literalLength )
+		{
+			return false;
+		}
+
+		if ( literalLength > 0 )
+		{
+			memcpy( op, literals, literalLength );
+			op += literalLength;
+		}
+
+		// The last sequence is literals only
+		if ( matchLength == 0 )
+		{
+			return true;
+		}
+
+		if ( opEnd - op < 2 )
+		{
+			return false;
+		}
+
+		*op++ = static_cast< uint8_t >( offset );
+		*op++ = static_cast< uint8_t >( offset >> 8 );
+
+		size_t matchCode = matchLength - MIN_MATCH;
+		*token |= static_cast< uint8_t >( std::min<size_t>( matchCode, 15 ) );
+
+		return matchCode < 15 || WriteLength( matchCode - 15, op, opEnd );
+	}
+}
+
+size_t Lz4::CompressBound( size_t size )
+{
+	return size + size / 255 + 16;
+}
+
+size_t Lz4::Compress( const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity )
+{
+	uint8_t* op = dst;
+	const uint8_t* opEnd = dst + dstCapacity;
+
+	size_t anchor = 0;
+
+	// Greedy parse: one hash table of the last position each 4 byte sequence was seen at
+	if ( srcSize > MATCH_FIND_LIMIT )
+	{
+		std::vector<uint32_t> table( size_t( 1 ) << HASH_BITS, NO_POSITION );
+
+		const size_t matchLimit = srcSize - LAST_LITERALS;
+		const size_t searchEnd = srcSize - MATCH_FIND_LIMIT;
+
+		size_t ip = 0;
+
+		while ( ip <= searchEnd )
+		{
+			uint32_t sequence = Read32( src + ip );
+			uint32_t& slot = table[Hash( sequence )];
+			size_t ref = slot;
+			slot = static_cast< uint32_t >( ip );
+
+			if ( ref == NO_POSITION || ip - ref > MAX_OFFSET || Read32( src + ref ) != sequence )
+			{
+				++ip;
+				continue;
+			}
+
+			// Extend backwards into pending literals, then forwards
+			while ( ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1] )
+			{
+				--ip;
+				--ref;
+			}
+
+			size_t matchLength = MIN_MATCH;
+			while ( ip + matchLength < matchLimit && src[ref + matchLength] == src[ip + matchLength] )
+			{
+				++matchLength;
+			}
+
+			if ( !WriteSequence( src + anchor, ip - anchor, ip - ref, matchLength, op, opEnd ) )
+			{
+				return 0;
+			}
+
+			ip += matchLength;
+			anchor = ip;
+
+			// Seed the table inside the match so the next one can chain off it
+			if ( ip - 2 <= searchEnd )
+			{
+				table[Hash( Read32( src + ip - 2 ) )] = static_cast< uint32_t >( ip - 2 );
+			}
+		}
+	}
+
+	if ( !WriteSequence( src + anchor, srcSize - anchor, 0, 0, op, opEnd ) )
+	{
+		return 0;
+	}
+
+	return static_cast< size_t >( op - dst );
+}
+
+bool Lz4::Decompress( const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize )
+{
+	const uint8_t* ip = src;
+	const uint8_t* ipEnd = src + srcSize;
+	uint8_t* op = dst;
+	uint8_t* opEnd = dst + dstSize;
+
+	while ( ip < ipEnd )
+	{
+		uint8_t token = *ip++;
+
+		size_t literalLength = token >> 4;
+		if ( literalLength == 15 && !ReadLength( ip, ipEnd, literalLength ) )
+		{
+			return false;
+		}
+
+		if ( static_cast< size_t >( ipEnd - ip ) < literalLength || static_cast< size_t >( opEnd - op ) < literalLength )
+		{
+			return false;
+		}
+
+		if ( literalLength > 0 )
+		{
+			memcpy( op, ip, literalLength );
+			ip += literalLength;
+			op += literalLength;
+		}
+
+		// The last sequence has no match
+		if ( ip == ipEnd )
+		{
+			break;
+		}
+
+		if ( ipEnd - ip < 2 )
+		{
+			return false;
+		}
+
+		size_t offset = ip[0] | ( ip[1] << 8 );
+		ip += 2;
+
+		if ( offset == 0 || offset > static_cast< size_t >( op - dst ) )
+		{
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if ( matchLength == 15 && !ReadLength( ip, ipEnd, matchLength ) )
+		{
+			return false;
+		}
+
+		matchLength += MIN_MATCH;
+
+		if ( static_cast< size_t >( opEnd - op ) < matchLength )
+		{
+			return false;
+		}
+
+		// Byte by byte: the match may overlap the bytes it is producing (offset < length repeats a run)
+		const uint8_t* match = op - offset;
+		for ( size_t i = 0; i < matchLength; ++i )
+		{
+			op[i] = match[i];
+		}
+
+		op += matchLength;
+	}
+
+	return op == opEnd;
+}
\ No newline at end of file
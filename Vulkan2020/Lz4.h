@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format (no frame header), compatible with LZ4_compress_default / LZ4_decompress_safe.
+// Used for asset archive entries: decompression runs at memory speed, so compressed text and
+// mesh data loads faster than reading it raw from a slow disk or network mount.
+namespace Lz4
+{
+	// Worst case compressed size for incompressible input
+	size_t CompressBound( size_t size );
+
+	// Returns the compressed size, or 0 if it doesn't fit in dstCapacity
+	size_t Compress( const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity );
+
+	// dstSize is the exact decompressed size; false on malformed or truncated input
+	bool Decompress( const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize );
+}
\ No newline at end of file
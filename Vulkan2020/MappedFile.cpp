@@ -0,0 +1,173 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile( MappedFile&& other ) noexcept
+	: pData( other.pData ), size( other.size ), bOpen( other.bOpen )
+{
+	other.pData = nullptr;
+	other.size = 0;
+	other.bOpen = false;
+}
+
+MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept
+{
+	if ( this != &other )
+	{
+		Close();
+
+		pData = other.pData;
+		size = other.size;
+		bOpen = other.bOpen;
+
+		other.pData = nullptr;
+		other.size = 0;
+		other.bOpen = false;
+	}
+
+	return *this;
+}
+
+bool MappedFile::Open( const std::string& filename, AccessPattern pattern )
+{
+	Close();
+
+#ifdef _WIN32
+	// Windows takes the access hint when the file is opened, for the cache manager's read-ahead
+	DWORD flags = FILE_ATTRIBUTE_NORMAL;
+	if ( pattern == AccessPattern::Sequential )
+	{
+		flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+	}
+	else if ( pattern == AccessPattern::Random )
+	{
+		flags |= FILE_FLAG_RANDOM_ACCESS;
+	}
+
+	HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr );
+	if ( file == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	bOpen = GetFileSizeEx( file, &fileSize ) != 0;
+	size = bOpen ? static_cast< size_t >( fileSize.QuadPart ) : 0;
+
+	// Zero length files can't be mapped; they open as an empty view
+	if ( bOpen && size > 0 )
+	{
+		HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( mapping != nullptr )
+		{
+			pData = static_cast< const uint8_t* >( MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+
+			// The view holds its own reference to the mapping
+			CloseHandle( mapping );
+		}
+
+		bOpen = pData != nullptr;
+	}
+
+	CloseHandle( file );
+#else
+	int file = open( filename.c_str(), O_RDONLY );
+	if ( file < 0 )
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	bOpen = fstat( file, &fileStat ) == 0;
+	size = bOpen ? static_cast< size_t >( fileStat.st_size ) : 0;
+
+	// Zero length files can't be mapped; they open as an empty view
+	if ( bOpen && size > 0 )
+	{
+		void* pMapping = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, file, 0 );
+		bOpen = pMapping != MAP_FAILED;
+
+		if ( bOpen )
+		{
+			pData = static_cast< const uint8_t* >( pMapping );
+
+			int advice = MADV_NORMAL;
+			if ( pattern == AccessPattern::Sequential )
+			{
+				advice = MADV_SEQUENTIAL;
+			}
+			else if ( pattern == AccessPattern::Random )
+			{
+				advice = MADV_RANDOM;
+			}
+
+			madvise( pMapping, size, advice );
+		}
+	}
+
+	// The mapping holds its own reference to the file
+	close( file );
+#endif
+
+	if ( !bOpen )
+	{
+		size = 0;
+	}
+
+	return bOpen;
+}
+
+void MappedFile::Close()
+{
+	if ( pData != nullptr )
+	{
+#ifdef _WIN32
+		UnmapViewOfFile( pData );
+#else
+		munmap( const_cast< uint8_t* >( pData ), size );
+#endif
+	}
+
+	pData = nullptr;
+	size = 0;
+	bOpen = false;
+}
+
+void MappedFile::Prefetch( size_t offset, size_t byteCount ) const
+{
+	if ( pData == nullptr || offset >= size )
+	{
+		return;
+	}
+
+	byteCount = std::min( byteCount, size - offset );
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast< uint8_t* >( pData + offset );
+	range.NumberOfBytes = byteCount;
+
+	PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+#else
+	// madvise wants a page aligned start
+	size_t pageSize = static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+	size_t alignedOffset = offset / pageSize * pageSize;
+
+	madvise( const_cast< uint8_t* >( pData + alignedOffset ), byteCount + ( offset - alignedOffset ), MADV_WILLNEED );
+#endif
+}
\ No newline at end of file
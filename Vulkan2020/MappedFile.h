@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file through the OS page cache: no read buffer, no heap copy, and
+// pages fault in on first touch (on whichever thread touches them). Unmapped on destruction.
+class MappedFile
+{
+public:
+	enum class AccessPattern
+	{
+		Normal,
+		Sequential,	// read front to back once: aggressive read-ahead, pages dropped early
+		Random,		// e.g. reading a few levels out of a large container: no read-ahead
+	};
+
+	MappedFile() = default;
+	explicit MappedFile( const std::string& filename, AccessPattern pattern = AccessPattern::Sequential ) { Open( filename, pattern ); }
+	~MappedFile() { Close(); }
+
+	MappedFile( MappedFile&& other ) noexcept;
+	MappedFile& operator=( MappedFile&& other ) noexcept;
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	bool Open( const std::string& filename, AccessPattern pattern = AccessPattern::Sequential );
+	void Close();
+
+	// Starts reading [offset, offset + byteCount) in the background, ahead of use
+	void Prefetch( size_t offset, size_t byteCount ) const;
+
+	bool IsOpen() const { return bOpen; }
+	const uint8_t* GetData() const { return pData; }	// nullptr for an empty file
+	size_t GetSize() const { return size; }
+
+private:
+	const uint8_t* pData = nullptr;
+	size_t size = 0;
+	bool bOpen = false;
+};
\ No newline at end of file
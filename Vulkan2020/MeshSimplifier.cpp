@@ -0,0 +1,389 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+#include "ModelClass.h"
+
+namespace
+{
+	// GenerateLods stops once a level would need more error than this fraction of the mesh's bounding radius
+	constexpr float MAX_LOD_ERROR = 0.05f;
+	// A level that removes less than this fraction of the previous one's triangles isn't worth its indices
+	constexpr float MIN_LOD_REDUCTION = 0.25f;
+	constexpr size_t MIN_LOD_TRIANGLES = 16;
+
+	// A collapse is rejected if it turns any remaining triangle around the moved vertex by more than about 75 degrees
+	constexpr float MIN_NORMAL_COSINE = 0.25f;
+
+	// Symmetric 4x4 matrix summing squared distances to planes, each weighted by its triangle's area. Doubles,
+	// since evaluating it cancels large terms. w is the summed weight, so Evaluate / w is a mean squared distance.
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double w = 0.0;
+
+		void AddPlane( const glm::vec3& normal, float distance, float weight )
+		{
+			a00 += weight * normal.x * normal.x;
+			a11 += weight * normal.y * normal.y;
+			a22 += weight * normal.z * normal.z;
+			a01 += weight * normal.x * normal.y;
+			a02 += weight * normal.x * normal.z;
+			a12 += weight * normal.y * normal.z;
+			b0 += weight * normal.x * distance;
+			b1 += weight * normal.y * distance;
+			b2 += weight * normal.z * distance;
+			c += weight * distance * distance;
+			w += weight;
+		}
+
+		void Add( const Quadric& other )
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			w += other.w;
+		}
+
+		double Evaluate( const glm::vec3& point ) const
+		{
+			const double x = point.x, y = point.y, z = point.z;
+			const double value = a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * ( a01 * x * y + a02 * x * z + a12 * y * z )
+				+ 2.0 * ( b0 * x + b1 * y + b2 * z ) + c;
+
+			return std::max( value, 0.0 );
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float error;	// mean squared distance
+	};
+
+	float GetCollapseError( const Quadric& from, const Quadric& to, const glm::vec3& position )
+	{
+		const double weight = from.w + to.w;
+		return weight > 0.0 ? static_cast< float >( ( from.Evaluate( position ) + to.Evaluate( position ) ) / weight ) : 0.0f;
+	}
+
+	uint64_t GetEdgeKey( uint32_t a, uint32_t b )
+	{
+		return ( static_cast< uint64_t >( a ) << 32 ) | b;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify( const std::vector<Vertex>& vertices, const uint32_t* pIndices, size_t indexCount, size_t targetIndexCount, float maxError, float* pResultError )
+{
+	const uint32_t vertexCount = static_cast< uint32_t >( vertices.size() );
+
+	std::vector<uint32_t> indices;
+	indices.reserve( indexCount );
+
+	for ( size_t i = 0; i + 2 < indexCount; i += 3 )
+	{
+		if ( pIndices[i] != pIndices[i + 1] && pIndices[i] != pIndices[i + 2] && pIndices[i + 1] != pIndices[i + 2] )
+		{
+			indices.insert( indices.end(), pIndices + i, pIndices + i + 3 );
+		}
+	}
+
+	// Weld by position: the vertices of a seam share one quadric and are all locked
+	std::vector<uint32_t> order( vertexCount );
+	std::iota( order.begin(), order.end(), 0 );
+	std::sort( order.begin(), order.end(), [&vertices]( uint32_t a, uint32_t b )
+	{
+		const glm::vec3& positionA = vertices[a].pos;
+		const glm::vec3& positionB = vertices[b].pos;
+		return std::tie( positionA.x, positionA.y, positionA.z ) < std::tie( positionB.x, positionB.y, positionB.z );
+	} );
+
+	std::vector<uint32_t> positionIds( vertexCount );
+	std::vector<bool> bLocked( vertexCount, false );
+
+	for ( size_t first = 0; first < order.size(); )
+	{
+		size_t last = first + 1;
+
+		while ( last < order.size() && vertices[order[last]].pos == vertices[order[first]].pos )
+		{
+			++last;
+		}
+
+		for ( size_t i = first; i < last; ++i )
+		{
+			positionIds[order[i]] = order[first];
+			bLocked[order[i]] = last - first > 1;
+		}
+
+		first = last;
+	}
+
+	// Open and non-manifold edges: every edge of a closed manifold is used once in each direction
+	std::unordered_map<uint64_t, uint32_t> edgeUses;
+	edgeUses.reserve( indices.size() );
+
+	for ( size_t t = 0; t < indices.size(); t += 3 )
+	{
+		for ( size_t e = 0; e < 3; ++e )
+		{
+			++edgeUses[GetEdgeKey( positionIds[indices[t + e]], positionIds[indices[t + ( e + 1 ) % 3]] )];
+		}
+	}
+
+	for ( size_t t = 0; t < indices.size(); t += 3 )
+	{
+		for ( size_t e = 0; e < 3; ++e )
+		{
+			const uint32_t a = indices[t + e];
+			const uint32_t b = indices[t + ( e + 1 ) % 3];
+			const auto reverse = edgeUses.find( GetEdgeKey( positionIds[b], positionIds[a] ) );
+
+			if ( edgeUses[GetEdgeKey( positionIds[a], positionIds[b] )] != 1 || reverse == edgeUses.end() || reverse->second != 1 )
+			{
+				bLocked[a] = true;
+				bLocked[b] = true;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics( vertexCount );
+
+	for ( size_t t = 0; t < indices.size(); t += 3 )
+	{
+		const glm::vec3& p0 = vertices[indices[t]].pos;
+		const glm::vec3 normal = glm::cross( vertices[indices[t + 1]].pos - p0, vertices[indices[t + 2]].pos - p0 );
+		const float length = glm::length( normal );
+
+		if ( length == 0.0f )
+		{
+			continue;
+		}
+
+		Quadric quadric;
+		quadric.AddPlane( normal / length, -glm::dot( normal / length, p0 ), length * 0.5f );
+
+		for ( size_t i = 0; i < 3; ++i )
+		{
+			quadrics[positionIds[indices[t + i]]].Add( quadric );
+		}
+	}
+
+	const float maxErrorSquared = maxError * maxError;
+	float resultError = 0.0f;
+
+	std::vector<uint32_t> triangleOffsets( vertexCount + 1 );
+	std::vector<uint32_t> vertexTriangles;
+	std::vector<uint32_t> remap( vertexCount );
+	std::vector<bool> bTouched( vertexCount );
+	std::vector<Collapse> collapses;
+
+	// Whether moving from onto to leaves every other triangle around from facing roughly the same way
+	auto IsCollapseValid = [&]( uint32_t from, uint32_t to )
+	{
+		for ( uint32_t i = triangleOffsets[from]; i < triangleOffsets[from + 1]; ++i )
+		{
+			const uint32_t* pTriangle = &indices[vertexTriangles[i]];
+
+			if ( pTriangle[0] == to || pTriangle[1] == to || pTriangle[2] == to )
+			{
+				continue;	// collapses away
+			}
+
+			glm::vec3 positions[3];
+			glm::vec3 movedPositions[3];
+
+			for ( size_t v = 0; v < 3; ++v )
+			{
+				positions[v] = vertices[pTriangle[v]].pos;
+				movedPositions[v] = pTriangle[v] == from ? vertices[to].pos : positions[v];
+			}
+
+			const glm::vec3 normal = glm::cross( positions[1] - positions[0], positions[2] - positions[0] );
+			const glm::vec3 movedNormal = glm::cross( movedPositions[1] - movedPositions[0], movedPositions[2] - movedPositions[0] );
+
+			if ( glm::dot( normal, movedNormal ) <= MIN_NORMAL_COSINE * glm::length( normal ) * glm::length( movedNormal ) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	// Passes of independent collapses: once a vertex moves, its whole one-ring waits for the next pass,
+	// so every flip test sees current positions
+	while ( indices.size() > targetIndexCount )
+	{
+		std::fill( triangleOffsets.begin(), triangleOffsets.end(), 0 );
+
+		for ( uint32_t index : indices )
+		{
+			++triangleOffsets[index + 1];
+		}
+
+		for ( uint32_t v = 0; v < vertexCount; ++v )
+		{
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		}
+
+		vertexTriangles.resize( indices.size() );
+		std::vector<uint32_t> cursors( triangleOffsets.begin(), triangleOffsets.end() - 1 );
+
+		for ( size_t t = 0; t < indices.size(); t += 3 )
+		{
+			for ( size_t i = 0; i < 3; ++i )
+			{
+				vertexTriangles[cursors[indices[t + i]]++] = static_cast< uint32_t >( t );
+			}
+		}
+
+		// Both directions of every edge; interior edges come up once from each side, which the touched flags dedupe
+		collapses.clear();
+
+		for ( size_t t = 0; t < indices.size(); t += 3 )
+		{
+			for ( size_t e = 0; e < 3; ++e )
+			{
+				const uint32_t a = indices[t + e];
+				const uint32_t b = indices[t + ( e + 1 ) % 3];
+
+				for ( const auto& [from, to] : { std::make_pair( a, b ), std::make_pair( b, a ) } )
+				{
+					if ( bLocked[from] )
+					{
+						continue;
+					}
+
+					const float error = GetCollapseError( quadrics[from], quadrics[positionIds[to]], vertices[to].pos );
+
+					if ( error <= maxErrorSquared )
+					{
+						collapses.push_back( { from, to, error } );
+					}
+				}
+			}
+		}
+
+		std::sort( collapses.begin(), collapses.end(), []( const Collapse& a, const Collapse& b ) { return a.error < b.error; } );
+
+		std::iota( remap.begin(), remap.end(), 0 );
+		std::fill( bTouched.begin(), bTouched.end(), false );
+
+		const size_t removeBudget = ( indices.size() - targetIndexCount + 2 ) / 3;
+		size_t removedTriangles = 0;
+		size_t collapseCount = 0;
+
+		for ( const Collapse& collapse : collapses )
+		{
+			if ( removedTriangles >= removeBudget )
+			{
+				break;
+			}
+
+			if ( bTouched[collapse.from] || bTouched[collapse.to] || !IsCollapseValid( collapse.from, collapse.to ) )
+			{
+				continue;
+			}
+
+			for ( uint32_t i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; ++i )
+			{
+				const uint32_t* pTriangle = &indices[vertexTriangles[i]];
+
+				if ( pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to )
+				{
+					++removedTriangles;
+				}
+
+				bTouched[pTriangle[0]] = true;
+				bTouched[pTriangle[1]] = true;
+				bTouched[pTriangle[2]] = true;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[positionIds[collapse.to]].Add( quadrics[collapse.from] );
+			resultError = std::max( resultError, collapse.error );
+			++collapseCount;
+		}
+
+		if ( collapseCount == 0 )
+		{
+			break;
+		}
+
+		size_t writeIndex = 0;
+
+		for ( size_t t = 0; t < indices.size(); t += 3 )
+		{
+			const uint32_t a = remap[indices[t]];
+			const uint32_t b = remap[indices[t + 1]];
+			const uint32_t c = remap[indices[t + 2]];
+
+			if ( a != b && a != c && b != c )
+			{
+				indices[writeIndex++] = a;
+				indices[writeIndex++] = b;
+				indices[writeIndex++] = c;
+			}
+		}
+
+		indices.resize( writeIndex );
+	}
+
+	if ( pResultError )
+	{
+		*pResultError = std::sqrt( resultError );
+	}
+
+	return indices;
+}
+
+void MeshSimplifier::GenerateLods( const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t baseIndexCount, float meshRadius, std::vector<MeshLod>& lods )
+{
+	lods.clear();
+	lods.push_back( { 0, baseIndexCount, 0.0f, 0, 0 } );
+
+	std::vector<uint32_t> source( indices.begin(), indices.begin() + baseIndexCount );
+	float accumulatedError = 0.0f;
+
+	while ( lods.size() < MAX_MESH_LODS )
+	{
+		const size_t targetIndexCount = source.size() / 6 * 3;
+
+		if ( targetIndexCount < MIN_LOD_TRIANGLES * 3 )
+		{
+			break;
+		}
+
+		// Each level simplifies the one before, so errors add up along the chain
+		float error = 0.0f;
+		std::vector<uint32_t> simplified = Simplify( vertices, source.data(), source.size(), targetIndexCount, std::max( meshRadius * MAX_LOD_ERROR - accumulatedError, 0.0f ), &error );
+
+		if ( static_cast< float >( simplified.size() ) > static_cast< float >( source.size() ) * ( 1.0f - MIN_LOD_REDUCTION ) )
+		{
+			break;
+		}
+
+		accumulatedError += error;
+
+		MeshLod lod;
+		lod.firstIndex = static_cast< uint32_t >( indices.size() );
+		lod.indexCount = static_cast< uint32_t >( simplified.size() );
+		lod.error = meshRadius > 0.0f ? accumulatedError / meshRadius : 0.0f;
+		lod.firstMeshlet = 0;
+		lod.meshletCount = 0;
+
+		indices.insert( indices.end(), simplified.begin(), simplified.end() );
+		lods.push_back( lod );
+		source.swap( simplified );
+	}
+}
\ No newline at end of file
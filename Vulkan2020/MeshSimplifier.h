@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Vertex;
+struct MeshLod;
+
+// Quadric error metric simplification (Garland and Heckbert) with half edge collapses: a vertex only
+// ever moves onto one of its neighbours, so a simplified index list still indexes the original
+// vertex buffer and every level of detail of a model shares one set of vertices.
+//
+// Vertices on open borders, non-manifold edges or attribute seams (the same position split for a
+// different UV or colour) never move, which keeps silhouettes and texture mapping intact at the cost
+// of how far some meshes reduce.
+namespace MeshSimplifier
+{
+	// Collapses edges cheapest first until at most targetIndexCount indices are left or the next collapse
+	// would move the surface further than maxError (model units). pResultError receives the largest error
+	// of any collapse made, as an estimated distance between the input and output surfaces.
+	std::vector<uint32_t> Simplify( const std::vector<Vertex>& vertices, const uint32_t* pIndices, size_t indexCount, size_t targetIndexCount, float maxError, float* pResultError = nullptr );
+
+	// Builds up to MAX_MESH_LODS levels from indices [0, baseIndexCount): level 0 is that range, each further
+	// level halves the previous one's triangles and is appended to indices. Stops early once a level stops
+	// shrinking (seams and borders locked) or would need more than a few percent of meshRadius of error.
+	void GenerateLods( const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t baseIndexCount, float meshRadius, std::vector<MeshLod>& lods );
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FileUtils.h"
+#include "ModelClass.h"
+
+namespace
+{
+	constexpr uint32_t NO_TRIANGLE = UINT32_MAX;
+	constexpr uint32_t NO_MESHLET = UINT32_MAX;
+
+	// Bounding sphere as FileUtils::ComputeBounds makes it, and the cone around the facing of every non-degenerate triangle
+	void ComputeMeshletBounds( const std::vector<Vertex>& vertices, const uint32_t* pIndices, Meshlet& meshlet )
+	{
+		const MeshBounds bounds = FileUtils::ComputeBounds( vertices, pIndices, meshlet.indexCount );
+		meshlet.sphere = glm::vec4( bounds.center, bounds.radius );
+		meshlet.cone = glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+
+		glm::vec3 normals[MESHLET_MAX_TRIANGLES];
+		uint32_t normalCount = 0;
+		glm::vec3 axis( 0.0f );
+
+		for ( uint32_t i = 0; i < meshlet.indexCount; i += 3 )
+		{
+			const glm::vec3& p0 = vertices[pIndices[i]].pos;
+			const glm::vec3 normal = glm::cross( vertices[pIndices[i + 1]].pos - p0, vertices[pIndices[i + 2]].pos - p0 );
+			const float length = glm::length( normal );
+
+			if ( length > 0.0f )
+			{
+				normals[normalCount] = normal / length;
+				axis += normals[normalCount];
+				++normalCount;
+			}
+		}
+
+		const float axisLength = glm::length( axis );
+
+		if ( axisLength == 0.0f )
+		{
+			return;
+		}
+
+		axis /= axisLength;
+
+		float minCosine = 1.0f;
+		for ( uint32_t i = 0; i < normalCount; ++i )
+		{
+			minCosine = std::min( minCosine, glm::dot( axis, normals[i] ) );
+		}
+
+		// Facings over 90 degrees from the axis leave no direction every triangle faces away from
+		if ( minCosine > 0.0f )
+		{
+			meshlet.cone = glm::vec4( axis, std::sqrt( 1.0f - minCosine * minCosine ) );
+		}
+	}
+}
+
+void MeshletBuilder::BuildRange( const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount, std::vector<Meshlet>& meshlets )
+{
+	const uint32_t triangleCount = indexCount / 3;
+	const uint32_t* pIndices = indices.data() + firstIndex;
+
+	// Local vertex ids, so the scratch arrays scale with the range rather than the whole vertex buffer
+	std::vector<uint32_t> rangeVertices( pIndices, pIndices + triangleCount * 3 );
+	std::sort( rangeVertices.begin(), rangeVertices.end() );
+	rangeVertices.erase( std::unique( rangeVertices.begin(), rangeVertices.end() ), rangeVertices.end() );
+
+	const uint32_t vertexCount = static_cast< uint32_t >( rangeVertices.size() );
+	std::vector<uint32_t> corners( triangleCount * 3 );
+
+	for ( uint32_t i = 0; i < corners.size(); ++i )
+	{
+		corners[i] = static_cast< uint32_t >( std::lower_bound( rangeVertices.begin(), rangeVertices.end(), pIndices[i] ) - rangeVertices.begin() );
+	}
+
+	// Triangles around each local vertex
+	std::vector<uint32_t> triangleOffsets( vertexCount + 1, 0 );
+	std::vector<uint32_t> vertexTriangles( corners.size() );
+
+	for ( uint32_t corner : corners )
+	{
+		++triangleOffsets[corner + 1];
+	}
+
+	for ( uint32_t v = 0; v < vertexCount; ++v )
+	{
+		triangleOffsets[v + 1] += triangleOffsets[v];
+	}
+
+	std::vector<uint32_t> cursors( triangleOffsets.begin(), triangleOffsets.end() - 1 );
+
+	for ( uint32_t i = 0; i < corners.size(); ++i )
+	{
+		vertexTriangles[cursors[corners[i]]++] = i / 3;
+	}
+
+	std::vector<bool> bEmitted( triangleCount, false );
+	std::vector<uint32_t> vertexMeshlets( vertexCount, NO_MESHLET );	// last meshlet each vertex joined
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> meshletVertices;
+	order.reserve( triangleCount );
+	meshletVertices.reserve( MESHLET_MAX_VERTICES );
+
+	const size_t firstMeshlet = meshlets.size();
+	uint32_t seed = 0;
+
+	for ( uint32_t meshletIndex = 0; ; ++meshletIndex )
+	{
+		while ( seed < triangleCount && bEmitted[seed] )
+		{
+			++seed;
+		}
+
+		if ( seed == triangleCount )
+		{
+			break;
+		}
+
+		const uint32_t meshletStart = static_cast< uint32_t >( order.size() );
+		meshletVertices.clear();
+
+		auto CountNewVertices = [&]( uint32_t triangle )
+		{
+			uint32_t count = 0;
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				count += vertexMeshlets[corners[triangle * 3 + k]] != meshletIndex ? 1 : 0;
+			}
+			return count;
+		};
+
+		for ( uint32_t triangle = seed; triangle != NO_TRIANGLE; )
+		{
+			bEmitted[triangle] = true;
+			order.push_back( triangle );
+
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				const uint32_t vertex = corners[triangle * 3 + k];
+
+				if ( vertexMeshlets[vertex] != meshletIndex )
+				{
+					vertexMeshlets[vertex] = meshletIndex;
+					meshletVertices.push_back( vertex );
+				}
+			}
+
+			if ( order.size() - meshletStart == MESHLET_MAX_TRIANGLES )
+			{
+				break;
+			}
+
+			// The unemitted neighbour that adds the fewest vertices and still fits; none ends the meshlet
+			uint32_t best = NO_TRIANGLE;
+			uint32_t bestNewVertices = 3;
+
+			for ( size_t i = 0; i < meshletVertices.size() && bestNewVertices > 0; ++i )
+			{
+				const uint32_t vertex = meshletVertices[i];
+
+				for ( uint32_t j = triangleOffsets[vertex]; j < triangleOffsets[vertex + 1]; ++j )
+				{
+					const uint32_t candidate = vertexTriangles[j];
+
+					if ( bEmitted[candidate] )
+					{
+						continue;
+					}
+
+					const uint32_t newVertices = CountNewVertices( candidate );
+
+					if ( newVertices < bestNewVertices && meshletVertices.size() + newVertices <= MESHLET_MAX_VERTICES )
+					{
+						best = candidate;
+						bestNewVertices = newVertices;
+					}
+				}
+			}
+
+			triangle = best;
+		}
+
+		Meshlet meshlet = {};
+		meshlet.firstIndex = firstIndex + meshletStart * 3;
+		meshlet.indexCount = static_cast< uint32_t >( order.size() - meshletStart ) * 3;
+		meshlets.push_back( meshlet );
+	}
+
+	std::vector<uint32_t> reordered( order.size() * 3 );
+
+	for ( uint32_t i = 0; i < order.size(); ++i )
+	{
+		std::copy( pIndices + order[i] * 3, pIndices + order[i] * 3 + 3, reordered.begin() + i * 3 );
+	}
+
+	std::copy( reordered.begin(), reordered.end(), indices.begin() + firstIndex );
+
+	for ( size_t i = firstMeshlet; i < meshlets.size(); ++i )
+	{
+		ComputeMeshletBounds( vertices, indices.data() + meshlets[i].firstIndex, meshlets[i] );
+	}
+}
+
+void MeshletBuilder::BuildMeshlets( const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<Submesh>& submeshes, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets )
+{
+	meshlets.clear();
+
+	for ( size_t level = 0; level < lods.size(); ++level )
+	{
+		MeshLod& lod = lods[level];
+		lod.firstMeshlet = static_cast< uint32_t >( meshlets.size() );
+
+		if ( level == 0 && !submeshes.empty() )
+		{
+			for ( const Submesh& submesh : submeshes )
+			{
+				BuildRange( vertices, indices, submesh.firstIndex, submesh.indexCount, meshlets );
+			}
+		}
+		else
+		{
+			BuildRange( vertices, indices, lod.firstIndex, lod.indexCount, meshlets );
+		}
+
+		lod.meshletCount = static_cast< uint32_t >( meshlets.size() ) - lod.firstMeshlet;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Vertex;
+struct Submesh;
+struct MeshLod;
+struct Meshlet;
+
+// Splits meshes into meshlets of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles,
+// each with a bounding sphere and a normal cone so it can be frustum and backface culled on its own.
+// A meshlet grows from a seed triangle by adding the neighbouring triangle that brings the fewest new
+// vertices, until it's full or has no neighbours left; the triangles are then reordered so every
+// meshlet is one consecutive index range, drawable without a mesh shader.
+namespace MeshletBuilder
+{
+	// Partitions indices [firstIndex, firstIndex + indexCount), reordering its triangles, and appends its meshlets
+	void BuildRange( const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount, std::vector<Meshlet>& meshlets );
+
+	// Every submesh of level 0 (or the whole level without submeshes) and every coarser LOD in turn,
+	// filling in each level's meshlet range. Submesh and LOD ranges stay where they are.
+	void BuildMeshlets( const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<Submesh>& submeshes, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets );
+}
\ No newline at end of file
@@ -0,0 +1,379 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined( __AVX2__ )
+#define MIP_SIMD_AVX2
+#include <immintrin.h>
+#elif defined( _M_X64 ) || defined( __SSE2__ ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define MIP_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define MIP_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	// Below this many output texels a level isn't worth handing to other threads
+	const uint32_t MIN_TEXELS_PER_THREAD = 128 * 128;
+
+	struct SRGBTables
+	{
+		uint16_t toLinear[256];		// sRGB byte -> linear * 65535
+		uint8_t fromLinear[65536];	// linear * 65535 -> sRGB byte
+
+		SRGBTables()
+		{
+			for ( int i = 0; i < 256; ++i )
+			{
+				double c = i / 255.0;
+				double linear = c <= 0.04045 ? c / 12.92 : std::pow( ( c + 0.055 ) / 1.055, 2.4 );
+				toLinear[i] = static_cast< uint16_t >( linear * 65535.0 + 0.5 );
+			}
+
+			for ( int i = 0; i < 65536; ++i )
+			{
+				double linear = i / 65535.0;
+				double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow( linear, 1.0 / 2.4 ) - 0.055;
+				fromLinear[i] = static_cast< uint8_t >( std::min( std::max( c * 255.0 + 0.5, 0.0 ), 255.0 ) );
+			}
+		}
+	};
+
+	const SRGBTables& GetSRGBTables()
+	{
+		static SRGBTables tables;
+		return tables;
+	}
+
+	template<typename T>
+	T RoundingAverage( T a, T b )
+	{
+		return static_cast< T >( ( uint32_t( a ) + uint32_t( b ) + 1 ) >> 1 );
+	}
+
+	// The four kernels below are the whole filter: a vertical average of two rows, then an
+	// average of horizontally adjacent texels. Each SIMD path handles the bulk and leaves the
+	// tail to the scalar loop.
+
+	void AverageRows8( const uint8_t* a, const uint8_t* b, uint8_t* out, size_t count, bool bUseSIMD )
+	{
+		size_t i = 0;
+
+		if ( bUseSIMD )
+		{
+#if defined( MIP_SIMD_AVX2 )
+			for ( ; i + 32 <= count; i += 32 )
+			{
+				__m256i va = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( a + i ) );
+				__m256i vb = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( b + i ) );
+				_mm256_storeu_si256( reinterpret_cast< __m256i* >( out + i ), _mm256_avg_epu8( va, vb ) );
+			}
+#elif defined( MIP_SIMD_SSE2 )
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m128i va = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a + i ) );
+				__m128i vb = _mm_loadu_si128( reinterpret_cast< const __m128i* >( b + i ) );
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( out + i ), _mm_avg_epu8( va, vb ) );
+			}
+#elif defined( MIP_SIMD_NEON )
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				vst1q_u8( out + i, vrhaddq_u8( vld1q_u8( a + i ), vld1q_u8( b + i ) ) );
+			}
+#endif
+		}
+
+		for ( ; i < count; ++i )
+		{
+			out[i] = RoundingAverage( a[i], b[i] );
+		}
+	}
+
+	void AverageRows16( const uint16_t* a, const uint16_t* b, uint16_t* out, size_t count, bool bUseSIMD )
+	{
+		size_t i = 0;
+
+		if ( bUseSIMD )
+		{
+#if defined( MIP_SIMD_AVX2 )
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m256i va = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( a + i ) );
+				__m256i vb = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( b + i ) );
+				_mm256_storeu_si256( reinterpret_cast< __m256i* >( out + i ), _mm256_avg_epu16( va, vb ) );
+			}
+#elif defined( MIP_SIMD_SSE2 )
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i va = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a + i ) );
+				__m128i vb = _mm_loadu_si128( reinterpret_cast< const __m128i* >( b + i ) );
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( out + i ), _mm_avg_epu16( va, vb ) );
+			}
+#elif defined( MIP_SIMD_NEON )
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				vst1q_u16( out + i, vrhaddq_u16( vld1q_u16( a + i ), vld1q_u16( b + i ) ) );
+			}
+#endif
+		}
+
+		for ( ; i < count; ++i )
+		{
+			out[i] = RoundingAverage( a[i], b[i] );
+		}
+	}
+
+	// in holds 2 * dstWidth RGBA8 texels
+	void AveragePairs8( const uint8_t* in, uint8_t* out, uint32_t dstWidth, bool bUseSIMD )
+	{
+		uint32_t x = 0;
+
+		if ( bUseSIMD )
+		{
+#if defined( MIP_SIMD_AVX2 )
+			for ( ; x + 8 <= dstWidth; x += 8 )
+			{
+				__m256 v0 = _mm256_castsi256_ps( _mm256_loadu_si256( reinterpret_cast< const __m256i* >( in + x * 8 ) ) );
+				__m256 v1 = _mm256_castsi256_ps( _mm256_loadu_si256( reinterpret_cast< const __m256i* >( in + x * 8 + 32 ) ) );
+
+				// shuffle_ps works per 128 bit lane, so the 64 bit halves come out as 0,2,1,3
+				__m256i even = _mm256_permute4x64_epi64( _mm256_castps_si256( _mm256_shuffle_ps( v0, v1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+				__m256i odd = _mm256_permute4x64_epi64( _mm256_castps_si256( _mm256_shuffle_ps( v0, v1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+				_mm256_storeu_si256( reinterpret_cast< __m256i* >( out + x * 4 ), _mm256_avg_epu8( even, odd ) );
+			}
+#elif defined( MIP_SIMD_SSE2 )
+			for ( ; x + 4 <= dstWidth; x += 4 )
+			{
+				__m128 v0 = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast< const __m128i* >( in + x * 8 ) ) );
+				__m128 v1 = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast< const __m128i* >( in + x * 8 + 16 ) ) );
+
+				__m128i even = _mm_castps_si128( _mm_shuffle_ps( v0, v1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+				__m128i odd = _mm_castps_si128( _mm_shuffle_ps( v0, v1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( out + x * 4 ), _mm_avg_epu8( even, odd ) );
+			}
+#elif defined( MIP_SIMD_NEON )
+			for ( ; x + 4 <= dstWidth; x += 4 )
+			{
+				uint32x4x2_t texels = vld2q_u32( reinterpret_cast< const uint32_t* >( in + x * 8 ) );
+				vst1q_u8( out + x * 4, vrhaddq_u8( vreinterpretq_u8_u32( texels.val[0] ), vreinterpretq_u8_u32( texels.val[1] ) ) );
+			}
+#endif
+		}
+
+		for ( ; x < dstWidth; ++x )
+		{
+			for ( uint32_t channel = 0; channel < 4; ++channel )
+			{
+				out[x * 4 + channel] = RoundingAverage( in[x * 8 + channel], in[x * 8 + 4 + channel] );
+			}
+		}
+	}
+
+	// in holds 2 * dstWidth texels of four uint16 channels
+	void AveragePairs16( const uint16_t* in, uint16_t* out, uint32_t dstWidth, bool bUseSIMD )
+	{
+		uint32_t x = 0;
+
+		if ( bUseSIMD )
+		{
+#if defined( MIP_SIMD_AVX2 )
+			for ( ; x + 4 <= dstWidth; x += 4 )
+			{
+				__m256i v0 = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( in + x * 8 ) );
+				__m256i v1 = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( in + x * 8 + 16 ) );
+
+				__m256i even = _mm256_permute4x64_epi64( _mm256_unpacklo_epi64( v0, v1 ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+				__m256i odd = _mm256_permute4x64_epi64( _mm256_unpackhi_epi64( v0, v1 ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+				_mm256_storeu_si256( reinterpret_cast< __m256i* >( out + x * 4 ), _mm256_avg_epu16( even, odd ) );
+			}
+#elif defined( MIP_SIMD_SSE2 )
+			for ( ; x + 2 <= dstWidth; x += 2 )
+			{
+				__m128i v0 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( in + x * 8 ) );
+				__m128i v1 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( in + x * 8 + 8 ) );
+
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( out + x * 4 ), _mm_avg_epu16( _mm_unpacklo_epi64( v0, v1 ), _mm_unpackhi_epi64( v0, v1 ) ) );
+			}
+#elif defined( MIP_SIMD_NEON )
+			for ( ; x < dstWidth; ++x )
+			{
+				uint16x8_t texels = vld1q_u16( in + x * 8 );
+				vst1_u16( out + x * 4, vrhadd_u16( vget_low_u16( texels ), vget_high_u16( texels ) ) );
+			}
+#endif
+		}
+
+		for ( ; x < dstWidth; ++x )
+		{
+			for ( uint32_t channel = 0; channel < 4; ++channel )
+			{
+				out[x * 4 + channel] = RoundingAverage( in[x * 8 + channel], in[x * 8 + 4 + channel] );
+			}
+		}
+	}
+
+	void ToLinearRow( const uint8_t* src, uint16_t* dst, uint32_t texelCount, const SRGBTables& tables )
+	{
+		for ( uint32_t i = 0; i < texelCount; ++i )
+		{
+			dst[i * 4 + 0] = tables.toLinear[src[i * 4 + 0]];
+			dst[i * 4 + 1] = tables.toLinear[src[i * 4 + 1]];
+			dst[i * 4 + 2] = tables.toLinear[src[i * 4 + 2]];
+			dst[i * 4 + 3] = static_cast< uint16_t >( src[i * 4 + 3] * 257 );
+		}
+	}
+
+	void FromLinearRow( const uint16_t* src, uint8_t* dst, uint32_t texelCount, const SRGBTables& tables )
+	{
+		for ( uint32_t i = 0; i < texelCount; ++i )
+		{
+			dst[i * 4 + 0] = tables.fromLinear[src[i * 4 + 0]];
+			dst[i * 4 + 1] = tables.fromLinear[src[i * 4 + 1]];
+			dst[i * 4 + 2] = tables.fromLinear[src[i * 4 + 2]];
+			dst[i * 4 + 3] = static_cast< uint8_t >( ( src[i * 4 + 3] + 128 ) / 257 );
+		}
+	}
+}
+
+void MipGenerator::DownsampleRows( const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t rowBegin, uint32_t rowEnd, bool bSRGB, bool bUseSIMD )
+{
+	const size_t srcRowSize = static_cast< size_t >( srcWidth ) * 4;
+	const size_t dstRowSize = static_cast< size_t >( dstWidth ) * 4;
+
+	// A one texel wide source averages each texel with itself
+	const bool bSingleColumn = srcWidth == 1;
+
+	if ( bSRGB )
+	{
+		const SRGBTables& tables = GetSRGBTables();
+		std::vector<uint16_t> linear0( srcRowSize );
+		std::vector<uint16_t> linear1( srcRowSize );
+		std::vector<uint16_t> linearOut( dstRowSize );
+
+		for ( uint32_t y = rowBegin; y < rowEnd; ++y )
+		{
+			const uint8_t* row0 = src + std::min( y * 2, srcHeight - 1 ) * srcRowSize;
+			const uint8_t* row1 = src + std::min( y * 2 + 1, srcHeight - 1 ) * srcRowSize;
+
+			ToLinearRow( row0, linear0.data(), srcWidth, tables );
+			ToLinearRow( row1, linear1.data(), srcWidth, tables );
+			AverageRows16( linear0.data(), linear1.data(), linear0.data(), srcRowSize, bUseSIMD );
+
+			if ( bSingleColumn )
+			{
+				FromLinearRow( linear0.data(), dst + y * dstRowSize, 1, tables );
+			}
+			else
+			{
+				AveragePairs16( linear0.data(), linearOut.data(), dstWidth, bUseSIMD );
+				FromLinearRow( linearOut.data(), dst + y * dstRowSize, dstWidth, tables );
+			}
+		}
+	}
+	else
+	{
+		std::vector<uint8_t> rowAverage( srcRowSize );
+
+		for ( uint32_t y = rowBegin; y < rowEnd; ++y )
+		{
+			const uint8_t* row0 = src + std::min( y * 2, srcHeight - 1 ) * srcRowSize;
+			const uint8_t* row1 = src + std::min( y * 2 + 1, srcHeight - 1 ) * srcRowSize;
+
+			AverageRows8( row0, row1, rowAverage.data(), srcRowSize, bUseSIMD );
+
+			if ( bSingleColumn )
+			{
+				memcpy( dst + y * dstRowSize, rowAverage.data(), 4 );
+			}
+			else
+			{
+				AveragePairs8( rowAverage.data(), dst + y * dstRowSize, dstWidth, bUseSIMD );
+			}
+		}
+	}
+}
+
+void MipGenerator::GenerateMipChain( const uint8_t* pixels, uint32_t width, uint32_t height, bool bSRGB, TextureData& textureData, bool bUseSIMD, uint32_t threadCount )
+{
+	textureData.format = bSRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	textureData.width = width;
+	textureData.height = height;
+	textureData.mips.clear();
+
+	uint32_t levelCount = TextureFormats::GetMipLevelCount( width, height );
+
+	size_t totalSize = 0;
+	for ( uint32_t level = 0; level < levelCount; ++level )
+	{
+		TextureMipLevel mip;
+		mip.width = std::max( width >> level, 1u );
+		mip.height = std::max( height >> level, 1u );
+		mip.offset = totalSize;
+		mip.size = TextureFormats::GetLevelSize( textureData.format, mip.width, mip.height );
+
+		textureData.mips.push_back( mip );
+		totalSize += mip.size;
+	}
+
+	textureData.data.resize( totalSize );
+	memcpy( textureData.data.data(), pixels, textureData.mips[0].size );
+
+	if ( threadCount == 0 )
+	{
+		threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+	}
+
+	std::vector<std::thread> workers;
+
+	// Levels depend on the previous one, so threads split each level into bands of rows
+	for ( uint32_t level = 1; level < levelCount; ++level )
+	{
+		const TextureMipLevel& src = textureData.mips[level - 1];
+		const TextureMipLevel& dst = textureData.mips[level];
+
+		const uint8_t* srcData = textureData.data.data() + src.offset;
+		uint8_t* dstData = textureData.data.data() + dst.offset;
+
+		uint32_t bandCount = std::min( threadCount, std::max( dst.width * dst.height / MIN_TEXELS_PER_THREAD, 1u ) );
+		uint32_t rowsPerBand = ( dst.height + bandCount - 1 ) / bandCount;
+
+		for ( uint32_t band = 1; band < bandCount; ++band )
+		{
+			uint32_t rowBegin = band * rowsPerBand;
+			uint32_t rowEnd = std::min( rowBegin + rowsPerBand, dst.height );
+
+			workers.emplace_back( DownsampleRows, srcData, src.width, src.height, dstData, dst.width, rowBegin, rowEnd, bSRGB, bUseSIMD );
+		}
+
+		DownsampleRows( srcData, src.width, src.height, dstData, dst.width, 0, std::min( rowsPerBand, dst.height ), bSRGB, bUseSIMD );
+
+		for ( std::thread& worker : workers )
+		{
+			worker.join();
+		}
+
+		workers.clear();
+	}
+}
+
+const char* MipGenerator::GetSIMDPathName()
+{
+#if defined( MIP_SIMD_AVX2 )
+	return "AVX2";
+#elif defined( MIP_SIMD_SSE2 )
+	return "SSE2";
+#elif defined( MIP_SIMD_NEON )
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
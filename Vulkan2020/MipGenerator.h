@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "TextureFormats.h"
+
+// CPU mip chain generation for RGBA8 images. Used by the offline texture cooker and at load time
+// when the device can't linear blit the format (or is a software rasterizer), so the whole chain
+// is uploaded with one copy instead of blitted level by level on the graphics queue.
+//
+// 2x2 box filter built from rounding averages, so the scalar and SIMD (SSE2, AVX2, NEON) paths
+// produce identical output. With bSRGB the colour channels are averaged as 16 bit linear values.
+namespace MipGenerator
+{
+	// Fills textureData with the full chain (level 0 copied from pixels). threadCount 0 uses
+	// every hardware thread; small levels are always done on the calling thread.
+	void GenerateMipChain( const uint8_t* pixels, uint32_t width, uint32_t height, bool bSRGB, TextureData& textureData, bool bUseSIMD = true, uint32_t threadCount = 0 );
+
+	// Downsamples output rows [rowBegin, rowEnd) of one level; odd trailing rows/columns are dropped
+	void DownsampleRows( const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t rowBegin, uint32_t rowEnd, bool bSRGB, bool bUseSIMD );
+
+	// "AVX2", "SSE2", "NEON" or "scalar", whichever this build was compiled with
+	const char* GetSIMDPathName();
+}
\ No newline at end of file
@@ -3,38 +3,255 @@
 #pragma warning( disable : 4189 )
 
 #include "FileUtils.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "MipGenerator.h"
 #include "VulkanGraphicsInstance.h"
 
 #include <chrono>
 
 void VulkanTexture::CreateTexture( VulkanGraphicsInstance* pInstance, const char* pfilename )
 {
-	pGraphicsInstance = pInstance;
+	CreateTextures( pInstance, { this }, { pfilename } );
+}
 
-	CreateTextureImage( pfilename );
-	CreateTextureImageView();
-	CreateTextureSampler();
+void VulkanTexture::CreateTextures( VulkanGraphicsInstance* pInstance, const std::vector<VulkanTexture*>& textures, const std::vector<const char*>& filenames )
+{
+	assert( textures.size() == filenames.size() && "one filename per texture!" );
+
+	// Streamed and cooked textures are ready as they are; everything else is decoded together below
+	std::vector<VulkanTexture*> decodeTextures;
+	std::vector<TextureDecodePool::Request> requests;
+
+	for ( size_t i = 0; i < textures.size(); ++i )
+	{
+		VulkanTexture* pTexture = textures[i];
+		pTexture->pGraphicsInstance = pInstance;
+
+		pTexture->CreateTextureSampler();
+
+		if ( pTexture->RegisterWithStreamer( filenames[i] ) )
+		{
+			continue;
+		}
+
+		// Prefer cooked data: a .vtex from the texture cooker, then a precompressed sibling the device can
+		// sample. Both carry their full mip chain, so there is no decode or mip generation at startup.
+		TextureData cookedData;
+		if ( pTexture->LoadCookedTexture( filenames[i], cookedData ) || pTexture->LoadCompressedVariant( filenames[i], cookedData ) )
+		{
+			pTexture->CreateTextureImageFromData( cookedData );
+			pTexture->PublishTexture();
+			continue;
+		}
+
+		TextureDecodePool::Request request;
+		request.path = std::string( TEXTURE_PATH ) + filenames[i];
+
+		requests.push_back( request );
+		decodeTextures.push_back( pTexture );
+	}
+
+	if ( !requests.empty() )
+	{
+		CreateDecodedTextureImages( pInstance, decodeTextures, requests );
+	}
 }
 
 void VulkanTexture::CleanupTexture()
 {
-	vkDestroySampler( *pGraphicsInstance->GetDevice(), TextureSampler, nullptr );
+	if ( StreamHandle != TextureStreamer::INVALID_HANDLE )
+	{
+		pGraphicsInstance->GetTextureStreamer().Unregister( StreamHandle );
+		pGraphicsInstance->GetSamplerCache().Release( TextureSampler );
+
+		StreamHandle = TextureStreamer::INVALID_HANDLE;
+		BindlessSlot = BindlessTextureTable::INVALID_SLOT;
+		return;
+	}
+
+	if ( BindlessSlot != BindlessTextureTable::INVALID_SLOT )
+	{
+		pGraphicsInstance->GetBindlessTextures().UnregisterTexture( BindlessSlot );
+		BindlessSlot = BindlessTextureTable::INVALID_SLOT;
+	}
+
+	pGraphicsInstance->GetSamplerCache().Release( TextureSampler );
 	vkDestroyImageView( *pGraphicsInstance->GetDevice(), TextureImageView, nullptr );
 	vkDestroyImage( *pGraphicsInstance->GetDevice(), TextureImage, nullptr );
 	vkFreeMemory( *pGraphicsInstance->GetDevice(), TextureImageMemory, nullptr );
 }
 
-void VulkanTexture::CreateTextureImage( const char* pfilename )
+void VulkanTexture::RequestScreenSize( float screenSize )
 {
-	int texWidth;
-	int texHeight;
-	int texChannels;
+	if ( StreamHandle != TextureStreamer::INVALID_HANDLE )
+	{
+		pGraphicsInstance->GetTextureStreamer().RequestScreenSize( StreamHandle, screenSize );
+	}
+}
 
-	void* pixels = FileUtils::OpenTexture( pfilename, texWidth, texHeight, texChannels );
-	VkDeviceSize imageSize = texWidth * texHeight * 4;
-	MipLevels = static_cast< uint32_t >( std::floor( std::log2( std::max( texWidth, texHeight ) ) ) ) + 1;
+void VulkanTexture::CreateTextureFromData( VulkanGraphicsInstance* pInstance, const TextureData& textureData )
+{
+	pGraphicsInstance = pInstance;
 
-	assert( pixels && "failed to load texture image!" );
+	CreateTextureSampler();
+	CreateTextureImageFromData( textureData );
+	PublishTexture();
+}
+
+bool VulkanTexture::RegisterWithStreamer( const char* pfilename )
+{
+	// Streamed textures start with their tail mips; the streamer owns the image, view and bindless slot
+	if ( !pGraphicsInstance->IsTextureStreamingEnabled() )
+	{
+		return false;
+	}
+
+	std::string cookedName( pfilename );
+	cookedName = cookedName.substr( 0, cookedName.find_last_of( '.' ) ) + ".vtex";
+
+	StreamHandle = pGraphicsInstance->GetTextureStreamer().Register( cookedName.c_str(), TextureSampler );
+
+	if ( StreamHandle == TextureStreamer::INVALID_HANDLE )
+	{
+		return false;
+	}
+
+	BindlessSlot = pGraphicsInstance->GetTextureStreamer().GetBindlessSlot( StreamHandle );
+
+	return true;
+}
+
+void VulkanTexture::CreateDecodedTextureImages( VulkanGraphicsInstance* pInstance, const std::vector<VulkanTexture*>& textures, std::vector<TextureDecodePool::Request>& requests )
+{
+	TextureDecodePool& decodePool = pInstance->GetTextureDecodePool();
+	VkDeviceSize batchSize = decodePool.PrepareBatch( requests );
+
+	// No linear blit for the format (or a software device): decode to system memory, build each chain
+	// there and upload it in one copy
+	if ( pInstance->ShouldGenerateMipsOnCPU( VK_FORMAT_R8G8B8A8_SRGB ) )
+	{
+		std::vector<uint8_t> pixels( static_cast< size_t >( batchSize ) );
+		decodePool.DecodeBatch( requests, pixels.data() );
+
+		for ( size_t i = 0; i < textures.size(); ++i )
+		{
+			const TextureDecodePool::Request& request = requests[i];
+			assert( request.bSuccess && "failed to load texture image!" );
+
+			auto startTime = std::chrono::high_resolution_clock::now();
+
+			TextureData mipChain;
+			MipGenerator::GenerateMipChain( pixels.data() + request.offset, request.width, request.height, true, mipChain );
+
+			pInstance->RecordCPUMipGeneration( std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - startTime ).count() );
+
+			textures[i]->CreateTextureImageFromData( mipChain );
+			textures[i]->PublishTexture();
+		}
+
+		return;
+	}
+
+	// Every image of the batch shares one staging buffer and is decoded straight into it
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+
+	pInstance->CreateBuffer( std::max( batchSize, VkDeviceSize( 1 ) ), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
+
+	void* data;
+	vkMapMemory( *pInstance->GetDevice(), stagingBufferMemory, 0, VK_WHOLE_SIZE, 0, &data );
+	decodePool.DecodeBatch( requests, static_cast< uint8_t* >( data ) );
+	vkUnmapMemory( *pInstance->GetDevice(), stagingBufferMemory );
+
+	for ( size_t i = 0; i < textures.size(); ++i )
+	{
+		VulkanTexture* pTexture = textures[i];
+		const TextureDecodePool::Request& request = requests[i];
+		assert( request.bSuccess && "failed to load texture image!" );
+
+		pTexture->TextureFormat = VK_FORMAT_R8G8B8A8_SRGB;
+		pTexture->MipLevels = static_cast< uint32_t >( std::floor( std::log2( std::max( request.width, request.height ) ) ) ) + 1;
+
+		pInstance->CreateImage( request.width, request.height, pTexture->MipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pTexture->TextureImage, pTexture->TextureImageMemory );
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = request.offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { request.width, request.height, 1 };
+
+		pInstance->TransitionImageLayout( pTexture->TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, pTexture->MipLevels );
+		pInstance->CopyBufferToImage( stagingBuffer, pTexture->TextureImage, { region } );
+
+		//transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
+		pInstance->GenerateMipmaps( pTexture->TextureImage, VK_FORMAT_R8G8B8A8_SRGB, static_cast< int32_t >( request.width ), static_cast< int32_t >( request.height ), pTexture->MipLevels );
+
+		pTexture->PublishTexture();
+	}
+
+	vkDestroyBuffer( *pInstance->GetDevice(), stagingBuffer, nullptr );
+	vkFreeMemory( *pInstance->GetDevice(), stagingBufferMemory, nullptr );
+}
+
+bool VulkanTexture::LoadCookedTexture( const char* pfilename, TextureData& textureData )
+{
+	// Cooked output sits next to the source image, e.g. chaletTex.jpg -> chaletTex.vtex
+	std::string baseName( pfilename );
+	baseName = baseName.substr( 0, baseName.find_last_of( '.' ) );
+
+	return FileUtils::LoadCookedTexture( ( baseName + ".vtex" ).c_str(), textureData ) && pGraphicsInstance->IsFormatSampleable( textureData.format );
+}
+
+bool VulkanTexture::LoadCompressedVariant( const char* pfilename, TextureData& textureData )
+{
+	// Cooked variants sit next to the source image, e.g. chaletTex.jpg -> chaletTex_bc7.ktx
+	struct CompressedVariant
+	{
+		const char* suffix;
+		VkFormat probeFormat;
+	};
+
+	static const CompressedVariant variants[] =
+	{
+		{ "_bc7.ktx", VK_FORMAT_BC7_SRGB_BLOCK },
+		{ "_bc3.ktx", VK_FORMAT_BC3_SRGB_BLOCK },
+		{ "_bc1.ktx", VK_FORMAT_BC1_RGBA_SRGB_BLOCK },
+		{ "_astc.ktx", VK_FORMAT_ASTC_4x4_SRGB_BLOCK },
+		{ "_etc2.ktx", VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK },
+	};
+
+	std::string baseName( pfilename );
+	baseName = baseName.substr( 0, baseName.find_last_of( '.' ) );
+
+	for ( const CompressedVariant& variant : variants )
+	{
+		if ( !pGraphicsInstance->IsFormatSampleable( variant.probeFormat ) )
+		{
+			continue;
+		}
+
+		// The file decides the exact format (e.g. ASTC footprint), so check support again once loaded
+		if ( FileUtils::LoadKTX( ( baseName + variant.suffix ).c_str(), textureData ) && pGraphicsInstance->IsFormatSampleable( textureData.format ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void VulkanTexture::CreateTextureImageFromData( const TextureData& textureData )
+{
+	TextureFormat = textureData.format;
+	MipLevels = static_cast< uint32_t >( textureData.mips.size() );
+
+	VkDeviceSize imageSize = textureData.data.size();
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
@@ -43,19 +260,36 @@ void VulkanTexture::CreateTextureImage( const char* pfilename )
 
 	void* data;
 	vkMapMemory( *pGraphicsInstance->GetDevice(), stagingBufferMemory, 0, imageSize, 0, &data );
-	memcpy( data, pixels, static_cast< size_t >( imageSize ) );
+	memcpy( data, textureData.data.data(), static_cast< size_t >( imageSize ) );
 	vkUnmapMemory( *pGraphicsInstance->GetDevice(), stagingBufferMemory );
 
-	FileUtils::CloseTexture( pixels );
+	// Mips come precomputed; block formats can't be blit targets anyway, so each level is copied as is
+	pGraphicsInstance->CreateImage( textureData.width, textureData.height, MipLevels, VK_SAMPLE_COUNT_1_BIT, TextureFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, TextureImage, TextureImageMemory );
 
-	pGraphicsInstance->CreateImage( texWidth, texHeight, MipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, TextureImage, TextureImageMemory );
+	std::vector<VkBufferImageCopy> regions;
+	regions.reserve( textureData.mips.size() );
 
-	pGraphicsInstance->TransitionImageLayout( TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, MipLevels );
-	pGraphicsInstance->CopyBufferToImage( stagingBuffer, TextureImage, static_cast< uint32_t >( texWidth ), static_cast< uint32_t >( texHeight ) );
+	for ( uint32_t level = 0; level < MipLevels; ++level )
+	{
+		const TextureMipLevel& mip = textureData.mips[level];
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = mip.offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { mip.width, mip.height, 1 };
+
+		regions.push_back( region );
+	}
 
-	//transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
-	//TransitionImageLayout( TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, MipLevels );
-	pGraphicsInstance->GenerateMipmaps( TextureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, MipLevels );
+	pGraphicsInstance->TransitionImageLayout( TextureImage, TextureFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, MipLevels );
+	pGraphicsInstance->CopyBufferToImage( stagingBuffer, TextureImage, regions );
+	pGraphicsInstance->TransitionImageLayout( TextureImage, TextureFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, MipLevels );
 
 	vkDestroyBuffer( *pGraphicsInstance->GetDevice(), stagingBuffer, nullptr );
 	vkFreeMemory( *pGraphicsInstance->GetDevice(), stagingBufferMemory, nullptr );
@@ -63,7 +297,17 @@ void VulkanTexture::CreateTextureImage( const char* pfilename )
 
 void VulkanTexture::CreateTextureImageView()
 {
-	TextureImageView = pGraphicsInstance->CreateImageView( TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, MipLevels );
+	TextureImageView = pGraphicsInstance->CreateImageView( TextureImage, TextureFormat, VK_IMAGE_ASPECT_COLOR_BIT, MipLevels );
+}
+
+void VulkanTexture::PublishTexture()
+{
+	CreateTextureImageView();
+
+	if ( pGraphicsInstance->IsBindlessEnabled() )
+	{
+		BindlessSlot = pGraphicsInstance->GetBindlessTextures().RegisterTexture( TextureImageView, TextureSampler );
+	}
 }
 
 void VulkanTexture::CreateTextureSampler()
@@ -85,11 +329,11 @@ void VulkanTexture::CreateTextureSampler()
 	samplerInfo.minLod = 0.0f;
 	//	samplerInfo.minLod = static_cast< float >( MipLevels / 2 );
 	//	samplerInfo.maxLod = 0;
-	samplerInfo.maxLod = static_cast< float >( MipLevels );
+	// The image view already limits sampling to MipLevels, so an unclamped maxLod lets every texture share one sampler
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 	samplerInfo.mipLodBias = 0.0f;
 
-	VkResult result = vkCreateSampler( *pGraphicsInstance->GetDevice(), &samplerInfo, nullptr, &TextureSampler );
-	assert( VK_SUCCESS == result && "failed to create texture sampler!" );
+	TextureSampler = pGraphicsInstance->GetSamplerCache().Acquire( samplerInfo );
 }
 
 void VulkanTexture::CreateDescriptorSets( std::vector<VkDescriptorSet>& descriptorSets )
@@ -99,33 +343,50 @@ void VulkanTexture::CreateDescriptorSets( std::vector<VkDescriptorSet>& descript
 
 void Model::Initialize( VulkanGraphicsInstance* pInstance, const char* pfilename, const char* ptexname )
 {
-	pGraphicsInstance = pInstance;
+	VulkanTexture* pSharedTexture = nullptr;
 
 	//if ( strcmp( "", ptexname ) != 0 )
 	{
-		pTexture = new VulkanTexture();
-		pTexture->CreateTexture(  pGraphicsInstance, ptexname );
+		pSharedTexture = pInstance->GetTextureCache().Acquire( ptexname );
 	}
 
+	Initialize( pInstance, pfilename, pSharedTexture );
+}
+
+void Model::Initialize( VulkanGraphicsInstance* pInstance, const char* pfilename, VulkanTexture* pLoadedTexture )
+{
 	LoadModel( pfilename );
+	Initialize( pInstance, pLoadedTexture );
+}
+
+void Model::Initialize( VulkanGraphicsInstance* pInstance, VulkanTexture* pLoadedTexture )
+{
+	pGraphicsInstance = pInstance;
+	pTexture = pLoadedTexture;
+
+	if ( pTexture != nullptr && pGraphicsInstance->IsBindlessEnabled() )
+	{
+		MaterialIndex = pTexture->GetBindlessSlot();
+	}
+
 	CreateVertexBuffer();
 	CreateIndexBuffer();
 	CreateDescriptorSets();
 }
 
-void Model::BindToCommandBuffer( VkCommandBuffer& rBuffer, VkPipeline& rPipeline, VkPipelineLayout& rPipelineLayout, size_t idx )
+void Model::BindGeometry( VkCommandBuffer& rBuffer, VkPipelineLayout& rPipelineLayout, size_t idx )
 {
-	vkCmdBindPipeline( rBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, rPipeline );
-
-	
 	VkBuffer vertexBuffers[] = { VertexBuffer };
 	VkDeviceSize offsets[] = { 0 };
 	vkCmdBindVertexBuffers( rBuffer, 0, 1, vertexBuffers, offsets );
 
 	vkCmdBindIndexBuffer( rBuffer, IndexBuffer, 0, VK_INDEX_TYPE_UINT32 );
 
-	vkCmdBindDescriptorSets( rBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, rPipelineLayout, 0, 1, &DescriptorSets[idx], 0, nullptr );
-	vkCmdDrawIndexed( rBuffer, static_cast< uint32_t >( indices.size() ), 1, 0, 0, 0 );
+	// In bindless mode the shared sets are bound once per pass and the texture is selected by MaterialIndex
+	if ( !pGraphicsInstance->IsBindlessEnabled() )
+	{
+		vkCmdBindDescriptorSets( rBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, rPipelineLayout, 0, 1, &DescriptorSets[idx], 0, nullptr );
+	}
 }
 
 void Model::Cleanup()
@@ -133,9 +394,7 @@ void Model::Cleanup()
 	//vkDestroyDescriptorSetLayout( vulkanDevice, descriptorSetLayout, nullptr );
 	if ( nullptr != pTexture )
 	{
-		pTexture->CleanupTexture();
-
-		delete pTexture;
+		pGraphicsInstance->GetTextureCache().Release( pTexture );
 		pTexture = nullptr;
 	}
 
@@ -149,8 +408,59 @@ void Model::Cleanup()
 
 void Model::LoadModel( const char* pfilename )
 {
-	//FileUtils::LoadModel( "../assets/models/chalet.obj", vertices, indices );
-	FileUtils::LoadModel( pfilename, vertices, indices );
+	// Prefer the mesh cache the asset database writes next to the OBJ, e.g. Cactus_4.obj -> Cactus_4.vmesh
+	std::string cacheName = pfilename;
+	cacheName = cacheName.substr( 0, cacheName.find_last_of( '.' ) ) + ".vmesh";
+
+	if ( !FileUtils::LoadMeshCache( cacheName, vertices, indices, Submeshes, Lods, Meshlets, Bounds ) )
+	{
+		vertices.clear();
+		indices.clear();
+		Submeshes.clear();
+
+		//FileUtils::LoadModel( "../assets/models/chalet.obj", vertices, indices );
+		FileUtils::LoadModel( pfilename, vertices, indices, &Submeshes, &Bounds );
+		MeshSimplifier::GenerateLods( vertices, indices, static_cast< uint32_t >( indices.size() ), Bounds.radius, Lods );
+		MeshletBuilder::BuildMeshlets( vertices, indices, Submeshes, Lods, Meshlets );
+	}
+
+	if ( Lods.empty() )
+	{
+		Lods.push_back( MeshLod{ 0, static_cast< uint32_t >( indices.size() ), 0.0f, 0, 0 } );
+	}
+
+	if ( Submeshes.empty() )
+	{
+		Submeshes.push_back( Submesh{ 0, GetIndexCount(), Bounds } );
+	}
+}
+
+bool Model::RemapUVs( const glm::vec2& uvOffset, const glm::vec2& uvScale )
+{
+	if ( !HasUnitRangeUVs() )
+	{
+		return false;
+	}
+
+	for ( Vertex& vertex : vertices )
+	{
+		vertex.uv = vertex.uv * uvScale + uvOffset;
+	}
+
+	return true;
+}
+
+bool Model::HasUnitRangeUVs() const
+{
+	for ( const Vertex& vertex : vertices )
+	{
+		if ( vertex.uv.x < 0.0f || vertex.uv.x > 1.0f || vertex.uv.y < 0.0f || vertex.uv.y > 1.0f )
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 void Model::CreateVertexBuffer()
@@ -197,7 +507,7 @@ void Model::CreateIndexBuffer()
 
 void Model::CreateDescriptorSets()
 {
-	if ( pTexture != nullptr )
+	if ( pTexture != nullptr && !pGraphicsInstance->IsBindlessEnabled() )
 	{
 		pTexture->CreateDescriptorSets( DescriptorSets );
 	}
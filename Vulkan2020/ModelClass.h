@@ -10,6 +10,11 @@
 
 #include "vulkan/vulkan.h"
 
+#include "BindlessTextureTable.h"
+#include "TextureStreamer.h"
+#include "TextureDecodePool.h"
+#include "TextureFormats.h"
+
 class VulkanGraphicsInstance;
 
 struct Vertex
@@ -78,38 +83,212 @@ namespace std
 	};
 }
 
+// Per-instance vertex data for instanced scene draws, read from binding 1 at instance rate.
+// The model matrix takes one attribute location per column.
+struct InstanceData
+{
+	glm::mat4 model;
+	glm::vec4 tint;
+
+	static VkVertexInputBindingDescription GetBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription = {};
+
+		bindingDescription.binding = 1;
+		bindingDescription.stride = sizeof( InstanceData );
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+		return bindingDescription;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions()
+	{
+		std::array<VkVertexInputAttributeDescription, 5> AttributeDescriptions = {};
+
+		for ( uint32_t column = 0; column < 4; ++column )
+		{
+			AttributeDescriptions[column].binding = 1;
+			AttributeDescriptions[column].location = 4 + column;
+			AttributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			AttributeDescriptions[column].offset = static_cast< uint32_t >( offsetof( InstanceData, model ) + column * sizeof( glm::vec4 ) );
+		}
+
+		AttributeDescriptions[4].binding = 1;
+		AttributeDescriptions[4].location = 8;
+		AttributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		AttributeDescriptions[4].offset = offsetof( InstanceData, tint );
+
+		return AttributeDescriptions;
+	}
+};
+
+// Model space bounds of a mesh or of one of its submeshes, computed when the geometry is imported
+struct MeshBounds
+{
+	glm::vec3 min = glm::vec3( 0.0f );
+	glm::vec3 max = glm::vec3( 0.0f );
+	glm::vec3 center = glm::vec3( 0.0f );	// bounding sphere, centred on the box
+	float radius = 0.0f;
+};
+
+// A range of the model's index buffer, one per OBJ shape, so parts of a large model can be culled on their own
+struct Submesh
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	MeshBounds bounds;
+};
+
+constexpr uint32_t MAX_MESH_LODS = 4;
+
+// A level of detail: a range of the model's index buffer over the same vertices. Level 0 is the full mesh;
+// coarser levels come from MeshSimplifier::GenerateLods and follow it in the index buffer.
+struct MeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;	// how far the surface may have moved from level 0, as a fraction of the mesh's bounding radius
+	uint32_t firstMeshlet;	// the level's clusters in Model::Meshlets
+	uint32_t meshletCount;
+};
+
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// A cluster of neighbouring triangles, built by MeshletBuilder so its triangles are consecutive in the index
+// buffer and it can be culled and drawn on its own
+struct Meshlet
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	glm::vec4 sphere;	// model space bounds: xyz centre, w radius
+	// Normal cone: xyz the average facing, w the sine of the angle the other facings spread from it.
+	// Every triangle faces away from a viewpoint v when dot( centre - v, axis ) >= w * |centre - v| + radius.
+	// w is 1 and the axis zero when they spread too far for that to ever hold.
+	glm::vec4 cone;
+};
+
+// Mesh cache (.vmesh) written by the asset database next to its OBJ: the deduplicated vertices,
+// indices and submeshes exactly as FileUtils::LoadModel builds them plus the generated LODs and meshlets,
+// so loading skips the OBJ parse, the simplifier and the meshlet builder.
+// Layout: VMeshHeader, submeshCount VMeshSubmesh records, lodCount VMeshLod records, meshletCount VMeshMeshlet
+// records, the vertices, then the indices.
+constexpr uint8_t VMESH_IDENTIFIER[8] = { 0xAB, 'V', 'M', 'S', 'H', 0xBB, '\r', '\n' };
+constexpr uint32_t VMESH_VERSION = 4;
+
+// Plain floats rather than glm types, so the file layout doesn't depend on glm's alignment settings
+struct VMeshBounds
+{
+	float min[3];
+	float max[3];
+	float center[3];
+	float radius;
+};
+
+struct VMeshHeader
+{
+	uint8_t identifier[8];
+	uint32_t version;
+	uint32_t vertexStride;	// sizeof( Vertex ) when written; a layout change makes old caches unreadable
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t submeshCount;
+	uint32_t lodCount;
+	uint32_t meshletCount;
+	VMeshBounds bounds;		// of the whole mesh
+};
+
+struct VMeshSubmesh
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	VMeshBounds bounds;
+};
+
+struct VMeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+};
+
+struct VMeshMeshlet
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float sphere[4];
+	float cone[4];
+};
+
 class VulkanTexture
 {
 public:
 	void CreateTexture( VulkanGraphicsInstance* pInstance, const char* pfilename );
+
+	// Loads many textures at once; the ones that need decoding go through the instance's TextureDecodePool together.
+	// Models should go through TextureCache instead, which calls this for the textures it doesn't have yet.
+	static void CreateTextures( VulkanGraphicsInstance* pInstance, const std::vector<VulkanTexture*>& textures, const std::vector<const char*>& filenames );
+
+	// For images built in memory, e.g. TextureAtlas pages; the data carries its full mip chain
+	void CreateTextureFromData( VulkanGraphicsInstance* pInstance, const TextureData& textureData );
+
 	void CleanupTexture();
 
 	void CreateDescriptorSets( std::vector<VkDescriptorSet>& descriptorSets );
 
+	uint32_t GetBindlessSlot() const { return BindlessSlot; }
+
+	// Forwards the on-screen size to the streamer; no-op for textures loaded whole
+	void RequestScreenSize( float screenSize );
+
 private:
-	void CreateTextureImage( const char* pfilename );
+	static void CreateDecodedTextureImages( VulkanGraphicsInstance* pInstance, const std::vector<VulkanTexture*>& textures, std::vector<TextureDecodePool::Request>& requests );
+	bool RegisterWithStreamer( const char* pfilename );
+	bool LoadCookedTexture( const char* pfilename, TextureData& textureData );
+	bool LoadCompressedVariant( const char* pfilename, TextureData& textureData );
+	void CreateTextureImageFromData( const TextureData& textureData );
 	void CreateTextureImageView();
+	void PublishTexture();	// creates the view and takes a bindless slot
 	void CreateTextureSampler();
 
 	VulkanGraphicsInstance* pGraphicsInstance;
 
+	VkFormat TextureFormat = VK_FORMAT_R8G8B8A8_SRGB;
 	uint32_t MipLevels;
 	VkImage TextureImage;
 	VkDeviceMemory TextureImageMemory;
 	VkImageView TextureImageView;
 	VkSampler TextureSampler;
+
+	uint32_t BindlessSlot = BindlessTextureTable::INVALID_SLOT;
+	TextureStreamer::Handle StreamHandle = TextureStreamer::INVALID_HANDLE;
 };
 
 class Model
 {
 public:
 	void Initialize( VulkanGraphicsInstance* pInstance, const char* pfilename, const char* ptexname );
-	void BindToCommandBuffer( VkCommandBuffer& rBuffer, VkPipeline& rPipeline, VkPipelineLayout& rPipelineLayout, size_t idx );
+	// Takes over one reference from TextureCache::Acquire; Cleanup releases it
+	void Initialize( VulkanGraphicsInstance* pInstance, const char* pfilename, VulkanTexture* pLoadedTexture );
+	// Same, for geometry already loaded with LoadModel
+	void Initialize( VulkanGraphicsInstance* pInstance, VulkanTexture* pLoadedTexture );
+	// Binds the vertex and index buffers, plus the texture's set when bindless is off; the caller binds the pipeline and pushes per-draw data
+	void BindGeometry( VkCommandBuffer& rBuffer, VkPipelineLayout& rPipelineLayout, size_t idx );
+	// Of the full detail mesh; coarser LODs follow it in the index buffer
+	uint32_t GetIndexCount() const { return Lods.empty() ? static_cast< uint32_t >( indices.size() ) : Lods[0].indexCount; }
 	void Cleanup();
 
-private:
 	void LoadModel( const char* pfilename );
 
+	// Moves UVs into an atlas region (uv * scale + offset). Fails without changes if any UV is outside
+	// [0, 1], since those rely on repeat addressing; call before Initialize uploads the vertices.
+	bool RemapUVs( const glm::vec2& uvOffset, const glm::vec2& uvScale );
+	bool HasUnitRangeUVs() const;
+
+private:
+
 	void CreateVertexBuffer();
 	void CreateIndexBuffer();
 
@@ -132,5 +311,17 @@ public:
 
 	std::vector<VkDescriptorSet> DescriptorSets;
 
-	VulkanTexture* pTexture = nullptr;
+	VulkanTexture* pTexture = nullptr;	// shared, owned by the instance's TextureCache
+
+	// Bindless slot of pTexture; the material new scene entities of this model start with
+	uint32_t MaterialIndex = 0;
+
+	// Model space; the scene transforms the sphere into each entity's world bounds
+	MeshBounds Bounds;
+	// Always at least one; a model imported from a single shape has one covering every index
+	std::vector<Submesh> Submeshes;
+	// Always at least one, level 0 covering the submeshes; at most MAX_MESH_LODS
+	std::vector<MeshLod> Lods;
+	// Every LOD's clusters; within level 0 they never straddle two submeshes
+	std::vector<Meshlet> Meshlets;
 };
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "SamplerCache.h"
+
+#include <cassert>
+
+#include "GraphicsCommon.h"
+
+bool SamplerCache::SamplerKey::operator==( const SamplerKey& other ) const
+{
+	const VkSamplerCreateInfo& a = createInfo;
+	const VkSamplerCreateInfo& b = other.createInfo;
+
+	return a.flags == b.flags
+		&& a.magFilter == b.magFilter
+		&& a.minFilter == b.minFilter
+		&& a.mipmapMode == b.mipmapMode
+		&& a.addressModeU == b.addressModeU
+		&& a.addressModeV == b.addressModeV
+		&& a.addressModeW == b.addressModeW
+		&& a.mipLodBias == b.mipLodBias
+		&& a.anisotropyEnable == b.anisotropyEnable
+		&& a.maxAnisotropy == b.maxAnisotropy
+		&& a.compareEnable == b.compareEnable
+		&& a.compareOp == b.compareOp
+		&& a.minLod == b.minLod
+		&& a.maxLod == b.maxLod
+		&& a.borderColor == b.borderColor
+		&& a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+}
+
+size_t SamplerCache::SamplerKeyHash::operator()( const SamplerKey& key ) const
+{
+	const VkSamplerCreateInfo& info = key.createInfo;
+
+	size_t seed = 0;
+	HashCombine( seed, info.flags );
+	HashCombine( seed, static_cast< uint32_t >( info.magFilter ) );
+	HashCombine( seed, static_cast< uint32_t >( info.minFilter ) );
+	HashCombine( seed, static_cast< uint32_t >( info.mipmapMode ) );
+	HashCombine( seed, static_cast< uint32_t >( info.addressModeU ) );
+	HashCombine( seed, static_cast< uint32_t >( info.addressModeV ) );
+	HashCombine( seed, static_cast< uint32_t >( info.addressModeW ) );
+	HashCombine( seed, info.mipLodBias );
+	HashCombine( seed, info.anisotropyEnable );
+	HashCombine( seed, info.maxAnisotropy );
+	HashCombine( seed, info.compareEnable );
+	HashCombine( seed, static_cast< uint32_t >( info.compareOp ) );
+	HashCombine( seed, info.minLod );
+	HashCombine( seed, info.maxLod );
+	HashCombine( seed, static_cast< uint32_t >( info.borderColor ) );
+	HashCombine( seed, info.unnormalizedCoordinates );
+
+	return seed;
+}
+
+void SamplerCache::Init( VkDevice vulkanDevice, uint32_t maxSamplerAllocationCount )
+{
+	device = vulkanDevice;
+	maxSamplers = maxSamplerAllocationCount;
+}
+
+void SamplerCache::Cleanup()
+{
+	assert( samplers.empty() && "samplers still referenced at cleanup!" );
+
+	for ( auto& entry : samplers )
+	{
+		vkDestroySampler( device, entry.second.sampler, nullptr );
+	}
+
+	samplers.clear();
+	keysBySampler.clear();
+}
+
+VkSampler SamplerCache::Acquire( const VkSamplerCreateInfo& createInfo )
+{
+	// Extension structs are not part of the key
+	assert( createInfo.pNext == nullptr && "chained sampler create info is not supported by the cache!" );
+
+	SamplerKey key = { createInfo };
+	key.createInfo.pNext = nullptr;
+
+	auto found = samplers.find( key );
+	if ( found != samplers.end() )
+	{
+		++found->second.refCount;
+		return found->second.sampler;
+	}
+
+	assert( samplers.size() < maxSamplers && "exceeded maxSamplerAllocationCount!" );
+
+	VkSampler sampler;
+	VkResult result = vkCreateSampler( device, &createInfo, nullptr, &sampler );
+	assert( VK_SUCCESS == result && "failed to create texture sampler!" );
+
+	samplers.emplace( key, SamplerEntry{ sampler, 1 } );
+	keysBySampler.emplace( sampler, key );
+
+	return sampler;
+}
+
+void SamplerCache::Release( VkSampler sampler )
+{
+	auto key = keysBySampler.find( sampler );
+	assert( key != keysBySampler.end() && "releasing a sampler the cache does not own!" );
+	if ( key == keysBySampler.end() )
+	{
+		return;
+	}
+
+	auto entry = samplers.find( key->second );
+	if ( --entry->second.refCount == 0 )
+	{
+		vkDestroySampler( device, sampler, nullptr );
+
+		samplers.erase( entry );
+		keysBySampler.erase( key );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "vulkan/vulkan.h"
+
+// Shares VkSamplers between every texture that asks for identical sampler state. Samplers are
+// reference counted; the last Release destroys it. Drivers cap the number of live samplers
+// (maxSamplerAllocationCount, as low as 4000), so textures must never create their own.
+class SamplerCache
+{
+public:
+	void Init( VkDevice device, uint32_t maxSamplerAllocationCount );
+	void Cleanup();
+
+	VkSampler Acquire( const VkSamplerCreateInfo& createInfo );
+	void Release( VkSampler sampler );
+
+	uint32_t GetSamplerCount() const { return static_cast< uint32_t >( samplers.size() ); }
+
+private:
+	struct SamplerKey
+	{
+		VkSamplerCreateInfo createInfo;
+
+		bool operator==( const SamplerKey& other ) const;
+	};
+
+	struct SamplerKeyHash
+	{
+		size_t operator()( const SamplerKey& key ) const;
+	};
+
+	struct SamplerEntry
+	{
+		VkSampler sampler;
+		uint32_t refCount;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	uint32_t maxSamplers = 0;
+
+	std::unordered_map<SamplerKey, SamplerEntry, SamplerKeyHash> samplers;
+	std::unordered_map<VkSampler, SamplerKey> keysBySampler;
+};
\ No newline at end of file
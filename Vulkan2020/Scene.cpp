@@ -0,0 +1,716 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined( _M_X64 ) || defined( __SSE__ ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define SCENE_SIMD_SSE
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define SCENE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#include "ModelClass.h"
+
+namespace
+{
+	// An entity only moves to a coarser LOD once that level's projected error is under this fraction of the threshold
+	constexpr float LOD_HYSTERESIS = 0.75f;
+
+	static_assert( sizeof( Scene::LodStatistics::entitiesPerLevel ) / sizeof( uint32_t ) == MAX_MESH_LODS, "one counter per LOD level!" );
+
+	// BatchDrawList's key, most significant first: the mesh, whose change rebinds vertex and index buffers (and, without
+	// bindless, the model's descriptor set), the material, whose change pushes constants, the index range and the depth.
+	// Ids past 16 bits and ranges that hash alike only share bits; the batches still compare the items themselves.
+	uint64_t MakeSortKey( const Scene::DrawItem& item, float distanceSquared )
+	{
+		uint32_t range = ( item.firstIndex * 0x9E3779B1u ) ^ ( item.indexCount * 0x85EBCA77u );
+		range ^= range >> 16;
+
+		// A non-negative float's bits order like its value; the top 16 keep the exponent and 7 bits of mantissa
+		uint32_t depthBits;
+		std::memcpy( &depthBits, &distanceSquared, sizeof( depthBits ) );
+
+		return ( static_cast< uint64_t >( item.mesh & 0xFFFF ) << 48 ) | ( static_cast< uint64_t >( item.material & 0xFFFF ) << 32 )
+			| ( static_cast< uint64_t >( range & 0xFFFF ) << 16 ) | ( depthBits >> 16 );
+	}
+
+	// Stable LSD radix sort by key, a byte per pass. One read of the keys fills every pass's histogram, and a pass
+	// whose byte is the same for every entry is skipped; with a few dozen meshes and materials most high bytes are.
+	template <typename Entry>
+	void RadixSort( std::vector<Entry>& entries, std::vector<Entry>& scratch )
+	{
+		constexpr uint32_t DIGIT_BITS = 8;
+		constexpr uint32_t DIGIT_COUNT = 64 / DIGIT_BITS;
+		constexpr uint32_t BUCKET_COUNT = 1u << DIGIT_BITS;
+		constexpr uint64_t DIGIT_MASK = BUCKET_COUNT - 1;
+
+		const uint32_t count = static_cast< uint32_t >( entries.size() );
+		if ( count < 2 )
+		{
+			return;
+		}
+
+		uint32_t histograms[DIGIT_COUNT][BUCKET_COUNT] = {};
+
+		for ( const Entry& entry : entries )
+		{
+			for ( uint32_t digit = 0; digit < DIGIT_COUNT; ++digit )
+			{
+				++histograms[digit][( entry.key >> ( digit * DIGIT_BITS ) ) & DIGIT_MASK];
+			}
+		}
+
+		scratch.resize( count );
+
+		for ( uint32_t digit = 0; digit < DIGIT_COUNT; ++digit )
+		{
+			const uint32_t shift = digit * DIGIT_BITS;
+			uint32_t* pOffsets = histograms[digit];
+
+			if ( pOffsets[( entries[0].key >> shift ) & DIGIT_MASK] == count )
+			{
+				continue;
+			}
+
+			// Counts to the first position of each bucket
+			uint32_t offset = 0;
+			for ( uint32_t bucket = 0; bucket < BUCKET_COUNT; ++bucket )
+			{
+				const uint32_t bucketSize = pOffsets[bucket];
+				pOffsets[bucket] = offset;
+				offset += bucketSize;
+			}
+
+			for ( const Entry& entry : entries )
+			{
+				scratch[pOffsets[( entry.key >> shift ) & DIGIT_MASK]++] = entry;
+			}
+
+			entries.swap( scratch );
+		}
+	}
+
+	// out = a * b for column major matrices: column j of the result is a's columns weighted by column j of b.
+	// Same operation order as glm's operator*, so every path gives the same result. out must not alias a or b.
+	void MultiplyMatrices( const glm::mat4& a, const glm::mat4& b, glm::mat4& out )
+	{
+		const float* pA = &a[0][0];
+		const float* pB = &b[0][0];
+		float* pOut = &out[0][0];
+
+#if defined( SCENE_SIMD_SSE )
+		const __m128 a0 = _mm_loadu_ps( pA );
+		const __m128 a1 = _mm_loadu_ps( pA + 4 );
+		const __m128 a2 = _mm_loadu_ps( pA + 8 );
+		const __m128 a3 = _mm_loadu_ps( pA + 12 );
+
+		for ( int column = 0; column < 4; ++column )
+		{
+			const float* pColumn = pB + column * 4;
+
+			__m128 result = _mm_mul_ps( a0, _mm_set1_ps( pColumn[0] ) );
+			result = _mm_add_ps( result, _mm_mul_ps( a1, _mm_set1_ps( pColumn[1] ) ) );
+			result = _mm_add_ps( result, _mm_mul_ps( a2, _mm_set1_ps( pColumn[2] ) ) );
+			result = _mm_add_ps( result, _mm_mul_ps( a3, _mm_set1_ps( pColumn[3] ) ) );
+
+			_mm_storeu_ps( pOut + column * 4, result );
+		}
+#elif defined( SCENE_SIMD_NEON )
+		const float32x4_t a0 = vld1q_f32( pA );
+		const float32x4_t a1 = vld1q_f32( pA + 4 );
+		const float32x4_t a2 = vld1q_f32( pA + 8 );
+		const float32x4_t a3 = vld1q_f32( pA + 12 );
+
+		for ( int column = 0; column < 4; ++column )
+		{
+			const float* pColumn = pB + column * 4;
+
+			float32x4_t result = vmulq_n_f32( a0, pColumn[0] );
+			result = vaddq_f32( result, vmulq_n_f32( a1, pColumn[1] ) );
+			result = vaddq_f32( result, vmulq_n_f32( a2, pColumn[2] ) );
+			result = vaddq_f32( result, vmulq_n_f32( a3, pColumn[3] ) );
+
+			vst1q_f32( pOut + column * 4, result );
+		}
+#else
+		( void )pA;
+		( void )pB;
+		( void )pOut;
+
+		out = a * b;
+#endif
+	}
+
+	template<typename T>
+	void RotateComponents( std::vector<T>& components, uint32_t first, uint32_t middle, uint32_t last )
+	{
+		std::rotate( components.begin() + first, components.begin() + middle, components.begin() + last );
+	}
+}
+
+Scene::MeshId Scene::RegisterMesh( Model* pModel )
+{
+	auto found = std::find( Meshes.begin(), Meshes.end(), pModel );
+	if ( found != Meshes.end() )
+	{
+		return static_cast< MeshId >( found - Meshes.begin() );
+	}
+
+	Meshes.push_back( pModel );
+	MeshSpheres.push_back( glm::vec4( pModel->Bounds.center, pModel->Bounds.radius ) );
+
+	return static_cast< MeshId >( Meshes.size() - 1 );
+}
+
+Scene::Entity Scene::CreateEntity( MeshId mesh, uint32_t material, const glm::mat4& localTransform, Entity parent )
+{
+	assert( ( mesh == INVALID_MESH || mesh < Meshes.size() ) && "mesh not registered!" );
+
+	// A child goes at the end of its parent's subtree, a root at the end of the arrays
+	uint32_t parentIndex = NO_PARENT;
+	uint32_t position = GetEntityCount();
+
+	if ( parent != INVALID_ENTITY )
+	{
+		parentIndex = GetDenseIndex( parent );
+		position = parentIndex + SubtreeSizes[parentIndex];
+	}
+
+	uint32_t slot;
+	if ( !FreeSlots.empty() )
+	{
+		slot = FreeSlots.back();
+		FreeSlots.pop_back();
+	}
+	else
+	{
+		assert( SlotDenseIndices.size() <= INDEX_MASK && "too many entities!" );
+
+		slot = static_cast< uint32_t >( SlotDenseIndices.size() );
+		SlotDenseIndices.push_back( 0 );
+		SlotGenerations.push_back( 0 );
+	}
+
+	Entity entity = ( static_cast< uint32_t >( SlotGenerations[slot] ) << INDEX_BITS ) | slot;
+	uint32_t end = GetEntityCount();
+	SlotDenseIndices[slot] = end;
+
+	LocalTransforms.push_back( localTransform );
+	WorldTransforms.push_back( localTransform );
+	Parents.push_back( parentIndex );
+	SubtreeSizes.push_back( 1 );
+	MeshRefs.push_back( mesh );
+	Materials.push_back( material );
+	Tints.push_back( glm::vec4( 1.0f ) );
+	LodLevels.push_back( 0 );
+	Bounds.push_back( glm::vec4( 0.0f ) );
+	Visibility.push_back( 0 );
+	DirtyFlags.push_back( 0 );
+	DenseEntities.push_back( entity );
+
+	if ( position != end )
+	{
+		RotateEntities( position, end, end + 1 );
+	}
+
+	if ( parentIndex != NO_PARENT )
+	{
+		AddToAncestorSizes( parentIndex, 1 );
+	}
+
+	MarkDirty( position );
+	bSpatialIndexStale = true;
+
+	return entity;
+}
+
+void Scene::DestroyEntity( Entity entity )
+{
+	if ( !IsAlive( entity ) )
+	{
+		return;
+	}
+
+	uint32_t first = GetDenseIndex( entity );
+	uint32_t count = SubtreeSizes[first];
+
+	if ( Parents[first] != NO_PARENT )
+	{
+		AddToAncestorSizes( Parents[first], -static_cast< int32_t >( count ) );
+	}
+
+	// Wraps after 256 reuses of a slot; a handle held that long past its entity's death would alias
+	for ( uint32_t i = first; i < first + count; ++i )
+	{
+		uint32_t slot = GetSlot( DenseEntities[i] );
+		++SlotGenerations[slot];
+		FreeSlots.push_back( slot );
+	}
+
+	// Close the gap by moving everything after the subtree down, which keeps the depth first order
+	RotateEntities( first, first + count, GetEntityCount() );
+	PopEntities( count );
+
+	bSpatialIndexStale = true;
+}
+
+bool Scene::IsAlive( Entity entity ) const
+{
+	uint32_t slot = GetSlot( entity );
+
+	return entity != INVALID_ENTITY && slot < SlotGenerations.size() && SlotGenerations[slot] == GetGeneration( entity );
+}
+
+void Scene::SetParent( Entity entity, Entity parent )
+{
+	uint32_t index = GetDenseIndex( entity );
+	uint32_t count = SubtreeSizes[index];
+
+	if ( parent != INVALID_ENTITY )
+	{
+		uint32_t parentIndex = GetDenseIndex( parent );
+		assert( ( parentIndex < index || parentIndex >= index + count ) && "can't parent an entity to its own descendant!" );
+		( void )parentIndex;
+	}
+
+	if ( Parents[index] != NO_PARENT )
+	{
+		AddToAncestorSizes( Parents[index], -static_cast< int32_t >( count ) );
+	}
+
+	// Detach the subtree to the end of the arrays, then move it to the end of the new parent's subtree
+	uint32_t end = GetEntityCount();
+	RotateEntities( index, index + count, end );
+	index = end - count;
+
+	uint32_t parentIndex = NO_PARENT;
+
+	if ( parent != INVALID_ENTITY )
+	{
+		parentIndex = GetDenseIndex( parent );
+		uint32_t position = parentIndex + SubtreeSizes[parentIndex];
+
+		RotateEntities( position, index, end );
+		index = position;
+
+		AddToAncestorSizes( parentIndex, static_cast< int32_t >( count ) );
+	}
+
+	Parents[index] = parentIndex;
+	MarkDirty( index );
+	bSpatialIndexStale = true;
+}
+
+Scene::Entity Scene::GetParent( Entity entity ) const
+{
+	uint32_t parentIndex = Parents[GetDenseIndex( entity )];
+
+	return parentIndex == NO_PARENT ? INVALID_ENTITY : DenseEntities[parentIndex];
+}
+
+void Scene::SetLocalTransform( Entity entity, const glm::mat4& localTransform )
+{
+	uint32_t index = GetDenseIndex( entity );
+
+	LocalTransforms[index] = localTransform;
+	MarkDirty( index );
+}
+
+uint32_t Scene::GetDenseIndex( Entity entity ) const
+{
+	assert( IsAlive( entity ) && "stale entity handle!" );
+
+	return SlotDenseIndices[GetSlot( entity )];
+}
+
+void Scene::SetHidden( Entity entity, bool bHidden )
+{
+	uint8_t& flags = Visibility[GetDenseIndex( entity )];
+	flags = bHidden ? ( flags | VISIBILITY_HIDDEN ) : ( flags & ~VISIBILITY_HIDDEN );
+}
+
+void Scene::Update()
+{
+	UpdateWorldTransforms();
+
+	if ( bSpatialIndexStale )
+	{
+		SpatialIndex.Build( Bounds.data(), GetEntityCount() );
+		bSpatialIndexStale = false;
+	}
+	else
+	{
+		SpatialIndex.Refit( Bounds.data() );
+
+		if ( SpatialIndex.NeedsRebuild() )
+		{
+			SpatialIndex.Build( Bounds.data(), GetEntityCount() );
+		}
+	}
+}
+
+void Scene::UpdateWorldTransforms()
+{
+	if ( DirtyEntities.empty() )
+	{
+		return;
+	}
+
+	UpdateIndices.clear();
+
+	for ( Entity entity : DirtyEntities )
+	{
+		if ( IsAlive( entity ) )
+		{
+			UpdateIndices.push_back( GetDenseIndex( entity ) );
+		}
+	}
+
+	DirtyEntities.clear();
+
+	// Ancestors sort first, so a dirty entity inside a subtree already recomputed is skipped
+	std::sort( UpdateIndices.begin(), UpdateIndices.end() );
+
+	uint32_t updatedEnd = 0;
+
+	for ( uint32_t first : UpdateIndices )
+	{
+		if ( first < updatedEnd )
+		{
+			continue;
+		}
+
+		updatedEnd = first + SubtreeSizes[first];
+
+		if ( !bSpatialIndexStale )
+		{
+			SpatialIndex.MarkMoved( first, updatedEnd - first );
+		}
+
+		// Parents precede children, so each parent's world matrix is final by the time its children read it
+		for ( uint32_t i = first; i < updatedEnd; ++i )
+		{
+			if ( Parents[i] == NO_PARENT )
+			{
+				WorldTransforms[i] = LocalTransforms[i];
+			}
+			else
+			{
+				MultiplyMatrices( WorldTransforms[Parents[i]], LocalTransforms[i], WorldTransforms[i] );
+			}
+
+			const glm::mat4& world = WorldTransforms[i];
+			const glm::vec4 sphere = MeshRefs[i] == INVALID_MESH ? glm::vec4( 0.0f ) : MeshSpheres[MeshRefs[i]];
+
+			// The centre moves with the transform; the radius grows with the largest axis scale
+			float scaleSquared = std::max( glm::dot( glm::vec3( world[0] ), glm::vec3( world[0] ) ),
+				std::max( glm::dot( glm::vec3( world[1] ), glm::vec3( world[1] ) ), glm::dot( glm::vec3( world[2] ), glm::vec3( world[2] ) ) ) );
+
+			Bounds[i] = glm::vec4( glm::vec3( world * glm::vec4( glm::vec3( sphere ), 1.0f ) ), sphere.w * std::sqrt( scaleSquared ) );
+			DirtyFlags[i] = 0;
+		}
+	}
+}
+
+void Scene::Cull( const FrustumCulling::Frustum& frustum )
+{
+	assert( !bSpatialIndexStale && "entities created or destroyed since the last Update!" );
+
+	const BoundingVolumeHierarchy::CullResult result = SpatialIndex.CullFrustum( frustum, Visibility.data(), VISIBILITY_CULLED );
+
+	CullStats.nodesTested = result.nodesTested;
+	CullStats.objectsTested = result.itemsTested;
+	CullStats.objectsVisible = result.visibleItems;
+}
+
+Scene::Entity Scene::Raycast( const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* pDistance ) const
+{
+	assert( !bSpatialIndexStale && "entities created or destroyed since the last Update!" );
+
+	float distance;
+	const uint32_t item = SpatialIndex.Raycast( origin, direction, maxDistance, distance );
+
+	if ( item == BoundingVolumeHierarchy::INVALID_ITEM )
+	{
+		return INVALID_ENTITY;
+	}
+
+	if ( pDistance != nullptr )
+	{
+		*pDistance = distance;
+	}
+
+	return DenseEntities[item];
+}
+
+void Scene::QueryRange( const glm::vec3& center, float radius, std::vector<Entity>& entities ) const
+{
+	assert( !bSpatialIndexStale && "entities created or destroyed since the last Update!" );
+
+	std::vector<uint32_t> items;
+	SpatialIndex.QuerySphere( glm::vec4( center, radius ), items );
+
+	for ( uint32_t item : items )
+	{
+		entities.push_back( DenseEntities[item] );
+	}
+}
+
+void Scene::QueryBox( const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<Entity>& entities ) const
+{
+	assert( !bSpatialIndexStale && "entities created or destroyed since the last Update!" );
+
+	std::vector<uint32_t> items;
+	SpatialIndex.QueryBox( boxMin, boxMax, items );
+
+	for ( uint32_t item : items )
+	{
+		entities.push_back( DenseEntities[item] );
+	}
+}
+
+void Scene::SelectLods( const glm::vec3& cameraPosition, float pixelsPerUnit, float pixelThreshold )
+{
+	const uint32_t count = GetEntityCount();
+
+	LodStats = LodStatistics();
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		if ( MeshRefs[i] == INVALID_MESH )
+		{
+			continue;
+		}
+
+		const std::vector<MeshLod>& lods = Meshes[MeshRefs[i]]->Lods;
+		const uint32_t lodCount = static_cast< uint32_t >( lods.size() );
+		const float distance = glm::length( glm::vec3( Bounds[i] ) - cameraPosition );
+
+		uint32_t level = std::min< uint32_t >( LodLevels[i], lodCount > 0 ? lodCount - 1 : 0 );
+
+		if ( distance <= Bounds[i].w )
+		{
+			level = 0;	// inside the bounds the projection is meaningless; draw the full mesh
+		}
+		else
+		{
+			// Errors are fractions of the model space radius, so they scale with the world radius too
+			const float radiusPixels = Bounds[i].w / distance * pixelsPerUnit;
+
+			while ( level > 0 && lods[level].error * radiusPixels > pixelThreshold )
+			{
+				--level;
+			}
+
+			while ( level + 1 < lodCount && lods[level + 1].error * radiusPixels <= pixelThreshold * LOD_HYSTERESIS )
+			{
+				++level;
+			}
+		}
+
+		if ( level != LodLevels[i] )
+		{
+			LodLevels[i] = static_cast< uint8_t >( level );
+			++LodStats.levelChanges;
+		}
+
+		++LodStats.entitiesPerLevel[level];
+	}
+}
+
+void Scene::ExtractDrawList( std::vector<DrawItem>& drawList, const FrustumCulling::Frustum* pFrustum )
+{
+	const uint32_t count = GetEntityCount();
+
+	drawList.clear();
+	drawList.reserve( count );
+
+	CullStats.submeshesTested = 0;
+	CullStats.submeshesVisible = 0;
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		if ( Visibility[i] != 0 || MeshRefs[i] == INVALID_MESH )
+		{
+			continue;
+		}
+
+		const Model* pModel = Meshes[MeshRefs[i]];
+		const std::vector<Submesh>& submeshes = pModel->Submeshes;
+
+		// Coarser levels are one range over every submesh, so they're drawn whole
+		if ( LodLevels[i] > 0 )
+		{
+			const MeshLod& lod = pModel->Lods[LodLevels[i]];
+			drawList.push_back( DrawItem{ MeshRefs[i], Materials[i], i, lod.firstIndex, lod.indexCount } );
+			continue;
+		}
+
+		if ( pFrustum == nullptr || submeshes.size() <= 1 || FrustumCulling::ContainsSphere( *pFrustum, Bounds[i] ) )
+		{
+			drawList.push_back( DrawItem{ MeshRefs[i], Materials[i], i, 0, pModel->GetIndexCount() } );
+			continue;
+		}
+
+		CullStats.submeshesTested += static_cast< uint32_t >( submeshes.size() );
+
+		for ( const Submesh& submesh : submeshes )
+		{
+			if ( !FrustumCulling::IsBoxVisible( *pFrustum, submesh.bounds.min, submesh.bounds.max, WorldTransforms[i] ) )
+			{
+				continue;
+			}
+
+			++CullStats.submeshesVisible;
+
+			// Submeshes are consecutive index ranges, so neighbouring visible ones share a draw
+			DrawItem* pPrevious = drawList.empty() ? nullptr : &drawList.back();
+
+			if ( pPrevious != nullptr && pPrevious->object == i && pPrevious->firstIndex + pPrevious->indexCount == submesh.firstIndex )
+			{
+				pPrevious->indexCount += submesh.indexCount;
+			}
+			else
+			{
+				drawList.push_back( DrawItem{ MeshRefs[i], Materials[i], i, submesh.firstIndex, submesh.indexCount } );
+			}
+		}
+	}
+}
+
+void Scene::BatchDrawList( std::vector<DrawItem>& drawList, std::vector<DrawBatch>& batches, const glm::vec3& cameraPosition )
+{
+	const uint32_t count = static_cast< uint32_t >( drawList.size() );
+
+	SortEntries.resize( count );
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		const glm::vec3 offset = glm::vec3( Bounds[drawList[i].object] ) - cameraPosition;
+		SortEntries[i] = DrawSortEntry{ MakeSortKey( drawList[i], glm::dot( offset, offset ) ), i };
+	}
+
+	RadixSort( SortEntries, SortScratch );
+
+	SortedItems.resize( count );
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		SortedItems[i] = drawList[SortEntries[i].item];
+	}
+
+	drawList.swap( SortedItems );
+
+	batches.clear();
+
+	for ( uint32_t i = 0; i < drawList.size(); ++i )
+	{
+		const DrawItem& item = drawList[i];
+		DrawBatch* pBatch = batches.empty() ? nullptr : &batches.back();
+
+		if ( pBatch != nullptr && pBatch->mesh == item.mesh && pBatch->material == item.material && pBatch->firstIndex == item.firstIndex && pBatch->indexCount == item.indexCount )
+		{
+			++pBatch->instanceCount;
+		}
+		else
+		{
+			batches.push_back( DrawBatch{ item.mesh, item.material, item.firstIndex, item.indexCount, i, 1 } );
+		}
+	}
+}
+
+void Scene::Clear()
+{
+	Meshes.clear();
+	MeshSpheres.clear();
+
+	PopEntities( GetEntityCount() );
+	DirtyEntities.clear();
+
+	SlotDenseIndices.clear();
+	SlotGenerations.clear();
+	FreeSlots.clear();
+
+	SpatialIndex.Clear();
+	bSpatialIndexStale = false;
+}
+
+void Scene::MarkDirty( uint32_t denseIndex )
+{
+	if ( DirtyFlags[denseIndex] == 0 )
+	{
+		DirtyFlags[denseIndex] = 1;
+		DirtyEntities.push_back( DenseEntities[denseIndex] );
+	}
+}
+
+void Scene::AddToAncestorSizes( uint32_t parentIndex, int32_t delta )
+{
+	for ( uint32_t i = parentIndex; i != NO_PARENT; i = Parents[i] )
+	{
+		SubtreeSizes[i] = static_cast< uint32_t >( static_cast< int32_t >( SubtreeSizes[i] ) + delta );
+	}
+}
+
+void Scene::RotateEntities( uint32_t first, uint32_t middle, uint32_t last )
+{
+	if ( first == middle || middle == last )
+	{
+		return;
+	}
+
+	RotateComponents( LocalTransforms, first, middle, last );
+	RotateComponents( WorldTransforms, first, middle, last );
+	RotateComponents( Parents, first, middle, last );
+	RotateComponents( SubtreeSizes, first, middle, last );
+	RotateComponents( MeshRefs, first, middle, last );
+	RotateComponents( Materials, first, middle, last );
+	RotateComponents( Tints, first, middle, last );
+	RotateComponents( LodLevels, first, middle, last );
+	RotateComponents( Bounds, first, middle, last );
+	RotateComponents( Visibility, first, middle, last );
+	RotateComponents( DirtyFlags, first, middle, last );
+	RotateComponents( DenseEntities, first, middle, last );
+
+	// Entities before first only have parents before first, so only the rest can point into the moved range
+	const uint32_t count = GetEntityCount();
+
+	for ( uint32_t i = first; i < count; ++i )
+	{
+		uint32_t& parentIndex = Parents[i];
+
+		if ( parentIndex == NO_PARENT || parentIndex < first || parentIndex >= last )
+		{
+			continue;
+		}
+
+		parentIndex = parentIndex < middle ? parentIndex + ( last - middle ) : parentIndex - ( middle - first );
+	}
+
+	for ( uint32_t i = first; i < last; ++i )
+	{
+		SlotDenseIndices[GetSlot( DenseEntities[i] )] = i;
+	}
+}
+
+void Scene::PopEntities( uint32_t count )
+{
+	const size_t size = DenseEntities.size() - count;
+
+	LocalTransforms.resize( size );
+	WorldTransforms.resize( size );
+	Parents.resize( size );
+	SubtreeSizes.resize( size );
+	MeshRefs.resize( size );
+	Materials.resize( size );
+	Tints.resize( size );
+	LodLevels.resize( size );
+	Bounds.resize( size );
+	Visibility.resize( size );
+	DirtyFlags.resize( size );
+	DenseEntities.resize( size );
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCulling.h"
+
+class Model;
+
+// Everything the renderer draws, stored as entities whose components live in parallel dense
+// arrays (structure of arrays): index i of every array belongs to the same entity, and the live
+// entities are always packed into [0, GetEntityCount()). The per-frame passes walk only the
+// arrays they need, front to back, instead of chasing one heap object per drawable.
+//
+// Entities form a transform hierarchy. The arrays are kept in depth first order, so a parent
+// always comes before its children and an entity's subtree is the contiguous range
+// [i, i + subtree size). Setting a local transform marks the entity dirty; Update recomputes
+// world matrices only over the subtrees of dirty entities, so its cost follows what moved
+// rather than the size of the scene. Keeping the order means creating a child, destroying or
+// reparenting shifts the entities after it, which is linear in the scene size.
+//
+// Handles stay valid while other entities come and go: a handle names a slot in a sparse table
+// that holds the entity's dense index and a generation, so a handle to a destroyed entity is
+// recognised. Dense indices (and the pointers from the Get*s() accessors) are only stable until
+// the next Create, Destroy or SetParent.
+//
+// Meshes are Models registered once and shared by any number of entities through a MeshId.
+//
+// The world bounding spheres are indexed by a BoundingVolumeHierarchy for culling, picking and
+// range queries. Update refits it over the subtrees it recomputed; since its items are dense
+// indices, any Create, Destroy or SetParent has it rebuilt instead.
+class Scene
+{
+public:
+	using Entity = uint32_t;	// slot index in the low 24 bits, generation in the high 8
+	using MeshId = uint32_t;
+
+	static constexpr Entity INVALID_ENTITY = UINT32_MAX;
+	static constexpr MeshId INVALID_MESH = UINT32_MAX;	// for pivots and other entities that only carry a transform
+
+	enum VisibilityFlags : uint8_t
+	{
+		VISIBILITY_HIDDEN = 1 << 0,	// set by the app
+		VISIBILITY_CULLED = 1 << 1,	// set each frame by culling passes
+	};
+
+	// One draw for the render pass; object indexes the dense arrays as of extraction. The index
+	// range is the whole mesh, the visible submeshes of a mesh the frustum only partly covers,
+	// or the entity's coarser level of detail.
+	struct DrawItem
+	{
+		MeshId mesh;
+		uint32_t material;
+		uint32_t object;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	// One instanced draw: draw list entries [firstInstance, firstInstance + instanceCount) share the
+	// mesh, material and index range, and entry i is drawn as instance i.
+	struct DrawBatch
+	{
+		MeshId mesh;
+		uint32_t material;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	// Counters from the last Cull and ExtractDrawList
+	struct CullingStatistics
+	{
+		uint32_t nodesTested = 0;		// hierarchy nodes; objects under a node entirely in or out aren't tested themselves
+		uint32_t objectsTested = 0;
+		uint32_t objectsVisible = 0;
+		uint32_t submeshesTested = 0;	// only for visible objects the frustum doesn't fully contain
+		uint32_t submeshesVisible = 0;
+	};
+
+	// Counters from the last SelectLods
+	struct LodStatistics
+	{
+		uint32_t entitiesPerLevel[4] = {};	// MAX_MESH_LODS; entities with a mesh, hidden and culled ones included
+		uint32_t levelChanges = 0;
+	};
+
+	MeshId RegisterMesh( Model* pModel );
+	Model* GetMesh( MeshId mesh ) const { return Meshes[mesh]; }
+	const std::vector<Model*>& GetMeshes() const { return Meshes; }
+
+	// material is the bindless slot pushed with the entity's draws; without bindless the mesh's own texture is used.
+	// localTransform is relative to parent, or to the world for a root.
+	Entity CreateEntity( MeshId mesh, uint32_t material, const glm::mat4& localTransform = glm::mat4( 1.0f ), Entity parent = INVALID_ENTITY );
+	// Destroys the entity and all its descendants
+	void DestroyEntity( Entity entity );
+	bool IsAlive( Entity entity ) const;
+
+	// Keeps the local transform, so the subtree moves with its new parent from the next Update. INVALID_ENTITY makes it a root.
+	void SetParent( Entity entity, Entity parent );
+	Entity GetParent( Entity entity ) const;
+
+	void SetLocalTransform( Entity entity, const glm::mat4& localTransform );
+	const glm::mat4& GetLocalTransform( Entity entity ) const { return LocalTransforms[GetDenseIndex( entity )]; }
+	// As of the last Update
+	const glm::mat4& GetWorldTransform( Entity entity ) const { return WorldTransforms[GetDenseIndex( entity )]; }
+
+	void SetMaterial( Entity entity, uint32_t material ) { Materials[GetDenseIndex( entity )] = material; }
+	// Multiplies the mesh's vertex colours; white by default
+	void SetTint( Entity entity, const glm::vec4& tint ) { Tints[GetDenseIndex( entity )] = tint; }
+	const glm::vec4& GetTint( Entity entity ) const { return Tints[GetDenseIndex( entity )]; }
+	void SetHidden( Entity entity, bool bHidden );
+
+	// Dense component arrays for the per-frame passes; see the class comment for how long they stay valid
+	uint32_t GetEntityCount() const { return static_cast< uint32_t >( DenseEntities.size() ); }
+	uint32_t GetDenseIndex( Entity entity ) const;
+	Entity GetEntity( uint32_t denseIndex ) const { return DenseEntities[denseIndex]; }
+	// A handle's slot stays the entity's for its whole life, unlike its dense index; destroyed entities' slots are reused
+	static uint32_t GetSlot( Entity entity ) { return entity & INDEX_MASK; }
+	uint32_t GetSlotCount() const { return static_cast< uint32_t >( SlotDenseIndices.size() ); }
+	const glm::mat4* GetWorldTransforms() const { return WorldTransforms.data(); }
+	const glm::vec4* GetBounds() const { return Bounds.data(); }
+	const MeshId* GetMeshRefs() const { return MeshRefs.data(); }
+	const uint32_t* GetMaterials() const { return Materials.data(); }
+	const glm::vec4* GetTints() const { return Tints.data(); }
+	const uint8_t* GetLodLevels() const { return LodLevels.data(); }
+	uint8_t* GetVisibility() { return Visibility.data(); }
+
+	// Per-frame update pass: recomputes world matrices and world bounds of every dirty subtree, then refits or rebuilds the spatial index
+	void Update();
+
+	// Culling pass, after Update: sets VISIBILITY_CULLED on every entity whose world bounding sphere is outside the frustum and clears it on the rest
+	void Cull( const FrustumCulling::Frustum& frustum );
+
+	// Level of detail pass, after Update: picks each entity's LOD (see Model::Lods) from its projected size. The coarsest
+	// level whose error, projected to pixels, stays within pixelThreshold wins. pixelsPerUnit is the screen height over
+	// 2 * tan( fovY / 2 ), i.e. the size in pixels of one unit at distance one. Hysteresis keeps entities near a boundary
+	// from flickering between levels: a level is left for a finer one as soon as its error exceeds the threshold, but a
+	// coarser level is only taken once its error is well within it.
+	void SelectLods( const glm::vec3& cameraPosition, float pixelsPerUnit, float pixelThreshold );
+
+	// Queries against the world bounding spheres as of the last Update, hidden, culled and meshless entities included.
+	// Raycast returns the nearest entity hit within maxDistance (in units of direction's length), or INVALID_ENTITY.
+	Entity Raycast( const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* pDistance = nullptr ) const;
+	void QueryRange( const glm::vec3& center, float radius, std::vector<Entity>& entities ) const;
+	void QueryBox( const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<Entity>& entities ) const;
+	const BoundingVolumeHierarchy& GetSpatialIndex() const { return SpatialIndex; }
+
+	// Render extraction pass: DrawItems for every entity with a mesh and no visibility flags set, in dense order.
+	// With pFrustum, an entity whose sphere crosses the frustum draws only the submeshes whose boxes are visible.
+	void ExtractDrawList( std::vector<DrawItem>& drawList, const FrustumCulling::Frustum* pFrustum = nullptr );
+
+	// Sorts the draw list so items with the same mesh, material and index range are adjacent, and emits one
+	// batch per run. A thousand entities sharing a mesh and material become one instanced draw.
+	// The order is that of a 64-bit key per item, radix sorted: mesh, material, index range, then distance from
+	// cameraPosition, so batches that share a mesh follow each other and each batch's instances go front to back.
+	void BatchDrawList( std::vector<DrawItem>& drawList, std::vector<DrawBatch>& batches, const glm::vec3& cameraPosition );
+
+	const CullingStatistics& GetCullingStatistics() const { return CullStats; }
+	const LodStatistics& GetLodStatistics() const { return LodStats; }
+
+	// Forgets every entity and mesh; the Models themselves belong to whoever registered them
+	void Clear();
+
+private:
+	static constexpr uint32_t INDEX_BITS = 24;
+	static constexpr uint32_t INDEX_MASK = ( 1u << INDEX_BITS ) - 1;
+	static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+	static uint32_t GetGeneration( Entity entity ) { return entity >> INDEX_BITS; }
+
+	void UpdateWorldTransforms();
+	void MarkDirty( uint32_t denseIndex );
+	void AddToAncestorSizes( uint32_t parentIndex, int32_t delta );
+	// std::rotate( first, middle, last ) on every component array, then fixes up parent indices and the slot table
+	void RotateEntities( uint32_t first, uint32_t middle, uint32_t last );
+	void PopEntities( uint32_t count );
+
+	// Meshes, by MeshId
+	std::vector<Model*> Meshes;
+	std::vector<glm::vec4> MeshSpheres;	// model space bounding sphere: xyz centre, w radius
+
+	// Components, by dense index
+	std::vector<glm::mat4> LocalTransforms;	// relative to the parent
+	std::vector<glm::mat4> WorldTransforms;	// model to world
+	std::vector<uint32_t> Parents;			// dense index, NO_PARENT for roots
+	std::vector<uint32_t> SubtreeSizes;		// including the entity itself
+	std::vector<MeshId> MeshRefs;
+	std::vector<uint32_t> Materials;
+	std::vector<glm::vec4> Tints;
+	std::vector<uint8_t> LodLevels;			// index into the mesh's Lods, as of the last SelectLods
+	std::vector<glm::vec4> Bounds;			// world space bounding sphere: xyz centre, w radius
+	std::vector<uint8_t> Visibility;
+	std::vector<uint8_t> DirtyFlags;		// 1 while queued in DirtyEntities
+	std::vector<Entity> DenseEntities;		// owning handle, to patch the slot table when entities move
+
+	// Handles rather than dense indices, since those shift when entities are created or destroyed before Update
+	std::vector<Entity> DirtyEntities;
+	std::vector<uint32_t> UpdateIndices;	// scratch for Update, kept to reuse its allocation
+
+	// Slot table, by handle slot
+	std::vector<uint32_t> SlotDenseIndices;
+	std::vector<uint8_t> SlotGenerations;
+	std::vector<uint32_t> FreeSlots;
+
+	// Scratch for BatchDrawList, kept to reuse their allocations
+	struct DrawSortEntry
+	{
+		uint64_t key;
+		uint32_t item;	// index into the unsorted draw list
+	};
+	std::vector<DrawSortEntry> SortEntries;
+	std::vector<DrawSortEntry> SortScratch;
+	std::vector<DrawItem> SortedItems;
+
+	// Items are dense indices, by the Bounds as of the last Update
+	BoundingVolumeHierarchy SpatialIndex;
+	bool bSpatialIndexStale = false;	// dense indices changed since the last build
+
+	CullingStatistics CullStats;
+	LodStatistics LodStats;
+};
\ No newline at end of file
@@ -8,8 +8,12 @@
 VulkanShader::VulkanShader( VulkanGraphicsInstance* pInstance, const char* filename )
 	: pGraphicsInstance( pInstance )
 {
-	shaderCode = FileUtils::ReadFile( filename );
-	shaderModule = CreateShaderModule( shaderCode );
+	// SPIR-V goes to the driver straight from the mapping or archive, both aligned as pCode requires
+	FileView shaderFile;
+	VirtualFileSystem::Open( filename, shaderFile );
+	assert( shaderFile.IsOpen() && "failed to open file!" );
+
+	shaderModule = CreateShaderModule( shaderFile.GetData(), shaderFile.GetSize() );
 }
 
 VulkanShader::~VulkanShader()
@@ -25,12 +29,12 @@ void VulkanShader::GetCreateInfoInternal( VkPipelineShaderStageCreateInfo& info
 	info.pSpecializationInfo = nullptr;
 }
 
-VkShaderModule VulkanShader::CreateShaderModule( const std::vector<char>& code )
+VkShaderModule VulkanShader::CreateShaderModule( const void* pCode, size_t codeSize )
 {
 	VkShaderModuleCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast< const uint32_t* >( code.data() );
+	createInfo.codeSize = codeSize;
+	createInfo.pCode = static_cast< const uint32_t* >( pCode );
 
 	VkShaderModule module;
 	VkResult result = vkCreateShaderModule( *pGraphicsInstance->GetDevice(), &createInfo, nullptr, &module );
@@ -64,5 +68,19 @@ VkPipelineShaderStageCreateInfo VulkanFragmentShader::GetCreateInfo()
 	GetCreateInfoInternal( shaderStageInfo ); 
 	shaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+	return shaderStageInfo;
+}
+
+VulkanComputeShader::VulkanComputeShader( VulkanGraphicsInstance* pInstance, const char* filename )
+	: VulkanShader( pInstance, filename )
+{}
+
+VkPipelineShaderStageCreateInfo VulkanComputeShader::GetCreateInfo()
+{
+	VkPipelineShaderStageCreateInfo shaderStageInfo = {};
+
+	GetCreateInfoInternal( shaderStageInfo );
+	shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+
 	return shaderStageInfo;
 }
\ No newline at end of file
@@ -19,9 +19,8 @@ public:
 protected:
 	void GetCreateInfoInternal( VkPipelineShaderStageCreateInfo& info );
 
-	VkShaderModule CreateShaderModule( const std::vector<char>& code );
+	VkShaderModule CreateShaderModule( const void* pCode, size_t codeSize );
 
-	std::vector<char> shaderCode;
 	VkShaderModule shaderModule;
 	VulkanGraphicsInstance* pGraphicsInstance;
 };
@@ -45,5 +44,16 @@ public:
 	VulkanFragmentShader& operator=( const VulkanFragmentShader& ) = default;
 	virtual ~VulkanFragmentShader() = default;
 
+	virtual VkPipelineShaderStageCreateInfo GetCreateInfo() override;
+};
+
+class VulkanComputeShader : public VulkanShader
+{
+public:
+	VulkanComputeShader( VulkanGraphicsInstance* pInstance, const char* filename );
+	VulkanComputeShader( const VulkanComputeShader& ) = default;
+	VulkanComputeShader& operator=( const VulkanComputeShader& ) = default;
+	virtual ~VulkanComputeShader() = default;
+
 	virtual VkPipelineShaderStageCreateInfo GetCreateInfo() override;
 };
\ No newline at end of file
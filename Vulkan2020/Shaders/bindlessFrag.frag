@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform PushConstants
+{
+	uint materialIndex;
+} pushConstants;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUV;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+	outColor = vec4(fragColor * texture(textures[nonuniformEXT(pushConstants.materialIndex)], fragUV).rgb, 1.0);
+}
\ No newline at end of file
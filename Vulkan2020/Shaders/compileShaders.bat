@@ -2,4 +2,12 @@ C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe
 C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe shader.frag -o frag.spv
 C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe colorFrag.frag -o colorFrag.spv
 C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe textureFrag.frag -o textureFrag.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe --target-env=vulkan1.2 bindlessFrag.frag -o bindlessFrag.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe indirectVert.vert -o indirectVert.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe --target-env=vulkan1.2 bindlessIndirectFrag.frag -o bindlessIndirectFrag.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe cull.comp -o cull.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe clusterCull.comp -o clusterCull.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe occlusionCull.comp -o occlusionCull.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe depthReduce.comp -o depthReduce.spv
+C:\Users\N8\source\repos\Vulkan2020\external\VulkanSDK\1.2.131.2\Bin32\glslc.exe depthReduceMS.comp -o depthReduceMS.spv
 pause
\ No newline at end of file
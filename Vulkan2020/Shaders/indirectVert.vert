@@ -0,0 +1,43 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Vertex shader for GPUCuller's indirect draws: per-object data comes from the object buffer,
+// indexed by the firstInstance the cull shader wrote, instead of push constants.
+layout(binding = 0) uniform UniformBufferObject
+{
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+struct ObjectData
+{
+	mat4 model;
+	vec4 sphere;
+	vec4 tint;
+	uint mesh;
+	uint material;
+	uint lod;
+	uint entity;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects
+{
+	ObjectData objects[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragMaterial;
+
+void main() {
+	ObjectData object = objects[gl_InstanceIndex];
+	gl_Position = ubo.proj * ubo.view * object.model * vec4(inPosition, 1.0);
+	fragColor = inColor * object.tint.rgb;
+	fragUV = inUV;
+	fragMaterial = object.material;
+}
\ No newline at end of file
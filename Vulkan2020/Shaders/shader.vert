@@ -3,7 +3,6 @@
 
 layout(binding = 0) uniform UniformBufferObject
 {
-	mat4 model;
 	mat4 view;
 	mat4 proj;
 } ubo;
@@ -13,11 +12,15 @@ layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
 
+// InstanceData, binding 1 at instance rate
+layout(location = 4) in mat4 inModel;
+layout(location = 8) in vec4 inTint;
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragUV;
 
 void main() {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-	fragColor = inColor;
+	gl_Position = ubo.proj * ubo.view * inModel * vec4(inPosition, 1.0);
+	fragColor = inColor * inTint.rgb;
 	fragUV = inUV;
-}
+}
\ No newline at end of file
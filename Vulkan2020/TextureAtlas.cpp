@@ -0,0 +1,186 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "MipGenerator.h"
+#include "TextureDecodePool.h"
+
+namespace
+{
+	struct Shelf
+	{
+		uint32_t page;
+		uint32_t y;
+		uint32_t height;
+		uint32_t usedWidth;
+	};
+
+	uint32_t AlignUp( uint32_t value, uint32_t alignment )
+	{
+		return ( value + alignment - 1 ) / alignment * alignment;
+	}
+
+	// Copies the image into its cell, repeating its edge texels out to the cell border
+	void CopyWithGutter( const uint8_t* pixels, uint32_t width, uint32_t height, uint8_t* page, uint32_t pageSize, const TextureAtlas::PackedRect& cell, uint32_t gutter )
+	{
+		for ( uint32_t row = 0; row < cell.height; ++row )
+		{
+			uint32_t srcRow = static_cast< uint32_t >( std::min( std::max( static_cast< int64_t >( row ) - gutter, int64_t( 0 ) ), int64_t( height - 1 ) ) );
+			const uint8_t* src = pixels + static_cast< size_t >( srcRow ) * width * 4;
+			uint8_t* dst = page + ( static_cast< size_t >( cell.y + row ) * pageSize + cell.x ) * 4;
+
+			for ( uint32_t column = 0; column < gutter; ++column )
+			{
+				memcpy( dst + column * 4, src, 4 );
+			}
+
+			memcpy( dst + gutter * 4, src, static_cast< size_t >( width ) * 4 );
+
+			for ( uint32_t column = gutter + width; column < cell.width; ++column )
+			{
+				memcpy( dst + column * 4, src + ( width - 1 ) * 4, 4 );
+			}
+		}
+	}
+}
+
+uint32_t TextureAtlas::PackRectangles( std::vector<PackedRect>& rects, uint32_t pageSize )
+{
+	std::vector<uint32_t> order( rects.size() );
+	for ( uint32_t i = 0; i < order.size(); ++i )
+	{
+		order[i] = i;
+	}
+
+	std::stable_sort( order.begin(), order.end(), [&]( uint32_t a, uint32_t b ) { return rects[a].height > rects[b].height; } );
+
+	std::vector<Shelf> shelves;
+	std::vector<uint32_t> pageHeights;	// top of the free space below the last shelf, per page
+
+	for ( uint32_t index : order )
+	{
+		PackedRect& rect = rects[index];
+		assert( rect.width <= pageSize && rect.height <= pageSize && "rectangle larger than an atlas page!" );
+
+		// First shelf with room, else a new shelf on the first page with height left, else a new page
+		Shelf* pShelf = nullptr;
+
+		for ( Shelf& shelf : shelves )
+		{
+			if ( rect.height <= shelf.height && shelf.usedWidth + rect.width <= pageSize )
+			{
+				pShelf = &shelf;
+				break;
+			}
+		}
+
+		if ( pShelf == nullptr )
+		{
+			uint32_t page = 0;
+			while ( page < pageHeights.size() && pageHeights[page] + rect.height > pageSize )
+			{
+				++page;
+			}
+
+			if ( page == pageHeights.size() )
+			{
+				pageHeights.push_back( 0 );
+			}
+
+			shelves.push_back( Shelf{ page, pageHeights[page], rect.height, 0 } );
+			pageHeights[page] += rect.height;
+
+			pShelf = &shelves.back();
+		}
+
+		rect.x = pShelf->usedWidth;
+		rect.y = pShelf->y;
+		rect.page = pShelf->page;
+
+		pShelf->usedWidth += rect.width;
+	}
+
+	return static_cast< uint32_t >( pageHeights.size() );
+}
+
+void TextureAtlas::Build( TextureDecodePool& decodePool, const std::vector<std::string>& paths, const BuildOptions& options, std::vector<TextureData>& pages, std::vector<Region>& regions )
+{
+	assert( options.mipLevels >= 1 && ( options.pageSize & ( ( 1u << ( options.mipLevels - 1 ) ) - 1 ) ) == 0 && "atlas page size must be a multiple of the cell alignment!" );
+
+	const uint32_t alignment = 1u << ( options.mipLevels - 1 );
+	const uint32_t gutter = alignment;
+
+	regions.assign( paths.size(), Region() );
+	pages.clear();
+
+	// Read every header first so only images that will be packed get decoded
+	std::vector<TextureDecodePool::Request> requests( paths.size() );
+	for ( size_t i = 0; i < paths.size(); ++i )
+	{
+		requests[i].path = paths[i];
+	}
+
+	decodePool.PrepareBatch( requests );
+
+	for ( TextureDecodePool::Request& request : requests )
+	{
+		bool bTooLarge = std::max( request.width, request.height ) > options.maxImageSize
+			|| AlignUp( std::max( request.width, request.height ) + 2 * gutter, alignment ) > options.pageSize;
+
+		request.bSuccess = request.bSuccess && !bTooLarge;
+	}
+
+	std::vector<uint8_t> pixels( static_cast< size_t >( decodePool.LayoutBatch( requests ) ) );
+	decodePool.DecodeBatch( requests, pixels.data() );
+
+	std::vector<PackedRect> rects;
+	std::vector<size_t> rectPaths;
+
+	for ( size_t i = 0; i < requests.size(); ++i )
+	{
+		if ( requests[i].bSuccess )
+		{
+			rects.push_back( PackedRect{ AlignUp( requests[i].width + 2 * gutter, alignment ), AlignUp( requests[i].height + 2 * gutter, alignment ), 0, 0, 0 } );
+			rectPaths.push_back( i );
+		}
+	}
+
+	if ( rects.empty() )
+	{
+		return;
+	}
+
+	uint32_t pageCount = PackRectangles( rects, options.pageSize );
+
+	std::vector<std::vector<uint8_t>> canvases( pageCount, std::vector<uint8_t>( static_cast< size_t >( options.pageSize ) * options.pageSize * 4, 0 ) );
+
+	for ( size_t i = 0; i < rects.size(); ++i )
+	{
+		const PackedRect& rect = rects[i];
+		const TextureDecodePool::Request& request = requests[rectPaths[i]];
+
+		CopyWithGutter( pixels.data() + request.offset, request.width, request.height, canvases[rect.page].data(), options.pageSize, rect, gutter );
+
+		Region& region = regions[rectPaths[i]];
+		region.page = rect.page;
+		region.uvOffset = glm::vec2( rect.x + gutter, rect.y + gutter ) / static_cast< float >( options.pageSize );
+		region.uvScale = glm::vec2( request.width, request.height ) / static_cast< float >( options.pageSize );
+	}
+
+	pages.resize( pageCount );
+
+	for ( uint32_t page = 0; page < pageCount; ++page )
+	{
+		TextureData& pageData = pages[page];
+		MipGenerator::GenerateMipChain( canvases[page].data(), options.pageSize, options.pageSize, options.bSRGB, pageData );
+
+		// Levels past the gutter would blend neighbouring images
+		uint32_t levelCount = std::min( options.mipLevels, static_cast< uint32_t >( pageData.mips.size() ) );
+		pageData.mips.resize( levelCount );
+		pageData.data.resize( pageData.mips.back().offset + pageData.mips.back().size );
+
+		std::vector<uint8_t>().swap( canvases[page] );
+	}
+}
\ No newline at end of file
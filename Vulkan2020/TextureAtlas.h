@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "TextureFormats.h"
+
+class TextureDecodePool;
+
+// Packs small textures into shared RGBA8 pages at import, so props with tiny textures share one
+// image, view and bindless slot instead of each paying for their own. Models using an atlased
+// texture get their UVs remapped into its region (Model::RemapUVs); UVs outside [0, 1] rely on
+// repeat addressing, which an atlas can't provide, so those models keep their own texture.
+//
+// Mip-safe padding: every image sits in a cell aligned to 2^(mipLevels - 1) texels with a gutter
+// of that many edge-extended texels around it. The 2x2 box filter then never mixes two images in
+// the page's mip chain, and bilinear taps at the smallest level still land in the image's gutter.
+namespace TextureAtlas
+{
+	constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+
+	struct BuildOptions
+	{
+		uint32_t pageSize = 2048;
+		uint32_t maxImageSize = 256;	// images larger than this on either side are left out
+		uint32_t mipLevels = 4;			// levels in each page; every extra level doubles the gutter
+		bool bSRGB = true;
+	};
+
+	struct Region
+	{
+		uint32_t page = INVALID_PAGE;	// INVALID_PAGE if the image is missing or too large
+		glm::vec2 uvOffset = glm::vec2( 0.0f );
+		glm::vec2 uvScale = glm::vec2( 1.0f );
+	};
+
+	struct PackedRect
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t x;
+		uint32_t y;
+		uint32_t page;
+	};
+
+	// Shelf packs rects (width and height set, no larger than pageSize) tallest first, filling in
+	// x, y and page; returns the number of pages used
+	uint32_t PackRectangles( std::vector<PackedRect>& rects, uint32_t pageSize );
+
+	// regions gets one entry per path; pages get mip chains of options.mipLevels levels
+	void Build( TextureDecodePool& decodePool, const std::vector<std::string>& paths, const BuildOptions& options, std::vector<TextureData>& pages, std::vector<Region>& regions );
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "TextureCache.h"
+
+#include <cassert>
+#include <filesystem>
+
+#include "FileUtils.h"
+#include "ModelClass.h"
+
+namespace
+{
+	// The same key the VFS resolves archived paths with; also fine for paths that don't exist, e.g. a source image shipped only as .vtex
+	std::string GetNormalizedPath( const char* filename )
+	{
+		return VirtualFileSystem::NormalizePath( ( std::filesystem::path( TEXTURE_PATH ) / filename ).string() );
+	}
+}
+
+void TextureCache::Init( VulkanGraphicsInstance* pInstance )
+{
+	pGraphicsInstance = pInstance;
+}
+
+void TextureCache::Cleanup()
+{
+	assert( entries.empty() && "textures still referenced at cleanup!" );
+
+	for ( auto& entry : entries )
+	{
+		entry.first->CleanupTexture();
+		delete entry.first;
+	}
+
+	entries.clear();
+	texturesByPath.clear();
+	texturesByContent.clear();
+}
+
+VulkanTexture* TextureCache::Acquire( const char* filename )
+{
+	std::vector<VulkanTexture*> textures;
+	Acquire( { filename }, textures );
+
+	return textures[0];
+}
+
+void TextureCache::Acquire( const std::vector<const char*>& filenames, std::vector<VulkanTexture*>& textures )
+{
+	textures.resize( filenames.size() );
+
+	std::vector<VulkanTexture*> newTextures;
+	std::vector<const char*> newFilenames;
+
+	for ( size_t i = 0; i < filenames.size(); ++i )
+	{
+		bool bCreated;
+		textures[i] = FindOrReserve( filenames[i], bCreated );
+
+		if ( bCreated )
+		{
+			newTextures.push_back( textures[i] );
+			newFilenames.push_back( filenames[i] );
+		}
+	}
+
+	if ( !newTextures.empty() )
+	{
+		VulkanTexture::CreateTextures( pGraphicsInstance, newTextures, newFilenames );
+	}
+}
+
+VulkanTexture* TextureCache::FindOrReserve( const char* filename, bool& bCreated )
+{
+	bCreated = false;
+
+	std::string path = GetNormalizedPath( filename );
+
+	auto foundPath = texturesByPath.find( path );
+	if ( foundPath != texturesByPath.end() )
+	{
+		++entries[foundPath->second].refCount;
+		++pathHits;
+		return foundPath->second;
+	}
+
+	// New name: hash the file so a duplicate under another name still shares the texture
+	uint64_t contentHash = 0;
+	bool bHasContentHash = FileUtils::HashFileContents( path, contentHash );
+
+	if ( bHasContentHash )
+	{
+		auto foundContent = texturesByContent.find( contentHash );
+		if ( foundContent != texturesByContent.end() )
+		{
+			TextureEntry& entry = entries[foundContent->second];
+			++entry.refCount;
+			entry.paths.push_back( path );
+
+			texturesByPath.emplace( path, foundContent->second );
+			++contentHits;
+			return foundContent->second;
+		}
+	}
+
+	// Reserved before it is created, so repeats later in the same batch hit the cache
+	VulkanTexture* pTexture = new VulkanTexture();
+
+	entries.emplace( pTexture, TextureEntry{ 1, bHasContentHash, contentHash, { path } } );
+	texturesByPath.emplace( path, pTexture );
+
+	if ( bHasContentHash )
+	{
+		texturesByContent.emplace( contentHash, pTexture );
+	}
+
+	bCreated = true;
+	return pTexture;
+}
+
+void TextureCache::Release( VulkanTexture* pTexture )
+{
+	auto entry = entries.find( pTexture );
+	assert( entry != entries.end() && "releasing a texture the cache does not own!" );
+
+	if ( --entry->second.refCount > 0 )
+	{
+		return;
+	}
+
+	for ( const std::string& path : entry->second.paths )
+	{
+		texturesByPath.erase( path );
+	}
+
+	if ( entry->second.bHasContentHash )
+	{
+		texturesByContent.erase( entry->second.contentHash );
+	}
+
+	entries.erase( entry );
+
+	pTexture->CleanupTexture();
+	delete pTexture;
+}
+
+VulkanTexture* TextureCache::Create( const TextureData& textureData )
+{
+	VulkanTexture* pTexture = new VulkanTexture();
+	pTexture->CreateTextureFromData( pGraphicsInstance, textureData );
+
+	entries.emplace( pTexture, TextureEntry{ 1, false, 0, {} } );
+
+	return pTexture;
+}
+
+void TextureCache::AddReference( VulkanTexture* pTexture )
+{
+	auto entry = entries.find( pTexture );
+	assert( entry != entries.end() && "referencing a texture the cache does not own!" );
+
+	++entry->second.refCount;
+}
+
+TextureCache::Statistics TextureCache::GetStatistics() const
+{
+	Statistics stats;
+	stats.textureCount = static_cast< uint32_t >( entries.size() );
+	stats.pathHits = pathHits;
+	stats.contentHits = contentHits;
+
+	for ( const auto& entry : entries )
+	{
+		stats.referenceCount += entry.second.refCount;
+	}
+
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VulkanGraphicsInstance;
+class VulkanTexture;
+struct TextureData;
+
+// Shares VulkanTextures between every model that uses the same image. Textures are reference
+// counted; the last Release frees the image. Lookups go by normalised path first, then by a
+// hash of the file contents, so the same image under two names (copied props, "./a.jpg" vs
+// "a.jpg") is still loaded once.
+class TextureCache
+{
+public:
+	struct Statistics
+	{
+		uint32_t textureCount = 0;		// live textures
+		uint32_t referenceCount = 0;	// outstanding Acquires
+		uint32_t pathHits = 0;			// lifetime totals
+		uint32_t contentHits = 0;
+	};
+
+	void Init( VulkanGraphicsInstance* pInstance );
+	void Cleanup();
+
+	// filename is relative to TEXTURE_PATH, as for VulkanTexture::CreateTexture
+	VulkanTexture* Acquire( const char* filename );
+	// Textures not already cached are created together, so their decodes share one batch
+	void Acquire( const std::vector<const char*>& filenames, std::vector<VulkanTexture*>& textures );
+	void Release( VulkanTexture* pTexture );
+
+	// Textures with no file behind them (atlas pages); not found by Acquire, shared with AddReference
+	VulkanTexture* Create( const TextureData& textureData );
+	void AddReference( VulkanTexture* pTexture );
+
+	Statistics GetStatistics() const;
+
+private:
+	struct TextureEntry
+	{
+		uint32_t refCount;
+		bool bHasContentHash;
+		uint64_t contentHash;
+		std::vector<std::string> paths;	// every normalised path that resolved to this texture
+	};
+
+	VulkanTexture* FindOrReserve( const char* filename, bool& bCreated );
+
+	VulkanGraphicsInstance* pGraphicsInstance = nullptr;
+
+	std::unordered_map<VulkanTexture*, TextureEntry> entries;
+	std::unordered_map<std::string, VulkanTexture*> texturesByPath;
+	std::unordered_map<uint64_t, VulkanTexture*> texturesByContent;
+
+	uint32_t pathHits = 0;
+	uint32_t contentHits = 0;
+};
\ No newline at end of file
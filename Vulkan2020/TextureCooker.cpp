@@ -0,0 +1,243 @@
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <stb_image.h>
+
+#include "BlockCompressor.h"
+#include "FileUtils.h"
+#include "MipGenerator.h"
+#include "TextureDecodePool.h"
+
+namespace
+{
+	bool HasTranslucency( const uint8_t* pixels, uint32_t width, uint32_t height )
+	{
+		size_t texelCount = static_cast< size_t >( width ) * height;
+
+		for ( size_t i = 0; i < texelCount; ++i )
+		{
+			if ( pixels[i * 4 + 3] != 255 )
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void PrintUsage()
+	{
+		std::cerr << "usage: Vulkan2020 -cook <source image> <output.vtex> [-bc1|-bc3|-bc] [-linear]" << std::endl;
+	}
+}
+
+bool TextureCooker::CookTexture( const std::string& sourcePath, const std::string& outputPath, const CookOptions& options )
+{
+	int texWidth;
+	int texHeight;
+	int texChannels;
+
+	stbi_uc* pixels = stbi_load( sourcePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha );
+	if ( !pixels )
+	{
+		std::cerr << "failed to load " << sourcePath << ": " << stbi_failure_reason() << std::endl;
+		return false;
+	}
+
+	uint32_t width = static_cast< uint32_t >( texWidth );
+	uint32_t height = static_cast< uint32_t >( texHeight );
+
+	TextureData mipChain;
+	MipGenerator::GenerateMipChain( pixels, width, height, options.bSRGB, mipChain, true, options.threadCount );
+
+	Compression compression = options.compression;
+	if ( compression == Compression::Auto )
+	{
+		compression = HasTranslucency( pixels, width, height ) ? Compression::BC3 : Compression::BC1;
+	}
+
+	stbi_image_free( pixels );
+
+	bool bWritten = false;
+
+	if ( compression == Compression::None )
+	{
+		bWritten = FileUtils::WriteCookedTexture( outputPath, mipChain );
+	}
+	else
+	{
+		VkFormat targetFormat;
+		if ( compression == Compression::BC1 )
+		{
+			targetFormat = options.bSRGB ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		}
+		else
+		{
+			targetFormat = options.bSRGB ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+		}
+
+		TextureData compressed;
+		bWritten = BlockCompressor::CompressTexture( mipChain, targetFormat, compressed ) && FileUtils::WriteCookedTexture( outputPath, compressed );
+	}
+
+	if ( !bWritten )
+	{
+		std::cerr << "failed to write " << outputPath << std::endl;
+	}
+
+	return bWritten;
+}
+
+int TextureCooker::RunCommandLine( int argc, char** argv )
+{
+	if ( argc < 2 )
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	CookOptions options;
+
+	for ( int i = 2; i < argc; ++i )
+	{
+		if ( strcmp( argv[i], "-bc1" ) == 0 )
+		{
+			options.compression = Compression::BC1;
+		}
+		else if ( strcmp( argv[i], "-bc3" ) == 0 )
+		{
+			options.compression = Compression::BC3;
+		}
+		else if ( strcmp( argv[i], "-bc" ) == 0 )
+		{
+			options.compression = Compression::Auto;
+		}
+		else if ( strcmp( argv[i], "-linear" ) == 0 )
+		{
+			options.bSRGB = false;
+		}
+		else
+		{
+			PrintUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	if ( !CookTexture( argv[0], argv[1], options ) )
+	{
+		return EXIT_FAILURE;
+	}
+
+	float seconds = std::chrono::duration<float, std::chrono::seconds::period>( std::chrono::high_resolution_clock::now() - startTime ).count();
+	std::cout << "cooked " << argv[0] << " -> " << argv[1] << " in " << seconds << "s" << std::endl;
+
+	return EXIT_SUCCESS;
+}
+
+int TextureCooker::RunMipBenchmark( int argc, char** argv )
+{
+	if ( argc < 1 )
+	{
+		std::cerr << "usage: Vulkan2020 -benchmips <source image> [iterations]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	int iterations = argc > 1 ? std::max( atoi( argv[1] ), 1 ) : 10;
+
+	int texWidth;
+	int texHeight;
+	int texChannels;
+
+	stbi_uc* pixels = stbi_load( argv[0], &texWidth, &texHeight, &texChannels, STBI_rgb_alpha );
+	if ( !pixels )
+	{
+		std::cerr << "failed to load " << argv[0] << ": " << stbi_failure_reason() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	struct BenchmarkCase
+	{
+		const char* name;
+		bool bUseSIMD;
+		uint32_t threadCount;
+	};
+
+	const BenchmarkCase cases[] =
+	{
+		{ "scalar, 1 thread", false, 1 },
+		{ "SIMD, 1 thread", true, 1 },
+		{ "SIMD, all threads", true, 0 },
+	};
+
+	std::cout << argv[0] << " " << texWidth << "x" << texHeight << ", " << iterations << " iterations, " << MipGenerator::GetSIMDPathName() << " build" << std::endl;
+
+	for ( bool bSRGB : { true, false } )
+	{
+		for ( const BenchmarkCase& benchmarkCase : cases )
+		{
+			TextureData mipChain;
+			auto startTime = std::chrono::high_resolution_clock::now();
+
+			for ( int i = 0; i < iterations; ++i )
+			{
+				MipGenerator::GenerateMipChain( pixels, static_cast< uint32_t >( texWidth ), static_cast< uint32_t >( texHeight ), bSRGB, mipChain, benchmarkCase.bUseSIMD, benchmarkCase.threadCount );
+			}
+
+			double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - startTime ).count() / iterations;
+
+			std::cout << ( bSRGB ? "sRGB   " : "linear " ) << benchmarkCase.name << ": " << milliseconds << " ms" << std::endl;
+		}
+	}
+
+	stbi_image_free( pixels );
+
+	return EXIT_SUCCESS;
+}
+
+int TextureCooker::RunDecodeBenchmark( int argc, char** argv )
+{
+	if ( argc < 1 )
+	{
+		std::cerr << "usage: Vulkan2020 -benchdecode <source image>..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// 1 thread is the old serial load; 0 lets the pool use every core
+	for ( uint32_t threadCount : { 1u, 0u } )
+	{
+		TextureDecodePool decodePool;
+		decodePool.Init( threadCount );
+
+		std::vector<TextureDecodePool::Request> requests( argc );
+		for ( int i = 0; i < argc; ++i )
+		{
+			requests[i].path = argv[i];
+		}
+
+		std::vector<uint8_t> pixels( static_cast< size_t >( decodePool.PrepareBatch( requests ) ) );
+		decodePool.DecodeBatch( requests, pixels.data() );
+
+		for ( const TextureDecodePool::Request& request : requests )
+		{
+			if ( !request.bSuccess )
+			{
+				std::cerr << "failed to load " << request.path << std::endl;
+			}
+		}
+
+		const TextureDecodePool::Statistics& stats = decodePool.GetStatistics();
+		std::cout << decodePool.GetThreadCount() << " thread(s): " << stats.textures << " textures in " << stats.seconds * 1000.0 << " ms, "
+			<< stats.GetMegabytesPerSecond() << " MB/s, " << stats.GetTexturesPerSecond() << " textures/s" << std::endl;
+
+		decodePool.Cleanup();
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
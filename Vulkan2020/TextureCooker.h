@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Offline texture cooking: decode a source image once, build the mip chain on the CPU,
+// optionally block compress it and write a .vtex container that VulkanTexture uploads directly.
+// Run through the main executable: Vulkan2020 -cook <source> <output.vtex> [-bc1|-bc3|-bc] [-linear]
+// Vulkan2020 -benchmips <source> [iterations] times the CPU mip paths on one image.
+// Vulkan2020 -benchdecode <source>... decodes a set of images serially and on the decode pool.
+namespace TextureCooker
+{
+	enum class Compression
+	{
+		None,
+		BC1,
+		BC3,
+		Auto,	// BC3 if any texel has alpha below 255, otherwise BC1
+	};
+
+	struct CookOptions
+	{
+		Compression compression = Compression::None;
+		bool bSRGB = true;	// colour data; pass -linear for normal maps and other non colour data
+		uint32_t threadCount = 0;	// for the mip chain; 0 uses every hardware thread
+	};
+
+	bool CookTexture( const std::string& sourcePath, const std::string& outputPath, const CookOptions& options );
+
+	// argv excludes the program name and the -cook switch; returns the process exit code
+	int RunCommandLine( int argc, char** argv );
+
+	// Scalar vs SIMD vs SIMD on all threads; the blit path is timed in app by MipGenerationStats
+	int RunMipBenchmark( int argc, char** argv );
+
+	// Serial vs pooled decoding of the given images, reported in MB/s of decoded texels and textures/s
+	int RunDecodeBenchmark( int argc, char** argv );
+}
\ No newline at end of file
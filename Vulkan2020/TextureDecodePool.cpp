@@ -0,0 +1,96 @@
+#include "TextureDecodePool.h"
+
+#include <chrono>
+
+#include "FileUtils.h"
+
+void TextureDecodePool::Init( uint32_t threadCount )
+{
+	Jobs.Init( threadCount );
+}
+
+void TextureDecodePool::Cleanup()
+{
+	Jobs.Cleanup();
+	Files.clear();
+}
+
+uint64_t TextureDecodePool::PrepareBatch( std::vector<Request>& requests )
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	Files.clear();
+	Files.resize( requests.size() );
+
+	Jobs.ParallelFor( static_cast< uint32_t >( requests.size() ), [&]( uint32_t i )
+	{
+		Request& request = requests[i];
+		request.bSuccess = VirtualFileSystem::Open( request.path, Files[i] ) && FileUtils::ReadTextureInfo( Files[i].GetData(), Files[i].GetSize(), request.width, request.height );
+	} );
+
+	Stats.seconds += std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - startTime ).count();
+
+	return LayoutBatch( requests );
+}
+
+uint64_t TextureDecodePool::LayoutBatch( std::vector<Request>& requests )
+{
+	uint64_t totalSize = 0;
+
+	for ( size_t i = 0; i < requests.size(); ++i )
+	{
+		Request& request = requests[i];
+
+		if ( !request.bSuccess )
+		{
+			request.size = 0;
+			Files[i].Close();
+			continue;
+		}
+
+		totalSize = ( totalSize + IMAGE_ALIGNMENT - 1 ) & ~( IMAGE_ALIGNMENT - 1 );
+
+		request.offset = totalSize;
+		request.size = static_cast< uint64_t >( request.width ) * request.height * 4;
+		totalSize += request.size;
+	}
+
+	return totalSize;
+}
+
+void TextureDecodePool::DecodeBatch( std::vector<Request>& requests, uint8_t* destination )
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	for ( size_t i = 0; i < requests.size(); ++i )
+	{
+		if ( requests[i].bSuccess )
+		{
+			Stats.encodedBytes += Files[i].GetSize();
+		}
+	}
+
+	Jobs.ParallelFor( static_cast< uint32_t >( requests.size() ), [&]( uint32_t i )
+	{
+		Request& request = requests[i];
+
+		if ( request.bSuccess )
+		{
+			request.bSuccess = FileUtils::DecodeTextureInto( Files[i].GetData(), Files[i].GetSize(), destination + request.offset, static_cast< size_t >( request.size ) );
+		}
+
+		// Encoded data is only needed once
+		Files[i].Close();
+	} );
+
+	for ( const Request& request : requests )
+	{
+		if ( request.bSuccess )
+		{
+			++Stats.textures;
+			Stats.decodedBytes += request.size;
+		}
+	}
+
+	Stats.seconds += std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - startTime ).count();
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JobPool.h"
+#include "VirtualFileSystem.h"
+
+// Decodes batches of stb_image textures (JPEG, PNG, ...) on a JobPool. A batch is two passes:
+// PrepareBatch maps the files and parses their headers so every image's size and offset is
+// known, then DecodeBatch decodes each one straight into its slice of caller memory, normally
+// one mapped staging buffer for the whole batch.
+class TextureDecodePool
+{
+public:
+	struct Request
+	{
+		std::string path;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint64_t offset = 0;	// into the destination given to DecodeBatch
+		uint64_t size = 0;		// RGBA8, width * height * 4
+		bool bSuccess = false;	// header parsed after PrepareBatch, pixels written after DecodeBatch
+	};
+
+	// Lifetime totals; seconds covers file reads and decoding
+	struct Statistics
+	{
+		uint32_t textures = 0;
+		uint64_t encodedBytes = 0;
+		uint64_t decodedBytes = 0;
+		double seconds = 0.0;
+
+		double GetMegabytesPerSecond() const { return seconds > 0.0 ? decodedBytes / ( 1024.0 * 1024.0 ) / seconds : 0.0; }
+		double GetTexturesPerSecond() const { return seconds > 0.0 ? textures / seconds : 0.0; }
+	};
+
+	void Init( uint32_t threadCount = 0 );
+	void Cleanup();
+
+	// Returns the bytes DecodeBatch will write; failed requests get no space
+	uint64_t PrepareBatch( std::vector<Request>& requests );
+
+	// After PrepareBatch, clear bSuccess on requests that shouldn't be decoded and lay the rest out again
+	uint64_t LayoutBatch( std::vector<Request>& requests );
+
+	// requests must be the vector last passed to PrepareBatch; destination holds its returned size
+	void DecodeBatch( std::vector<Request>& requests, uint8_t* destination );
+
+	const Statistics& GetStatistics() const { return Stats; }
+	uint32_t GetThreadCount() const { return Jobs.GetThreadCount(); }
+
+private:
+	static constexpr uint64_t IMAGE_ALIGNMENT = 16;	// keeps every image's bufferOffset a multiple of the texel size
+
+	JobPool Jobs;
+	std::vector<FileView> Files;	// encoded files of the prepared batch; mapped pages are read by the decoding thread
+	Statistics Stats;
+};
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "TextureFormats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// ASTC block footprints in VkFormat order; each footprint has a UNORM then an SRGB entry
+	const FormatBlockInfo ASTC_BLOCKS[] =
+	{
+		{ 4, 4, 16 }, { 5, 4, 16 }, { 5, 5, 16 }, { 6, 5, 16 }, { 6, 6, 16 }, { 8, 5, 16 }, { 8, 6, 16 },
+		{ 8, 8, 16 }, { 10, 5, 16 }, { 10, 6, 16 }, { 10, 8, 16 }, { 10, 10, 16 }, { 12, 10, 16 }, { 12, 12, 16 },
+	};
+
+	const uint32_t GL_RGBA8 = 0x8058;
+	const uint32_t GL_SRGB8_ALPHA8 = 0x8C43;
+	const uint32_t GL_COMPRESSED_RGBA_ASTC_4x4_KHR = 0x93B0;
+	const uint32_t GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR = 0x93D0;
+	const uint32_t ASTC_FOOTPRINT_COUNT = sizeof( ASTC_BLOCKS ) / sizeof( ASTC_BLOCKS[0] );
+}
+
+bool TextureFormats::IsBlockCompressed( VkFormat format )
+{
+	return GetBlockInfo( format ).blockWidth > 1;
+}
+
+FormatBlockInfo TextureFormats::GetBlockInfo( VkFormat format )
+{
+	switch ( format )
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+	case VK_FORMAT_BC4_SNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+		return { 4, 4, 8 };
+
+	case VK_FORMAT_BC2_UNORM_BLOCK:
+	case VK_FORMAT_BC2_SRGB_BLOCK:
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC5_SNORM_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+		return { 4, 4, 16 };
+
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		return { 1, 1, 4 };
+
+	default:
+		break;
+	}
+
+	if ( format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK )
+	{
+		return ASTC_BLOCKS[( format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK ) / 2];
+	}
+
+	return { 0, 0, 0 };
+}
+
+size_t TextureFormats::GetLevelSize( VkFormat format, uint32_t width, uint32_t height )
+{
+	FormatBlockInfo block = GetBlockInfo( format );
+
+	size_t blocksWide = ( width + block.blockWidth - 1 ) / block.blockWidth;
+	size_t blocksHigh = ( height + block.blockHeight - 1 ) / block.blockHeight;
+
+	return blocksWide * blocksHigh * block.bytesPerBlock;
+}
+
+uint32_t TextureFormats::GetMipLevelCount( uint32_t width, uint32_t height )
+{
+	return static_cast< uint32_t >( std::floor( std::log2( std::max( width, height ) ) ) ) + 1;
+}
+
+VkFormat TextureFormats::FromGLInternalFormat( uint32_t glInternalFormat )
+{
+	switch ( glInternalFormat )
+	{
+	case GL_RGBA8:			return VK_FORMAT_R8G8B8A8_UNORM;
+	case GL_SRGB8_ALPHA8:	return VK_FORMAT_R8G8B8A8_SRGB;
+
+	// S3TC / RGTC / BPTC
+	case 0x83F0: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case 0x8C4C: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	case 0x83F1: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	case 0x8C4D: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+	case 0x83F2: return VK_FORMAT_BC2_UNORM_BLOCK;
+	case 0x8C4E: return VK_FORMAT_BC2_SRGB_BLOCK;
+	case 0x83F3: return VK_FORMAT_BC3_UNORM_BLOCK;
+	case 0x8C4F: return VK_FORMAT_BC3_SRGB_BLOCK;
+	case 0x8DBB: return VK_FORMAT_BC4_UNORM_BLOCK;
+	case 0x8DBD: return VK_FORMAT_BC5_UNORM_BLOCK;
+	case 0x8E8C: return VK_FORMAT_BC7_UNORM_BLOCK;
+	case 0x8E8D: return VK_FORMAT_BC7_SRGB_BLOCK;
+
+	// ETC2
+	case 0x9274: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+	case 0x9275: return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
+	case 0x9276: return VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK;
+	case 0x9277: return VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK;
+	case 0x9278: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+	case 0x9279: return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+
+	default:
+		break;
+	}
+
+	// ASTC LDR, footprints are contiguous in both the GL and Vulkan enums
+	if ( glInternalFormat >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && glInternalFormat < GL_COMPRESSED_RGBA_ASTC_4x4_KHR + ASTC_FOOTPRINT_COUNT )
+	{
+		return static_cast< VkFormat >( VK_FORMAT_ASTC_4x4_UNORM_BLOCK + 2 * ( glInternalFormat - GL_COMPRESSED_RGBA_ASTC_4x4_KHR ) );
+	}
+
+	if ( glInternalFormat >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && glInternalFormat < GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR + ASTC_FOOTPRINT_COUNT )
+	{
+		return static_cast< VkFormat >( VK_FORMAT_ASTC_4x4_SRGB_BLOCK + 2 * ( glInternalFormat - GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR ) );
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+// Texel block layout of a format: 1x1 for plain formats, 4x4 for BC/ETC2, up to 12x12 for ASTC.
+struct FormatBlockInfo
+{
+	uint32_t blockWidth;
+	uint32_t blockHeight;
+	uint32_t bytesPerBlock;
+};
+
+struct TextureMipLevel
+{
+	uint32_t width;
+	uint32_t height;
+	size_t offset;	// into TextureData::data
+	size_t size;
+};
+
+// CPU side image ready for upload: every mip level packed back to back in one allocation,
+// so the whole chain can be copied into a staging buffer with a single memcpy.
+struct TextureData
+{
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<TextureMipLevel> mips;
+	std::vector<uint8_t> data;
+};
+
+// Cooked texture container (.vtex) written by the texture cooker. Modelled on KTX2: a fixed
+// header, a level index with base level first, then the level data stored smallest mip first
+// with each level aligned to VTEX_LEVEL_ALIGNMENT. The level data is already in upload layout.
+constexpr uint8_t VTEX_IDENTIFIER[8] = { 0xAB, 'V', 'T', 'E', 'X', 0xBB, '\r', '\n' };
+constexpr uint32_t VTEX_VERSION = 1;
+constexpr uint32_t VTEX_LEVEL_ALIGNMENT = 16;
+
+struct VTexHeader
+{
+	uint8_t identifier[8];
+	uint32_t version;
+	uint32_t vkFormat;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t levelCount;
+	uint32_t levelDataOffset;	// start of the level data, from the beginning of the file
+};
+
+struct VTexLevel
+{
+	uint64_t byteOffset;	// from the beginning of the file
+	uint64_t byteLength;
+};
+
+namespace TextureFormats
+{
+	bool IsBlockCompressed( VkFormat format );
+	FormatBlockInfo GetBlockInfo( VkFormat format );
+	size_t GetLevelSize( VkFormat format, uint32_t width, uint32_t height );
+	uint32_t GetMipLevelCount( uint32_t width, uint32_t height );
+
+	// KTX 1.1 stores an OpenGL internal format; returns VK_FORMAT_UNDEFINED for anything we can't upload
+	VkFormat FromGLInternalFormat( uint32_t glInternalFormat );
+}
\ No newline at end of file
@@ -0,0 +1,630 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "FileUtils.h"
+#include "VulkanGraphicsInstance.h"
+
+namespace
+{
+	VkExtent3D GetLevelExtent( uint32_t width, uint32_t height, uint32_t level )
+	{
+		return { std::max( width >> level, 1u ), std::max( height >> level, 1u ), 1 };
+	}
+}
+
+void TextureStreamer::Init( VulkanGraphicsInstance* pInstance, BindlessTextureTable* pBindlessTable, VkDeviceSize budgetBytes )
+{
+	pGraphicsInstance = pInstance;
+	pBindless = pBindlessTable;
+	budget = budgetBytes;
+
+	bShutdown = false;
+	worker = std::thread( &TextureStreamer::WorkerMain, this );
+}
+
+void TextureStreamer::Cleanup()
+{
+	{
+		std::lock_guard<std::mutex> lock( queueMutex );
+		bShutdown = true;
+		requests.clear();
+	}
+
+	queueCondition.notify_all();
+
+	if ( worker.joinable() )
+	{
+		worker.join();
+	}
+
+	results.clear();
+
+	for ( Handle handle = 0; handle < textures.size(); ++handle )
+	{
+		Unregister( handle );
+	}
+
+	textures.clear();
+	freeHandles.clear();
+	residentBytes = 0;
+	pendingReads = 0;
+}
+
+TextureStreamer::Handle TextureStreamer::Register( const char* filename, VkSampler sampler )
+{
+	std::string path = std::string( TEXTURE_PATH ) + filename;
+
+	VTexHeader header;
+	std::vector<VTexLevel> levels;
+	if ( !FileUtils::ReadCookedTextureIndex( path, header, levels ) || !pGraphicsInstance->IsFormatSampleable( static_cast< VkFormat >( header.vkFormat ) ) )
+	{
+		return INVALID_HANDLE;
+	}
+
+	Handle handle;
+	if ( !freeHandles.empty() )
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = static_cast< Handle >( textures.size() );
+		textures.emplace_back();
+	}
+
+	StreamedTexture& texture = textures[handle];
+	uint32_t serial = texture.serial;
+
+	texture = StreamedTexture();
+	texture.bActive = true;
+	texture.serial = serial;
+	texture.path = path;
+	texture.format = static_cast< VkFormat >( header.vkFormat );
+	texture.width = header.pixelWidth;
+	texture.height = header.pixelHeight;
+	texture.levels = std::move( levels );
+	texture.sampler = sampler;
+	texture.lastUsedFrame = frameCounter;
+
+	const uint32_t levelCount = static_cast< uint32_t >( texture.levels.size() );
+
+	while ( texture.tailLevel + 1 < levelCount && std::max( texture.width >> texture.tailLevel, texture.height >> texture.tailLevel ) > TAIL_SIZE )
+	{
+		++texture.tailLevel;
+	}
+
+	// Nothing resident yet, the first rebuild uploads the whole tail
+	texture.residentLevel = levelCount;
+	texture.requestedLevel = levelCount;
+	texture.wantedLevel = texture.tailLevel;
+	texture.targetLevel = texture.tailLevel;
+
+	const VTexLevel& smallest = texture.levels[levelCount - 1];
+	const VTexLevel& tailTop = texture.levels[texture.tailLevel];
+
+	std::vector<Rebuild> rebuilds( 1 );
+	rebuilds[0].handle = handle;
+	rebuilds[0].newLevel = texture.tailLevel;
+
+	if ( !FileUtils::ReadFileRange( path, smallest.byteOffset, tailTop.byteOffset + tailTop.byteLength - smallest.byteOffset, rebuilds[0].data ) )
+	{
+		texture.bActive = false;
+		++texture.serial;
+		freeHandles.push_back( handle );
+
+		return INVALID_HANDLE;
+	}
+
+	// The tail is never evicted, so it is uploaded even if it takes us over budget
+	ApplyRebuilds( rebuilds );
+
+	textures[handle].bindlessSlot = pBindless->RegisterTexture( textures[handle].view, sampler );
+
+	return handle;
+}
+
+void TextureStreamer::Unregister( Handle handle )
+{
+	StreamedTexture& texture = textures[handle];
+	if ( !texture.bActive )
+	{
+		return;
+	}
+
+	if ( texture.bindlessSlot != BindlessTextureTable::INVALID_SLOT )
+	{
+		pBindless->UnregisterTexture( texture.bindlessSlot );
+	}
+
+	DestroyImage( texture );
+	residentBytes -= texture.residentBytes;
+
+	// An outstanding read finds a different serial and is dropped in Update
+	uint32_t serial = texture.serial + 1;
+	texture = StreamedTexture();
+	texture.serial = serial;
+
+	freeHandles.push_back( handle );
+}
+
+void TextureStreamer::RequestScreenSize( Handle handle, float screenSize )
+{
+	StreamedTexture& texture = textures[handle];
+
+	// One texel per pixel across the texture's larger side; UV tiling and density are not considered
+	float texels = static_cast< float >( std::max( texture.width, texture.height ) );
+	uint32_t level = 0;
+
+	if ( screenSize < texels )
+	{
+		level = static_cast< uint32_t >( std::floor( std::log2( texels / std::max( screenSize, 1.0f ) ) ) );
+	}
+
+	texture.wantedLevel = std::min( texture.wantedLevel, std::min( level, texture.tailLevel ) );
+	texture.lastUsedFrame = frameCounter;
+}
+
+void TextureStreamer::Update()
+{
+	++frameCounter;
+
+	for ( StreamedTexture& texture : textures )
+	{
+		if ( texture.bActive )
+		{
+			texture.targetLevel = texture.wantedLevel;
+			texture.wantedLevel = texture.tailLevel;
+		}
+	}
+
+	std::vector<ReadResult> finished;
+	{
+		std::lock_guard<std::mutex> lock( queueMutex );
+		finished.swap( results );
+	}
+
+	std::vector<Rebuild> rebuilds;
+	VkDeviceSize projectedBytes = residentBytes;
+
+	for ( ReadResult& result : finished )
+	{
+		--pendingReads;
+
+		const ReadRequest& request = result.request;
+		StreamedTexture& texture = textures[request.handle];
+
+		if ( !texture.bActive || texture.serial != request.serial )
+		{
+			continue;
+		}
+
+		texture.requestedLevel = texture.residentLevel;
+
+		// Failed, or evicted while the read was in flight; it is requested again next frame if still wanted
+		if ( !result.bSuccess || texture.bRebuildQueued || texture.residentLevel != request.endLevel )
+		{
+			continue;
+		}
+
+		VkDeviceSize extraBytes = GetLevelRangeSize( texture, request.firstLevel, request.endLevel );
+		if ( !MakeRoom( extraBytes, request.handle, projectedBytes, rebuilds ) )
+		{
+			continue;
+		}
+
+		projectedBytes += extraBytes;
+		texture.bRebuildQueued = true;
+
+		Rebuild rebuild;
+		rebuild.handle = request.handle;
+		rebuild.newLevel = request.firstLevel;
+		rebuild.data = std::move( result.data );
+		rebuilds.push_back( std::move( rebuild ) );
+	}
+
+	ApplyRebuilds( rebuilds );
+
+	// Only ask for levels that could fit once everything not drawn last frame is back to its tail,
+	// otherwise the read would just be thrown away on arrival
+	VkDeviceSize evictableBytes = 0;
+	std::vector<Handle> candidates;
+
+	for ( Handle handle = 0; handle < textures.size(); ++handle )
+	{
+		const StreamedTexture& texture = textures[handle];
+		if ( !texture.bActive )
+		{
+			continue;
+		}
+
+		if ( texture.lastUsedFrame + 1 < frameCounter )
+		{
+			evictableBytes += GetLevelRangeSize( texture, texture.residentLevel, texture.tailLevel );
+		}
+		else if ( texture.targetLevel < texture.residentLevel && texture.requestedLevel == texture.residentLevel )
+		{
+			candidates.push_back( handle );
+		}
+	}
+
+	// Blurriest first
+	std::sort( candidates.begin(), candidates.end(), [this]( Handle a, Handle b )
+	{
+		return textures[a].residentLevel - textures[a].targetLevel > textures[b].residentLevel - textures[b].targetLevel;
+	} );
+
+	for ( Handle handle : candidates )
+	{
+		if ( pendingReads >= MAX_PENDING_READS )
+		{
+			break;
+		}
+
+		StreamedTexture& texture = textures[handle];
+
+		if ( residentBytes + GetLevelRangeSize( texture, texture.targetLevel, texture.residentLevel ) > budget + evictableBytes )
+		{
+			continue;
+		}
+
+		const VTexLevel& smallest = texture.levels[texture.residentLevel - 1];
+		const VTexLevel& largest = texture.levels[texture.targetLevel];
+
+		ReadRequest request;
+		request.handle = handle;
+		request.serial = texture.serial;
+		request.firstLevel = texture.targetLevel;
+		request.endLevel = texture.residentLevel;
+		request.path = texture.path;
+		request.offset = smallest.byteOffset;
+		request.size = largest.byteOffset + largest.byteLength - smallest.byteOffset;
+
+		texture.requestedLevel = texture.targetLevel;
+		++pendingReads;
+
+		{
+			std::lock_guard<std::mutex> lock( queueMutex );
+			requests.push_back( std::move( request ) );
+		}
+
+		queueCondition.notify_one();
+	}
+}
+
+uint32_t TextureStreamer::GetBindlessSlot( Handle handle ) const
+{
+	return textures[handle].bindlessSlot;
+}
+
+TextureStreamer::Statistics TextureStreamer::GetStatistics() const
+{
+	Statistics stats;
+	stats.residentBytes = residentBytes;
+	stats.budgetBytes = budget;
+	stats.textureCount = static_cast< uint32_t >( textures.size() - freeHandles.size() );
+	stats.pendingReads = pendingReads;
+	stats.levelsStreamedIn = levelsStreamedIn;
+	stats.levelsEvicted = levelsEvicted;
+
+	return stats;
+}
+
+void TextureStreamer::WorkerMain()
+{
+	for ( ;; )
+	{
+		ReadResult result;
+		{
+			std::unique_lock<std::mutex> lock( queueMutex );
+			queueCondition.wait( lock, [this]() { return bShutdown || !requests.empty(); } );
+
+			if ( bShutdown )
+			{
+				return;
+			}
+
+			result.request = std::move( requests.front() );
+			requests.pop_front();
+		}
+
+		result.bSuccess = FileUtils::ReadFileRange( result.request.path, result.request.offset, result.request.size, result.data );
+
+		std::lock_guard<std::mutex> lock( queueMutex );
+		results.push_back( std::move( result ) );
+	}
+}
+
+VkDeviceSize TextureStreamer::GetLevelRangeSize( const StreamedTexture& texture, uint32_t firstLevel, uint32_t endLevel ) const
+{
+	VkDeviceSize size = 0;
+
+	for ( uint32_t level = firstLevel; level < endLevel; ++level )
+	{
+		size += texture.levels[level].byteLength;
+	}
+
+	return size;
+}
+
+bool TextureStreamer::MakeRoom( VkDeviceSize bytes, Handle requester, VkDeviceSize& projectedBytes, std::vector<Rebuild>& rebuilds )
+{
+	if ( projectedBytes + bytes <= budget )
+	{
+		return true;
+	}
+
+	// Anything drawn last frame is off limits, so visible textures can't evict each other back and forth
+	std::vector<Handle> victims;
+
+	for ( Handle handle = 0; handle < textures.size(); ++handle )
+	{
+		const StreamedTexture& texture = textures[handle];
+
+		if ( texture.bActive && handle != requester && !texture.bRebuildQueued && texture.residentLevel < texture.tailLevel && texture.lastUsedFrame + 1 < frameCounter )
+		{
+			victims.push_back( handle );
+		}
+	}
+
+	std::sort( victims.begin(), victims.end(), [this]( Handle a, Handle b ) { return textures[a].lastUsedFrame < textures[b].lastUsedFrame; } );
+
+	for ( Handle handle : victims )
+	{
+		StreamedTexture& texture = textures[handle];
+
+		projectedBytes -= GetLevelRangeSize( texture, texture.residentLevel, texture.tailLevel );
+		texture.bRebuildQueued = true;
+
+		Rebuild rebuild;
+		rebuild.handle = handle;
+		rebuild.newLevel = texture.tailLevel;
+		rebuilds.push_back( std::move( rebuild ) );
+
+		if ( projectedBytes + bytes <= budget )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TextureStreamer::ApplyRebuilds( std::vector<Rebuild>& rebuilds )
+{
+	if ( rebuilds.empty() )
+	{
+		return;
+	}
+
+	VkDevice device = *pGraphicsInstance->GetDevice();
+
+	// One staging buffer for the whole batch; 16 byte alignment satisfies every block size we upload
+	std::vector<VkDeviceSize> stagingOffsets( rebuilds.size() );
+	VkDeviceSize stagingSize = 0;
+
+	for ( size_t i = 0; i < rebuilds.size(); ++i )
+	{
+		stagingOffsets[i] = stagingSize;
+		stagingSize = ( stagingSize + rebuilds[i].data.size() + 15 ) & ~VkDeviceSize( 15 );
+	}
+
+	VkBuffer stagingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+
+	if ( stagingSize > 0 )
+	{
+		pGraphicsInstance->CreateBuffer( stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory );
+
+		void* data;
+		vkMapMemory( device, stagingBufferMemory, 0, stagingSize, 0, &data );
+
+		for ( size_t i = 0; i < rebuilds.size(); ++i )
+		{
+			memcpy( static_cast< uint8_t* >( data ) + stagingOffsets[i], rebuilds[i].data.data(), rebuilds[i].data.size() );
+		}
+
+		vkUnmapMemory( device, stagingBufferMemory );
+	}
+
+	struct RetiredImage
+	{
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView view;
+	};
+
+	std::vector<RetiredImage> retired;
+
+	VkCommandBuffer commandBuffer = pGraphicsInstance->BeginSingleTimeCommands();
+
+	for ( size_t i = 0; i < rebuilds.size(); ++i )
+	{
+		const Rebuild& rebuild = rebuilds[i];
+		StreamedTexture& texture = textures[rebuild.handle];
+
+		const uint32_t levelCount = static_cast< uint32_t >( texture.levels.size() );
+		const uint32_t oldLevel = texture.residentLevel;
+		const uint32_t newLevel = rebuild.newLevel;
+
+		VkImage image;
+		VkDeviceMemory memory;
+		VkExtent3D extent = GetLevelExtent( texture.width, texture.height, newLevel );
+
+		pGraphicsInstance->CreateImage( extent.width, extent.height, levelCount - newLevel, VK_SAMPLE_COUNT_1_BIT, texture.format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory );
+
+		std::array<VkImageMemoryBarrier, 2> barriers = {};
+
+		for ( VkImageMemoryBarrier& barrier : barriers )
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+		}
+
+		barriers[0].image = image;
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[0].srcAccessMask = 0;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[0].subresourceRange.levelCount = levelCount - newLevel;
+
+		barriers[1].image = texture.image;
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[1].subresourceRange.levelCount = levelCount - oldLevel;
+
+		uint32_t barrierCount = texture.image != VK_NULL_HANDLE ? 2 : 1;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			barrierCount, barriers.data()
+		);
+
+		// Newly read levels come from staging; the read starts at the smallest of them
+		if ( !rebuild.data.empty() )
+		{
+			const VkDeviceSize dataStart = texture.levels[oldLevel - 1].byteOffset;
+			std::vector<VkBufferImageCopy> regions;
+
+			for ( uint32_t level = newLevel; level < oldLevel; ++level )
+			{
+				VkBufferImageCopy region = {};
+				region.bufferOffset = stagingOffsets[i] + ( texture.levels[level].byteOffset - dataStart );
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = level - newLevel;
+				region.imageSubresource.baseArrayLayer = 0;
+				region.imageSubresource.layerCount = 1;
+				region.imageOffset = { 0, 0, 0 };
+				region.imageExtent = GetLevelExtent( texture.width, texture.height, level );
+
+				regions.push_back( region );
+			}
+
+			vkCmdCopyBufferToImage( commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast< uint32_t >( regions.size() ), regions.data() );
+		}
+
+		// Levels both images hold are copied on the GPU rather than read again
+		if ( texture.image != VK_NULL_HANDLE )
+		{
+			std::vector<VkImageCopy> copies;
+
+			for ( uint32_t level = std::max( newLevel, oldLevel ); level < levelCount; ++level )
+			{
+				VkImageCopy copy = {};
+				copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - oldLevel, 0, 1 };
+				copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newLevel, 0, 1 };
+				copy.extent = GetLevelExtent( texture.width, texture.height, level );
+
+				copies.push_back( copy );
+			}
+
+			vkCmdCopyImage( commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast< uint32_t >( copies.size() ), copies.data() );
+
+			retired.push_back( { texture.image, texture.memory, texture.view } );
+		}
+
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barriers[0]
+		);
+
+		if ( texture.image != VK_NULL_HANDLE )
+		{
+			if ( newLevel < oldLevel )
+			{
+				levelsStreamedIn += oldLevel - newLevel;
+			}
+			else
+			{
+				levelsEvicted += newLevel - oldLevel;
+			}
+		}
+
+		VkDeviceSize bytes = GetLevelRangeSize( texture, newLevel, levelCount );
+		residentBytes = residentBytes - texture.residentBytes + bytes;
+
+		texture.residentBytes = bytes;
+		texture.image = image;
+		texture.memory = memory;
+		texture.view = VK_NULL_HANDLE;
+		texture.bRebuildQueued = false;
+
+		// A read still in flight for the old residency is dropped when it lands
+		if ( texture.requestedLevel == oldLevel )
+		{
+			texture.requestedLevel = newLevel;
+		}
+
+		texture.residentLevel = newLevel;
+	}
+
+	// Drains the graphics queue, so no frame still references the old images once this returns
+	pGraphicsInstance->EndSingleTimeCommands( commandBuffer );
+
+	for ( const Rebuild& rebuild : rebuilds )
+	{
+		StreamedTexture& texture = textures[rebuild.handle];
+		texture.view = pGraphicsInstance->CreateImageView( texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, static_cast< uint32_t >( texture.levels.size() ) - texture.residentLevel );
+
+		if ( texture.bindlessSlot != BindlessTextureTable::INVALID_SLOT )
+		{
+			pBindless->UpdateTexture( texture.bindlessSlot, texture.view, texture.sampler );
+		}
+	}
+
+	for ( const RetiredImage& old : retired )
+	{
+		vkDestroyImageView( device, old.view, nullptr );
+		vkDestroyImage( device, old.image, nullptr );
+		vkFreeMemory( device, old.memory, nullptr );
+	}
+
+	if ( stagingBuffer != VK_NULL_HANDLE )
+	{
+		vkDestroyBuffer( device, stagingBuffer, nullptr );
+		vkFreeMemory( device, stagingBufferMemory, nullptr );
+	}
+}
+
+void TextureStreamer::DestroyImage( StreamedTexture& texture )
+{
+	VkDevice device = *pGraphicsInstance->GetDevice();
+
+	if ( texture.view != VK_NULL_HANDLE )
+	{
+		vkDestroyImageView( device, texture.view, nullptr );
+	}
+
+	if ( texture.image != VK_NULL_HANDLE )
+	{
+		vkDestroyImage( device, texture.image, nullptr );
+		vkFreeMemory( device, texture.memory, nullptr );
+	}
+
+	texture.view = VK_NULL_HANDLE;
+	texture.image = VK_NULL_HANDLE;
+	texture.memory = VK_NULL_HANDLE;
+}
\ No newline at end of file
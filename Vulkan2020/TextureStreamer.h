@@ -0,0 +1,142 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "BindlessTextureTable.h"
+#include "TextureFormats.h"
+
+class VulkanGraphicsInstance;
+
+// Streams the mip levels of cooked (.vtex) textures under a VRAM budget. A texture registers
+// with only its small tail mips resident; RequestScreenSize raises the wanted level from its
+// on-screen size, a worker thread reads the missing levels (one contiguous read, since .vtex
+// stores the smallest mips first) and Update swaps in a rebuilt image. When a new level
+// doesn't fit, the least recently used textures are dropped back towards their tail.
+//
+// Images are rebuilt rather than partially bound, so the view changes; it is republished
+// through the bindless table, which makes bindless textures a requirement.
+class TextureStreamer
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+	struct Statistics
+	{
+		VkDeviceSize residentBytes = 0;
+		VkDeviceSize budgetBytes = 0;
+		uint32_t textureCount = 0;
+		uint32_t pendingReads = 0;
+		uint32_t levelsStreamedIn = 0;	// lifetime totals
+		uint32_t levelsEvicted = 0;
+	};
+
+	void Init( VulkanGraphicsInstance* pInstance, BindlessTextureTable* pBindlessTable, VkDeviceSize budgetBytes );
+	void Cleanup();
+
+	// Returns INVALID_HANDLE if the file is missing or its format can't be sampled; the tail mips are resident on return
+	Handle Register( const char* filename, VkSampler sampler );
+	void Unregister( Handle handle );
+
+	// Call while recording for every draw using the texture; screenSize is its on-screen extent in pixels
+	void RequestScreenSize( Handle handle, float screenSize );
+
+	// Once per frame, before recording and at a point where the graphics queue may be drained:
+	// applies finished reads, evicts to stay under budget and queues new reads
+	void Update();
+
+	uint32_t GetBindlessSlot( Handle handle ) const;
+	void SetBudget( VkDeviceSize budgetBytes ) { budget = budgetBytes; }
+	Statistics GetStatistics() const;
+
+private:
+	struct StreamedTexture
+	{
+		bool bActive = false;
+		bool bRebuildQueued = false;
+		uint32_t serial = 0;			// bumped on Unregister so late reads for a reused handle are dropped
+
+		std::string path;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<VTexLevel> levels;
+
+		uint32_t tailLevel = 0;			// this level and smaller are always resident
+		uint32_t residentLevel = 0;		// largest level in the image
+		uint32_t wantedLevel = 0;		// smallest requested since the last Update
+		uint32_t targetLevel = 0;		// wantedLevel as of the last Update
+		uint32_t requestedLevel = 0;	// level being read, equal to residentLevel when idle
+		uint64_t lastUsedFrame = 0;
+		VkDeviceSize residentBytes = 0;
+
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+		uint32_t bindlessSlot = BindlessTextureTable::INVALID_SLOT;
+	};
+
+	struct ReadRequest
+	{
+		Handle handle;
+		uint32_t serial;
+		uint32_t firstLevel;
+		uint32_t endLevel;	// residentLevel when issued; the read only applies if it still is
+		std::string path;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct ReadResult
+	{
+		ReadRequest request;
+		bool bSuccess;
+		std::vector<uint8_t> data;
+	};
+
+	// One image rebuild: levels [newLevel, residentLevel) come from data, the rest are copied from the old image
+	struct Rebuild
+	{
+		Handle handle;
+		uint32_t newLevel;
+		std::vector<uint8_t> data;
+	};
+
+	void WorkerMain();
+
+	VkDeviceSize GetLevelRangeSize( const StreamedTexture& texture, uint32_t firstLevel, uint32_t endLevel ) const;
+	bool MakeRoom( VkDeviceSize bytes, Handle requester, VkDeviceSize& projectedBytes, std::vector<Rebuild>& rebuilds );
+	void ApplyRebuilds( std::vector<Rebuild>& rebuilds );
+	void DestroyImage( StreamedTexture& texture );
+
+	static constexpr uint32_t TAIL_SIZE = 64;			// levels at or below this many texels a side are never evicted
+	static constexpr uint32_t MAX_PENDING_READS = 4;
+
+	VulkanGraphicsInstance* pGraphicsInstance = nullptr;
+	BindlessTextureTable* pBindless = nullptr;
+
+	std::vector<StreamedTexture> textures;
+	std::vector<Handle> freeHandles;
+
+	VkDeviceSize budget = 0;
+	VkDeviceSize residentBytes = 0;
+	uint64_t frameCounter = 0;
+	uint32_t pendingReads = 0;
+	uint32_t levelsStreamedIn = 0;
+	uint32_t levelsEvicted = 0;
+
+	std::thread worker;
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::deque<ReadRequest> requests;
+	std::vector<ReadResult> results;
+	bool bShutdown = false;
+};
\ No newline at end of file
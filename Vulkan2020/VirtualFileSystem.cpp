@@ -0,0 +1,197 @@
+#include "VirtualFileSystem.h"
+
+#include <filesystem>
+#include <memory>
+
+#include "AssetArchive.h"
+
+namespace
+{
+	struct MountedArchive
+	{
+		std::string mountPoint;		// normalised, ends in '/'
+		std::unique_ptr<AssetArchive> pArchive;
+	};
+
+	std::vector<MountedArchive> mountedArchives;
+
+	// Archive and entry for path, or nullptr if no mounted archive has it
+	const ArchiveEntry* FindArchived( const std::string& path, const AssetArchive*& pArchive )
+	{
+		if ( mountedArchives.empty() )
+		{
+			return nullptr;
+		}
+
+		std::string normalized = VirtualFileSystem::NormalizePath( path );
+
+		for ( const MountedArchive& mount : mountedArchives )
+		{
+			if ( normalized.compare( 0, mount.mountPoint.size(), mount.mountPoint ) != 0 )
+			{
+				continue;
+			}
+
+			const ArchiveEntry* pEntry = mount.pArchive->Find( normalized.substr( mount.mountPoint.size() ) );
+			if ( pEntry != nullptr )
+			{
+				pArchive = mount.pArchive.get();
+				return pEntry;
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+FileView::FileView( FileView&& other ) noexcept
+{
+	*this = std::move( other );
+}
+
+FileView& FileView::operator=( FileView&& other ) noexcept
+{
+	if ( this != &other )
+	{
+		// Moving the mapping and the buffer keeps their storage where it is, so pData stays valid
+		Mapping = std::move( other.Mapping );
+		Buffer = std::move( other.Buffer );
+		pData = other.pData;
+		size = other.size;
+		bOpen = other.bOpen;
+		bArchived = other.bArchived;
+
+		other.Close();
+	}
+
+	return *this;
+}
+
+void FileView::Close()
+{
+	Mapping.Close();
+	std::vector<uint8_t>().swap( Buffer );
+	pData = nullptr;
+	size = 0;
+	bOpen = false;
+	bArchived = false;
+}
+
+bool FileView::OpenLooseFile( const std::string& path, MappedFile::AccessPattern pattern )
+{
+	Close();
+
+	if ( !Mapping.Open( path, pattern ) )
+	{
+		return false;
+	}
+
+	pData = Mapping.GetData();
+	size = Mapping.GetSize();
+	bOpen = true;
+
+	return true;
+}
+
+bool FileView::OpenArchiveEntry( const AssetArchive& archive, const ArchiveEntry& entry )
+{
+	Close();
+
+	if ( entry.compression == static_cast< uint32_t >( ArchiveCompression::None ) )
+	{
+		pData = archive.GetStoredData( entry );
+	}
+	else
+	{
+		if ( !archive.Read( entry, Buffer ) )
+		{
+			Close();
+			return false;
+		}
+
+		pData = Buffer.data();
+	}
+
+	size = static_cast< size_t >( entry.size );
+	bOpen = true;
+	bArchived = true;
+
+	return true;
+}
+
+std::string VirtualFileSystem::NormalizePath( const std::string& path )
+{
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::absolute( path, error );
+
+	return ( error ? std::filesystem::path( path ) : absolute ).lexically_normal().generic_string();
+}
+
+bool VirtualFileSystem::Mount( const std::string& archivePath, const std::string& mountPoint )
+{
+	std::unique_ptr<AssetArchive> pArchive( new AssetArchive() );
+
+	if ( !pArchive->Open( archivePath ) )
+	{
+		return false;
+	}
+
+	std::string normalized = VirtualFileSystem::NormalizePath( mountPoint );
+	if ( normalized.empty() || normalized.back() != '/' )
+	{
+		normalized += '/';
+	}
+
+	mountedArchives.push_back( MountedArchive{ normalized, std::move( pArchive ) } );
+
+	return true;
+}
+
+void VirtualFileSystem::UnmountAll()
+{
+	mountedArchives.clear();
+}
+
+bool VirtualFileSystem::Open( const std::string& path, FileView& view, MappedFile::AccessPattern pattern )
+{
+	const AssetArchive* pArchive = nullptr;
+	const ArchiveEntry* pEntry = FindArchived( path, pArchive );
+
+	if ( pEntry != nullptr )
+	{
+		return view.OpenArchiveEntry( *pArchive, *pEntry );
+	}
+
+	return view.OpenLooseFile( path, pattern );
+}
+
+bool VirtualFileSystem::OpenUncompressed( const std::string& path, FileView& view, MappedFile::AccessPattern pattern )
+{
+	const AssetArchive* pArchive = nullptr;
+	const ArchiveEntry* pEntry = FindArchived( path, pArchive );
+
+	if ( pEntry != nullptr )
+	{
+		if ( pEntry->compression != static_cast< uint32_t >( ArchiveCompression::None ) )
+		{
+			view.Close();
+			return false;
+		}
+
+		return view.OpenArchiveEntry( *pArchive, *pEntry );
+	}
+
+	return view.OpenLooseFile( path, pattern );
+}
+
+bool VirtualFileSystem::Exists( const std::string& path )
+{
+	const AssetArchive* pArchive = nullptr;
+	if ( FindArchived( path, pArchive ) != nullptr )
+	{
+		return true;
+	}
+
+	std::error_code error;
+	return std::filesystem::is_regular_file( path, error );
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+class AssetArchive;
+struct ArchiveEntry;
+
+// The bytes of one file opened through VirtualFileSystem: a raw archive entry served in place
+// from the archive's mapping, a decompressed archive entry, or a mapped loose file. Move only.
+class FileView
+{
+public:
+	FileView() = default;
+	FileView( FileView&& other ) noexcept;
+	FileView& operator=( FileView&& other ) noexcept;
+	FileView( const FileView& ) = delete;
+	FileView& operator=( const FileView& ) = delete;
+
+	void Close();
+
+	bool IsOpen() const { return bOpen; }
+	bool IsArchived() const { return bArchived; }
+	const uint8_t* GetData() const { return pData; }
+	size_t GetSize() const { return size; }
+
+	// Loose files only; archived entries are already resident or decompressed
+	void Prefetch( size_t offset, size_t byteCount ) const { Mapping.Prefetch( offset, byteCount ); }
+
+	// Used by VirtualFileSystem::Open once it has resolved the path
+	bool OpenLooseFile( const std::string& path, MappedFile::AccessPattern pattern );
+	bool OpenArchiveEntry( const AssetArchive& archive, const ArchiveEntry& entry );
+
+private:
+	MappedFile Mapping;
+	std::vector<uint8_t> Buffer;
+	const uint8_t* pData = nullptr;
+	size_t size = 0;
+	bool bOpen = false;
+	bool bArchived = false;
+};
+
+// Resolves asset paths against mounted archives first and loose files second. Callers keep using
+// the loose file paths (TEXTURE_PATH + name, "shaders/vert.spv"): an archive mounted at
+// "../assets/" serves "../assets/textures/chaletTex.jpg" from its "textures/chaletTex.jpg" entry.
+namespace VirtualFileSystem
+{
+	// Archives are searched in mount order. Mount during startup: Open runs on loader threads
+	// without locking, so the mount table must not change while assets load.
+	bool Mount( const std::string& archivePath, const std::string& mountPoint );
+	void UnmountAll();
+
+	bool Open( const std::string& path, FileView& view, MappedFile::AccessPattern pattern = MappedFile::AccessPattern::Sequential );
+	// For reads of a few ranges of a file: serves raw archive entries in place like Open, but fails on a
+	// compressed entry rather than decompressing all of it. AssetArchive::Pack stores such files raw.
+	bool OpenUncompressed( const std::string& path, FileView& view, MappedFile::AccessPattern pattern = MappedFile::AccessPattern::Random );
+	bool Exists( const std::string& path );
+
+	// Absolute and lexically normal, '/' separated; symlinks aren't resolved, since archive entries have none.
+	// Mount points are matched against it, and TextureCache keys on it, so one file has one key either way.
+	std::string NormalizePath( const std::string& path );
+}
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include <cstdint>
 #include <optional>
 #include <set>
+#include <chrono>
+
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "VulkanAPI.h"
 #include "VulkanGraphicsInstance.h"
@@ -23,9 +26,49 @@
 const int WIDTH = 800;
 const int HEIGHT = 600;
 
+// Opt-in render and import paths, from the command line (see main.cpp)
+struct Vulkan2020Options
+{
+	bool bBindless = false;
+	bool bStreaming = false;
+	bool bGPUCulling = false;
+	bool bValidateGPUCulling = false;
+	bool bClusterCulling = false;
+	bool bOcclusionCulling = false;
+	bool bAtlas = false;		// load models through InitializeAtlasedModels
+
+	// Parses the flags after the program name; prints the usage and returns false on one it doesn't know
+	bool Parse( int argc, char** argv )
+	{
+		for ( int i = 0; i < argc; ++i )
+		{
+			bool* pFlag = strcmp( argv[i], "-bindless" ) == 0 ? &bBindless
+				: strcmp( argv[i], "-stream" ) == 0 ? &bStreaming
+				: strcmp( argv[i], "-gpucull" ) == 0 ? &bGPUCulling
+				: strcmp( argv[i], "-validatecull" ) == 0 ? &bValidateGPUCulling
+				: strcmp( argv[i], "-clustercull" ) == 0 ? &bClusterCulling
+				: strcmp( argv[i], "-occlusioncull" ) == 0 ? &bOcclusionCulling
+				: strcmp( argv[i], "-atlas" ) == 0 ? &bAtlas
+				: nullptr;
+
+			if ( pFlag == nullptr )
+			{
+				std::cerr << "usage: Vulkan2020 [-bindless] [-stream] [-gpucull] [-validatecull] [-clustercull] [-occlusioncull] [-atlas]" << std::endl;
+				return false;
+			}
+
+			*pFlag = true;
+		}
+
+		return true;
+	}
+};
+
 class Vulkan2020App
 {
 public:
+	explicit Vulkan2020App( const Vulkan2020Options& options ) : Options( options ) {}
+
 	void Run()
 	{
 		InitWindow();
@@ -46,6 +89,9 @@ private:
 
 	bool framebufferResized = false;
 
+	Vulkan2020Options Options;
+	uint32_t ReportedCullMismatches = 0;
+
 private:
 	void InitWindow()
 	{
@@ -60,6 +106,32 @@ private:
 		auto extensions = GetRequiredExtensions();
 		pGraphicsInstance->PreInitInstance( extensions );
 
+		// Streaming and every GPU culling mode need bindless textures, so they bring it along
+		if ( Options.bBindless || Options.bStreaming || Options.bGPUCulling || Options.bValidateGPUCulling || Options.bClusterCulling || Options.bOcclusionCulling )
+		{
+			pGraphicsInstance->EnableBindlessTextures();
+		}
+
+		if ( Options.bStreaming )
+		{
+			pGraphicsInstance->EnableTextureStreaming( VkDeviceSize( 256 ) * 1024 * 1024 );
+		}
+
+		if ( Options.bGPUCulling || Options.bValidateGPUCulling )
+		{
+			pGraphicsInstance->EnableGPUCulling( Options.bValidateGPUCulling );
+		}
+
+		if ( Options.bClusterCulling )
+		{
+			pGraphicsInstance->EnableClusterCulling();
+		}
+
+		if ( Options.bOcclusionCulling )
+		{
+			pGraphicsInstance->EnableOcclusionCulling();
+		}
+
 		pGraphicsInstance->InitInstance( pRenderWindow );
 
 		Init();
@@ -142,16 +214,36 @@ private:
 	}
 
 	Model TestCactus;
+	Scene::Entity TestCactusEntity = Scene::INVALID_ENTITY;
 
 	void Init()
 	{
-		pGraphicsInstance->InitializeModel( &TestCactus, "../assets/models/Cactus_4.obj" );
-		//pGraphicsInstance->InitializeModel( &TestCactus, "../assets/models/chalet.obj", "chaletTex.jpg" );
+		const std::vector<Model*> models = { &TestCactus };
+		const std::vector<const char*> filenames = { "../assets/models/Cactus_4.obj" };
+		const std::vector<const char*> texnames = { "chaletTex.jpg" };
+		//const std::vector<const char*> filenames = { "../assets/models/chalet.obj" };
+
+		std::vector<Scene::Entity> entities = Options.bAtlas ? pGraphicsInstance->InitializeAtlasedModels( models, filenames, texnames ) : pGraphicsInstance->InitializeModels( models, filenames, texnames );
+		TestCactusEntity = entities[0];
 	}
 
 	void Update()
 	{
+		static auto startTime = std::chrono::high_resolution_clock::now();
+
+		auto currentTime = std::chrono::high_resolution_clock::now();
+		float time = std::chrono::duration<float, std::chrono::seconds::period>( currentTime - startTime ).count();
 
+		pGraphicsInstance->GetScene().SetLocalTransform( TestCactusEntity, glm::rotate( glm::mat4( 1.0f ), time * glm::radians( 90.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) ) );
+
+		// Validation compares the cull shader's visible count with the CPU culler's for the same frame
+		const GPUCuller::Statistics& cullStats = pGraphicsInstance->GetGPUCullingStatistics();
+		if ( cullStats.framesMismatched != ReportedCullMismatches )
+		{
+			ReportedCullMismatches = cullStats.framesMismatched;
+			std::cerr << "GPU culling mismatch: " << cullStats.drawsVisible << " visible on the GPU, " << cullStats.cpuVisible << " on the CPU ("
+				<< cullStats.framesMismatched << " of " << cullStats.framesValidated << " frames)" << std::endl;
+		}
 	}
 
 	void Destroy()
@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 #include "RenderWindowClass.h"
 #include "FileUtils.h"
@@ -58,10 +59,43 @@ bool VulkanGraphicsInstance::InitInstanceInternal( RenderWindow* pRenderWindow )
 
 	PickPhysicalDevice();
 	CreateLogicalDevice();
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties( physicalDevice, &deviceProperties );
+	Samplers.Init( vulkanDevice, deviceProperties.limits.maxSamplerAllocationCount );
+	DescriptorLayouts.Init( vulkanDevice );
+	PipelineLayouts.Init( vulkanDevice );
+	TextureDecoding.Init();
+	Textures.Init( this );
 	CreateSwapChain();
 	CreateImageViews();
 	CreateRenderPass();
 	CreateDescriptorSetLayout();
+
+	if ( bBindlessEnabled )
+	{
+		BindlessTextures.Init( vulkanDevice, DescriptorLayouts, GetBindlessTextureCapacity() );
+	}
+
+	// Streamed textures swap their image view as mips come and go, which only the bindless table can absorb
+	if ( bStreamingRequested && bBindlessEnabled )
+	{
+		TextureStreaming.Init( this, &BindlessTextures, StreamingBudget );
+		bStreamingEnabled = true;
+	}
+
+	if ( bGPUCullingEnabled )
+	{
+		GPUCulling.Init( this, DescriptorLayouts, PipelineLayouts, MAX_FRAMES_IN_FLIGHT, bClusterCullingRequested, bOcclusionCullingEnabled );
+	}
+
+	if ( bOcclusionCullingEnabled )
+	{
+		OcclusionPyramid.Init( this, DescriptorLayouts, PipelineLayouts, msaaSamples );
+	}
+
+	InstanceBuffers.resize( MAX_FRAMES_IN_FLIGHT );
+
 	CreateGraphicsPipeline();
 	CreateCommandPool();
 	CreateColorResources();
@@ -70,6 +104,7 @@ bool VulkanGraphicsInstance::InitInstanceInternal( RenderWindow* pRenderWindow )
 
 	CreateUniformBuffers();
 	CreateDescriptorPool();
+	CreateDescriptorSets();
 
 	return output;
 }
@@ -87,7 +122,50 @@ bool VulkanGraphicsInstance::DestroyInstanceInternal()
 
 	CleanupSwapChain();
 
-	vkDestroyDescriptorSetLayout( vulkanDevice, descriptorSetLayout, nullptr );
+	RenderScene.Clear();
+
+	for ( InstanceBuffer& instances : InstanceBuffers )
+	{
+		if ( instances.buffer != VK_NULL_HANDLE )
+		{
+			vkUnmapMemory( vulkanDevice, instances.memory );
+			vkDestroyBuffer( vulkanDevice, instances.buffer, nullptr );
+			vkFreeMemory( vulkanDevice, instances.memory, nullptr );
+		}
+	}
+	InstanceBuffers.clear();
+
+	PersistentDescriptors.Cleanup();
+	for ( DescriptorAllocator& allocator : FrameDescriptors )
+	{
+		allocator.Cleanup();
+	}
+
+	Textures.Cleanup();
+
+	if ( bStreamingEnabled )
+	{
+		TextureStreaming.Cleanup();
+	}
+
+	if ( bOcclusionCullingEnabled )
+	{
+		OcclusionPyramid.Cleanup();
+	}
+
+	if ( bGPUCullingEnabled )
+	{
+		GPUCulling.Cleanup();
+	}
+
+	if ( bBindlessEnabled )
+	{
+		BindlessTextures.Cleanup();
+	}
+
+	PipelineLayouts.Cleanup();
+	DescriptorLayouts.Cleanup();
+	TextureDecoding.Cleanup();
 
 	for ( size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i )
 	{
@@ -98,6 +176,8 @@ bool VulkanGraphicsInstance::DestroyInstanceInternal()
 
 	vkDestroyCommandPool( vulkanDevice, commandPool, nullptr );
 
+	Samplers.Cleanup();
+
 	vkDestroyDevice( vulkanDevice, nullptr );
 
 #ifdef _DEBUG
@@ -133,7 +213,16 @@ void VulkanGraphicsInstance::DrawFrameInternal()
 	}
 	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
 
+	// The fence for this frame slot has signalled, nothing allocated from its transient pools is still in use
+	FrameDescriptors[currentFrame].ResetPools();
+
+	if ( bStreamingEnabled )
+	{
+		TextureStreaming.Update();
+	}
+
 	UpdateUniformBuffer( imageIndex );
+	RecordCommandBuffer( imageIndex );
 
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -209,7 +298,6 @@ void VulkanGraphicsInstance::RecreateSwapChain()
 	CreateDepthResources();
 	CreateFramebuffers();
 	CreateUniformBuffers();
-	CreateDescriptorPool();
 	CreateDescriptorSets();
 	CreateCommandBuffers();
 }
@@ -226,7 +314,7 @@ void VulkanGraphicsInstance::CreateInstance()
 	appInfo.applicationVersion = VK_MAKE_VERSION( 1, 0, 0 );
 	appInfo.pEngineName = "No Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION( 1, 0, 0 );
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	appInfo.apiVersion = VK_API_VERSION_1_2;
 
 	VkInstanceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -267,6 +355,9 @@ void VulkanGraphicsInstance::PickPhysicalDevice()
 		{
 			physicalDevice = device;
 			msaaSamples = GetMaxUsableSampleCount();
+			bBindlessEnabled = bBindlessRequested && CheckDescriptorIndexingSupport( device );
+			bGPUCullingEnabled = bGPUCullingRequested && bBindlessEnabled && GPUCuller::IsSupported( device );
+			bOcclusionCullingEnabled = bOcclusionCullingRequested && bGPUCullingEnabled && !bClusterCullingRequested && DepthPyramid::IsSupported( device, msaaSamples );
 			break;
 		}
 	}
@@ -364,6 +455,52 @@ bool VulkanGraphicsInstance::CheckDeviceExtensionSupport( VkPhysicalDevice devic
 	return requiredExtensions.empty();
 }
 
+bool VulkanGraphicsInstance::CheckDescriptorIndexingSupport( VkPhysicalDevice device )
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties( device, &properties );
+
+	// Descriptor indexing is core from 1.2; older devices fall back to per-texture descriptor sets
+	if ( properties.apiVersion < VK_API_VERSION_1_2 )
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &indexingFeatures;
+
+	vkGetPhysicalDeviceFeatures2( device, &features );
+
+	return indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+		&& indexingFeatures.runtimeDescriptorArray
+		&& indexingFeatures.descriptorBindingPartiallyBound
+		&& indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+		&& indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+}
+
+uint32_t VulkanGraphicsInstance::GetBindlessTextureCapacity()
+{
+	VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexingProperties;
+
+	vkGetPhysicalDeviceProperties2( physicalDevice, &properties );
+
+	const uint32_t maxBindlessTextures = 4096;
+
+	return std::min( { maxBindlessTextures,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSamplers } );
+}
+
 SwapChainSupportDetails VulkanGraphicsInstance::QuerySwapChainSupport( VkPhysicalDevice device )
 {
 	SwapChainSupportDetails details;
@@ -409,10 +546,22 @@ void VulkanGraphicsInstance::CreateLogicalDevice()
 		queueCreateInfos.push_back( queueCreateInfo );
 	}
 
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures( physicalDevice, &supportedFeatures );
+
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.sampleRateShading = VK_TRUE;
 
+	// Enable whichever block compression families exist; VulkanTexture picks a variant per device
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	deviceFeatures.textureCompressionETC2 = supportedFeatures.textureCompressionETC2;
+	deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+
+	// GPU culling writes one draw per object with the object's index as its first instance
+	deviceFeatures.multiDrawIndirect = bGPUCullingEnabled ? VK_TRUE : VK_FALSE;
+	deviceFeatures.drawIndirectFirstInstance = bGPUCullingEnabled ? VK_TRUE : VK_FALSE;
+
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
@@ -421,8 +570,28 @@ void VulkanGraphicsInstance::CreateLogicalDevice()
 
 	createInfo.pEnabledFeatures = &deviceFeatures;
 
-	createInfo.enabledExtensionCount = static_cast< uint32_t >( deviceExtensions.size() );
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+	if ( bBindlessEnabled )
+	{
+		indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+		createInfo.pNext = &indexingFeatures;
+	}
+
+	std::vector<const char*> enabledExtensions = deviceExtensions;
+	if ( bGPUCullingEnabled )
+	{
+		enabledExtensions.push_back( VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME );
+	}
+
+	createInfo.enabledExtensionCount = static_cast< uint32_t >( enabledExtensions.size() );
+	createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 #ifdef _DEBUG
 	createInfo.enabledLayerCount = static_cast< uint32_t >( validationLayers.size() );
@@ -558,6 +727,44 @@ VkImageView VulkanGraphicsInstance::CreateImageView( VkImage image, VkFormat for
 	return imageView;
 }
 
+bool VulkanGraphicsInstance::IsFormatSampleable( VkFormat format )
+{
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties( physicalDevice, format, &props );
+
+	const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	return ( props.optimalTilingFeatures & required ) == required;
+}
+
+bool VulkanGraphicsInstance::ShouldGenerateMipsOnCPU( VkFormat format )
+{
+	if ( bPreferCPUMips )
+	{
+		return true;
+	}
+
+	// Software rasterizers run the blits on the CPU anyway, one level at a time
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties( physicalDevice, &deviceProperties );
+
+	if ( deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU )
+	{
+		return true;
+	}
+
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties( physicalDevice, format, &props );
+
+	const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return ( props.optimalTilingFeatures & required ) != required;
+}
+
+void VulkanGraphicsInstance::RecordCPUMipGeneration( double milliseconds )
+{
+	++MipStats.cpuTextures;
+	MipStats.cpuMilliseconds += milliseconds;
+}
+
 void VulkanGraphicsInstance::CreateImageViews()
 {
 	swapChainImageViews.resize( swapChainImages.size() );
@@ -627,6 +834,30 @@ void VulkanGraphicsInstance::CreateRenderPass()
 	subpass.pResolveAttachments = &colorAttachmentResolveRef;
 	subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
+	std::vector<VkSubpassDependency> dependencies = { dependency };
+
+	// Occlusion culling splits the scene around the depth pyramid build: this pass keeps its colour and depth,
+	// leaving the depth for compute shaders to read, and lateRenderPass carries on from them
+	if ( bOcclusionCullingEnabled )
+	{
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		// The depth clear mustn't overtake the last frame's pyramid build either
+		dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[0].dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+
+		VkSubpassDependency depthReadDependency = {};
+		depthReadDependency.srcSubpass = 0;
+		depthReadDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+		depthReadDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		depthReadDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		depthReadDependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		depthReadDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		dependencies.push_back( depthReadDependency );
+	}
+
 	std::array<VkAttachmentDescription, 3> attachments = { colorAttachment, depthAttachment, colorAttachmentResolve };
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -634,19 +865,47 @@ void VulkanGraphicsInstance::CreateRenderPass()
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	renderPassInfo.dependencyCount = static_cast< uint32_t >( dependencies.size() );
+	renderPassInfo.pDependencies = dependencies.data();
 
 	VkResult result = vkCreateRenderPass( vulkanDevice, &renderPassInfo, nullptr, &renderPass );
 	assert( VK_SUCCESS == result && "failed to create render pass!" );
+
+	if ( bOcclusionCullingEnabled )
+	{
+		// Compatible with renderPass, so the same pipelines and framebuffers serve both
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		attachments[2].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		// After the first pass's attachment writes, and the pyramid build's reads of its depth
+		VkSubpassDependency lateDependency = {};
+		lateDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		lateDependency.dstSubpass = 0;
+		lateDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		lateDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		lateDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		lateDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &lateDependency;
+
+		result = vkCreateRenderPass( vulkanDevice, &renderPassInfo, nullptr, &lateRenderPass );
+		assert( VK_SUCCESS == result && "failed to create late render pass!" );
+	}
 }
 
 VkFormat VulkanGraphicsInstance::FindDepthFormat()
 {
+	// The depth pyramid is built by sampling the depth buffer
 	return FindSupportedFormat(
 		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | ( bOcclusionCullingEnabled ? VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT : 0 )
 	);
 }
 
@@ -687,36 +946,64 @@ void VulkanGraphicsInstance::CreateDescriptorSetLayout()
 	samplerLayoutBinding.pImmutableSamplers = nullptr;
 	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-	std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount = static_cast< uint32_t >( bindings.size() );
-	layoutInfo.pBindings = bindings.data();
-
-	VkResult result = vkCreateDescriptorSetLayout( vulkanDevice, &layoutInfo, nullptr, &descriptorSetLayout );
-	assert( VK_SUCCESS == result && "failed to create descriptor set layout!" );
+	descriptorSetLayout = DescriptorLayouts.GetLayout( { uboLayoutBinding, samplerLayoutBinding } );
 }
 
 void VulkanGraphicsInstance::CreateGraphicsPipeline()
 {
-	VulkanVertexShader vertexShader(this, "shaders/vert.spv" );
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof( PushConstantData );
+
+	// Set 0: per-frame UBO (+ per-texture sampler when not bindless), set 1: bindless texture table
+	std::vector<VkDescriptorSetLayout> setLayouts = { descriptorSetLayout };
+	if ( bBindlessEnabled )
+	{
+		setLayouts.push_back( BindlessTextures.GetLayout() );
+	}
+
+	pipelineLayout = PipelineLayouts.GetLayout( setLayouts, { pushConstantRange } );
+
 	//VulkanFragmentShader fragmentShader( this, "shaders/frag.spv" );
-	VulkanFragmentShader fragmentShader( this, "shaders/colorFrag.spv" );
 	//VulkanFragmentShader fragmentShader( this, "shaders/textureFrag.spv" );
+	graphicsPipeline = CreateScenePipeline( "shaders/vert.spv", bBindlessEnabled ? "shaders/bindlessFrag.spv" : "shaders/colorFrag.spv", pipelineLayout, true );
+
+	if ( bGPUCullingEnabled )
+	{
+		// Sets 0 and 1 stay compatible with pipelineLayout, so the pass binds them once for both pipelines
+		setLayouts.push_back( GPUCulling.GetObjectSetLayout() );
+		indirectPipelineLayout = PipelineLayouts.GetLayout( setLayouts, { pushConstantRange } );
+		indirectPipeline = CreateScenePipeline( "shaders/indirectVert.spv", "shaders/bindlessIndirectFrag.spv", indirectPipelineLayout, false );
+	}
+}
+
+VkPipeline VulkanGraphicsInstance::CreateScenePipeline( const char* vertexShaderName, const char* fragmentShaderName, VkPipelineLayout layout, bool bInstanced )
+{
+	VulkanVertexShader vertexShader( this, vertexShaderName );
+	VulkanFragmentShader fragmentShader( this, fragmentShaderName );
 
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo = vertexShader.GetCreateInfo();
 	VkPipelineShaderStageCreateInfo fragShaderStageInfo = fragmentShader.GetCreateInfo();
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-	auto bindingDescription = Vertex::GetBindingDescription();
-	auto attributeDescriptions = Vertex::GetAttributeDescriptions();
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions = { Vertex::GetBindingDescription() };
+	auto vertexAttributes = Vertex::GetAttributeDescriptions();
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions( vertexAttributes.begin(), vertexAttributes.end() );
+
+	if ( bInstanced )
+	{
+		auto instanceAttributes = InstanceData::GetAttributeDescriptions();
+		bindingDescriptions.push_back( InstanceData::GetBindingDescription() );
+		attributeDescriptions.insert( attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end() );
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast< uint32_t >( bindingDescriptions.size() );
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast< uint32_t >( attributeDescriptions.size() );
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -774,15 +1061,6 @@ void VulkanGraphicsInstance::CreateGraphicsPipeline()
 	colorBlending.blendConstants[2] = 0.0f;
 	colorBlending.blendConstants[3] = 0.0f;
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-	//pipelineLayoutInfo.pushConstantRangeCount = 0;
-
-	VkResult result = vkCreatePipelineLayout( vulkanDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout );
-	assert( VK_SUCCESS == result && "failed to create pipeline layout!" );
-
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineInfo.stageCount = 2;
@@ -793,7 +1071,7 @@ void VulkanGraphicsInstance::CreateGraphicsPipeline()
 	pipelineInfo.pRasterizationState = &rasterizer;
 	pipelineInfo.pMultisampleState = &multisampling;
 	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.layout = layout;
 	pipelineInfo.renderPass = renderPass;
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
@@ -812,10 +1090,13 @@ void VulkanGraphicsInstance::CreateGraphicsPipeline()
 
 	pipelineInfo.pDepthStencilState = &depthStencil;
 
-	if ( vkCreateGraphicsPipelines( vulkanDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline ) != VK_SUCCESS )
+	VkPipeline pipeline;
+	if ( vkCreateGraphicsPipelines( vulkanDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
 	{
 		throw std::runtime_error( "failed to create graphics pipeline!" );
 	}
+
+	return pipeline;
 }
 
 VkShaderModule VulkanGraphicsInstance::CreateShaderModule( const std::vector<char>& code )
@@ -839,6 +1120,7 @@ void VulkanGraphicsInstance::CreateCommandPool()
 	VkCommandPoolCreateInfo poolInfo = {};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	//poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // command buffers are re-recorded every frame
 
 	VkResult result = vkCreateCommandPool( vulkanDevice, &poolInfo, nullptr, &commandPool );
 	assert( VK_SUCCESS == result && "failed to create command pool!" );
@@ -848,7 +1130,10 @@ void VulkanGraphicsInstance::CreateColorResources()
 {
 	VkFormat colorFormat = swapChainImageFormat;
 
-	CreateImage( swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ColorImage, ColorImageMemory );
+	// Occlusion culling draws into it over two render passes, so it has to outlive the first
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | ( bOcclusionCullingEnabled ? 0 : VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT );
+
+	CreateImage( swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, colorFormat, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ColorImage, ColorImageMemory );
 	ColorImageView = CreateImageView( ColorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1 );
 }
 
@@ -896,11 +1181,34 @@ void VulkanGraphicsInstance::GenerateMipmaps( VkImage image, VkFormat imageForma
 
 	if ( !( formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT ) )
 	{
-		assert( false && "texture image format does not support linear blitting!" );
+		assert( false && "texture image format does not support linear blitting, check ShouldGenerateMipsOnCPU first!" );
+	}
+
+	// Bracket the blits with timestamps so MipStats can be compared against the CPU path
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties( physicalDevice, &deviceProperties );
+
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+
+	if ( deviceProperties.limits.timestampComputeAndGraphics )
+	{
+		VkQueryPoolCreateInfo queryPoolInfo = {};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2;
+
+		VkResult result = vkCreateQueryPool( vulkanDevice, &queryPoolInfo, nullptr, &queryPool );
+		assert( VK_SUCCESS == result && "failed to create timestamp query pool!" );
 	}
 
 	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
 
+	if ( queryPool != VK_NULL_HANDLE )
+	{
+		vkCmdResetQueryPool( commandBuffer, queryPool, 0, 2 );
+		vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0 );
+	}
+
 	VkImageMemoryBarrier barrier = {};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.image = image;
@@ -990,7 +1298,24 @@ void VulkanGraphicsInstance::GenerateMipmaps( VkImage image, VkFormat imageForma
 		1, &barrier
 	);
 
+	if ( queryPool != VK_NULL_HANDLE )
+	{
+		vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1 );
+	}
+
 	EndSingleTimeCommands( commandBuffer );
+
+	++MipStats.blitTextures;
+
+	if ( queryPool != VK_NULL_HANDLE )
+	{
+		uint64_t timestamps[2] = {};
+		vkGetQueryPoolResults( vulkanDevice, queryPool, 0, 2, sizeof( timestamps ), timestamps, sizeof( uint64_t ), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT );
+
+		MipStats.blitMilliseconds += static_cast< double >( timestamps[1] - timestamps[0] ) * deviceProperties.limits.timestampPeriod / 1000000.0;
+
+		vkDestroyQueryPool( vulkanDevice, queryPool, nullptr );
+	}
 }
 
 uint32_t VulkanGraphicsInstance::FindMemoryType( uint32_t typeFilter, VkMemoryPropertyFlags properties )
@@ -1014,10 +1339,18 @@ void VulkanGraphicsInstance::CreateDepthResources()
 {
 	VkFormat depthFormat = FindDepthFormat();
 
-	CreateImage( swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DepthImage, DepthImageMemory );
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | ( bOcclusionCullingEnabled ? VK_IMAGE_USAGE_SAMPLED_BIT : 0 );
+
+	CreateImage( swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DepthImage, DepthImageMemory );
 	DepthImageView = CreateImageView( DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1 );
 
 	TransitionImageLayout( DepthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1 );
+
+	if ( bOcclusionCullingEnabled )
+	{
+		OcclusionPyramid.Create( DepthImageView, swapChainExtent );
+		GPUCulling.SetDepthPyramid( OcclusionPyramid.GetView(), OcclusionPyramid.GetSampler(), OcclusionPyramid.GetExtent() );
+	}
 }
 
 bool VulkanGraphicsInstance::HasStencilComponent( VkFormat format )
@@ -1066,39 +1399,64 @@ void VulkanGraphicsInstance::CreateFramebuffers()
 
 void VulkanGraphicsInstance::CreateDescriptorPool()
 {
-	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[0].descriptorCount = static_cast< uint32_t >( swapChainImages.size() );
-	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount = static_cast< uint32_t >( swapChainImages.size() );
+	// Pools grow on demand, so the initial size only needs to cover a typical scene
+	const uint32_t initialSetsPerPool = 64;
+
+	const std::vector<DescriptorAllocator::PoolSizeRatio> poolRatios =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+	};
 
-	VkDescriptorPoolCreateInfo poolInfo = {};
-	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount = static_cast< uint32_t >( poolSizes.size() );
-	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = static_cast< uint32_t >( swapChainImages.size() );
+	PersistentDescriptors.Init( vulkanDevice, initialSetsPerPool * static_cast< uint32_t >( swapChainImages.size() ), poolRatios );
 
-	VkResult result = vkCreateDescriptorPool( vulkanDevice, &poolInfo, nullptr, &DescriptorPool );
-	assert( VK_SUCCESS == result && "failed to create descriptor pool!" );
+	FrameDescriptors.resize( MAX_FRAMES_IN_FLIGHT );
+	for ( DescriptorAllocator& allocator : FrameDescriptors )
+	{
+		allocator.Init( vulkanDevice, initialSetsPerPool, poolRatios );
+	}
 }
 
 void VulkanGraphicsInstance::CreateDescriptorSets()
 {
-	//TEST_MODEL.CreateDescriptorSets();
+	if ( bBindlessEnabled )
+	{
+		// Textures come from the bindless table, so set 0 only carries the UBO and is shared by every draw.
+		// Binding 1 is left unwritten; the bindless fragment shader never statically uses it.
+		std::vector<VkDescriptorSetLayout> layouts( swapChainImages.size(), descriptorSetLayout );
+		PersistentDescriptors.Allocate( layouts, DescriptorSets );
+
+		for ( size_t i = 0; i < swapChainImages.size(); i++ )
+		{
+			VkDescriptorBufferInfo bufferInfo = {};
+			bufferInfo.buffer = UniformBuffers[i];
+			bufferInfo.offset = 0;
+			bufferInfo.range = sizeof( UniformBufferObject );
+
+			VkWriteDescriptorSet descriptorWrite = {};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = DescriptorSets[i];
+			descriptorWrite.dstBinding = 0;
+			descriptorWrite.dstArrayElement = 0;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pBufferInfo = &bufferInfo;
+
+			vkUpdateDescriptorSets( vulkanDevice, 1, &descriptorWrite, 0, nullptr );
+		}
+	}
+
+	// Sets reference the per-swapchain-image uniform buffers, so they are rebuilt along with them
+	for ( Model* pModel : RenderScene.GetMeshes() )
+	{
+		pModel->CreateDescriptorSets();
+	}
 }
 
 void VulkanGraphicsInstance::CreateImageSamplerDescriptorSet( std::vector<VkDescriptorSet>& DescriptorSetVector, VkImageView TextureImageView, VkSampler TextureSampler )
 {
 	std::vector<VkDescriptorSetLayout> layouts( swapChainImages.size(), descriptorSetLayout );
-	VkDescriptorSetAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = DescriptorPool;
-	allocInfo.descriptorSetCount = static_cast< uint32_t >( swapChainImages.size() );
-	allocInfo.pSetLayouts = layouts.data();
-
-	DescriptorSetVector.resize( swapChainImages.size() );
-	VkResult result = vkAllocateDescriptorSets( vulkanDevice, &allocInfo, DescriptorSetVector.data() );
-	assert( VK_SUCCESS == result && "failed to allocate descriptor sets!" );
+	PersistentDescriptors.Allocate( layouts, DescriptorSetVector );
 
 	for ( size_t i = 0; i < swapChainImages.size(); i++ )
 	{
@@ -1134,6 +1492,27 @@ void VulkanGraphicsInstance::CreateImageSamplerDescriptorSet( std::vector<VkDesc
 	}
 }
 
+VkDescriptorSet VulkanGraphicsInstance::AllocateTransientDescriptorSet( VkDescriptorSetLayout layout )
+{
+	return FrameDescriptors[currentFrame].Allocate( layout );
+}
+
+DescriptorAllocator::Statistics VulkanGraphicsInstance::GetDescriptorStatistics() const
+{
+	DescriptorAllocator::Statistics stats = PersistentDescriptors.GetStatistics();
+
+	for ( const DescriptorAllocator& allocator : FrameDescriptors )
+	{
+		DescriptorAllocator::Statistics frameStats = allocator.GetStatistics();
+		stats.setsAllocated += frameStats.setsAllocated;
+		stats.poolsInUse += frameStats.poolsInUse;
+		stats.poolsFree += frameStats.poolsFree;
+		stats.poolsCreated += frameStats.poolsCreated;
+	}
+
+	return stats;
+}
+
 void VulkanGraphicsInstance::CreateCommandBuffers()
 {
 	commandBuffers.resize( swapChainFramebuffers.size() );
@@ -1146,43 +1525,228 @@ void VulkanGraphicsInstance::CreateCommandBuffers()
 
 	VkResult result = vkAllocateCommandBuffers( vulkanDevice, &allocInfo, commandBuffers.data() );
 	assert( VK_SUCCESS == result && "failed to allocate command buffers!" );
+}
+
+void VulkanGraphicsInstance::RecordCommandBuffer( uint32_t imageIndex )
+{
+	VkCommandBuffer& commandBuffer = commandBuffers[imageIndex];
 
-	for ( size_t i = 0; i < commandBuffers.size(); ++i )
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	// Implicitly resets the buffer; the pool was created with VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+	if ( vkBeginCommandBuffer( commandBuffer, &beginInfo ) != VK_SUCCESS )
 	{
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		throw std::runtime_error( "failed to begin recording command buffer!" );
+	}
+
+	glm::mat4 view, projection;
+	GetCameraMatrices( view, projection );
+	const FrustumCulling::Frustum frustum = FrustumCulling::ExtractFrustum( projection * view );
 
-		if ( vkBeginCommandBuffer( commandBuffers[i], &beginInfo ) != VK_SUCCESS )
+	RenderScene.Update();
+	RenderScene.SelectLods( CameraPosition, swapChainExtent.height / ( 2.0f * std::tan( glm::radians( CameraFieldOfView ) * 0.5f ) ), LodPixelThreshold );
+
+	if ( bGPUCullingEnabled )
+	{
+		// The CPU culler only runs to check the counts the cull shader writes
+		if ( bValidateGPUCulling )
 		{
-			throw std::runtime_error( "failed to begin recording command buffer!" );
+			RenderScene.Cull( frustum );
 		}
 
-		VkRenderPassBeginInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = renderPass;
-		renderPassInfo.framebuffer = swapChainFramebuffers[i];
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = swapChainExtent;
+		// The cull dispatch goes before the render pass, which it can't be recorded inside
+		GPUCulling.Prepare( static_cast< uint32_t >( currentFrame ), RenderScene, bValidateGPUCulling );
+
+		if ( bOcclusionCullingEnabled )
+		{
+			GPUCulling.RecordOcclusionCull( commandBuffer, static_cast< uint32_t >( currentFrame ), view, projection, false );
+		}
+		else
+		{
+			GPUCulling.RecordCull( commandBuffer, static_cast< uint32_t >( currentFrame ), frustum, CameraPosition );
+		}
+	}
+	else
+	{
+		RenderScene.Cull( frustum );
+		RenderScene.ExtractDrawList( DrawList, &frustum );
+		RenderScene.BatchDrawList( DrawList, DrawBatches, CameraPosition );
+	}
+
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = swapChainExtent;
+
+	std::array<VkClearValue, 2> clearValues = {};
+	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+
+	renderPassInfo.clearValueCount = static_cast< uint32_t >( clearValues.size() );
+	renderPassInfo.pClearValues = clearValues.data();
+
+	vkCmdBeginRenderPass( commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
 
-		std::array<VkClearValue, 2> clearValues = {};
-		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValues[1].depthStencil = { 1.0f, 0 };
+	if ( bBindlessEnabled )
+	{
+		// Bound once for the whole pass; models only push their material index
+		std::array<VkDescriptorSet, 2> sets = { DescriptorSets[imageIndex], BindlessTextures.GetDescriptorSet() };
+		vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast< uint32_t >( sets.size() ), sets.data(), 0, nullptr );
+	}
 
-		renderPassInfo.clearValueCount = static_cast< uint32_t >( clearValues.size() );
-		renderPassInfo.pClearValues = clearValues.data();
+	if ( bGPUCullingEnabled )
+	{
+		RecordIndirectDraws( commandBuffer, imageIndex );
+	}
+	else
+	{
+		RecordDrawList( commandBuffer, imageIndex );
+	}
 
-		vkCmdBeginRenderPass( commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+	vkCmdEndRenderPass( commandBuffer );
 
-		for ( Model* pModel : renderObjects )
+	if ( bOcclusionCullingEnabled )
+	{
+		// What the first pass drew is the occluder set: cull the rest against it, then draw what it doesn't hide
+		OcclusionPyramid.RecordBuild( commandBuffer );
+		GPUCulling.RecordOcclusionCull( commandBuffer, static_cast< uint32_t >( currentFrame ), view, projection, true );
+
+		// Only loads, so the clear values go unused; bound descriptor sets carry over between passes
+		renderPassInfo.renderPass = lateRenderPass;
+		vkCmdBeginRenderPass( commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+		RecordIndirectDraws( commandBuffer, imageIndex, true );
+		vkCmdEndRenderPass( commandBuffer );
+	}
+
+	VkResult result = vkEndCommandBuffer( commandBuffer );
+	assert( VK_SUCCESS == result && "failed to record command buffer!" );
+}
+
+void VulkanGraphicsInstance::RecordDrawList( VkCommandBuffer commandBuffer, uint32_t imageIndex )
+{
+	DrawStats = DrawRecordingStats();
+
+	if ( DrawList.empty() )
+	{
+		return;
+	}
+
+	ReserveInstances( static_cast< uint32_t >( DrawList.size() ) );
+	InstanceBuffer& instances = InstanceBuffers[currentFrame];
+
+	const glm::mat4* pTransforms = RenderScene.GetWorldTransforms();
+	const glm::vec4* pBounds = RenderScene.GetBounds();
+	const glm::vec4* pTints = RenderScene.GetTints();
+
+	for ( size_t i = 0; i < DrawList.size(); ++i )
+	{
+		const Scene::DrawItem& item = DrawList[i];
+		Model* pModel = RenderScene.GetMesh( item.mesh );
+
+		if ( bStreamingEnabled && pModel->pTexture != nullptr )
 		{
-			pModel->BindToCommandBuffer( commandBuffers[i], graphicsPipeline, pipelineLayout, i );
+			pModel->pTexture->RequestScreenSize( EstimateScreenSize( pBounds[item.object] ) );
 		}
 
-		vkCmdEndRenderPass( commandBuffers[i] );
+		instances.pInstances[i].model = pTransforms[item.object];
+		instances.pInstances[i].tint = pTints[item.object];
+	}
+
+	vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline );
+	++DrawStats.pipelineBinds;
 
-		result = vkEndCommandBuffer( commandBuffers[i] );
-		assert( VK_SUCCESS == result && "failed to record command buffer!" );
+	// Binding 1 stays bound while models rebind binding 0
+	VkDeviceSize instanceOffset = 0;
+	vkCmdBindVertexBuffers( commandBuffer, 1, 1, &instances.buffer, &instanceOffset );
+
+	// Batches are sorted by mesh, then material, so each mesh binds once and a material is only pushed when it changes
+	Scene::MeshId boundMesh = Scene::INVALID_MESH;
+	uint32_t pushedMaterial = 0;
+
+	for ( size_t i = 0; i < DrawBatches.size(); ++i )
+	{
+		const Scene::DrawBatch& batch = DrawBatches[i];
+
+		if ( batch.mesh != boundMesh )
+		{
+			RenderScene.GetMesh( batch.mesh )->BindGeometry( commandBuffer, pipelineLayout, imageIndex );
+			boundMesh = batch.mesh;
+			++DrawStats.geometryBinds;
+		}
+
+		if ( i == 0 || batch.material != pushedMaterial )
+		{
+			PushConstantData pushConstants = {};
+			pushConstants.materialIndex = batch.material;
+			vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof( PushConstantData ), &pushConstants );
+			pushedMaterial = batch.material;
+			++DrawStats.materialPushes;
+		}
+
+		vkCmdDrawIndexed( commandBuffer, batch.indexCount, batch.instanceCount, batch.firstIndex, 0, batch.firstInstance );
+	}
+
+	DrawStats.batches = static_cast< uint32_t >( DrawBatches.size() );
+	DrawStats.bindsSkipped = 3 * DrawStats.batches - DrawStats.pipelineBinds - DrawStats.geometryBinds - DrawStats.materialPushes;
+}
+
+void VulkanGraphicsInstance::ReserveInstances( uint32_t count )
+{
+	InstanceBuffer& instances = InstanceBuffers[currentFrame];
+
+	if ( count <= instances.capacity )
+	{
+		return;
 	}
+
+	// This frame slot's fence has signalled, so nothing still reads the old buffer
+	if ( instances.buffer != VK_NULL_HANDLE )
+	{
+		vkUnmapMemory( vulkanDevice, instances.memory );
+		vkDestroyBuffer( vulkanDevice, instances.buffer, nullptr );
+		vkFreeMemory( vulkanDevice, instances.memory, nullptr );
+	}
+
+	instances.capacity = std::max( instances.capacity * 2, std::max( count, 256u ) );
+	CreateBuffer( instances.capacity * sizeof( InstanceData ), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, instances.buffer, instances.memory );
+
+	void* pData;
+	vkMapMemory( vulkanDevice, instances.memory, 0, VK_WHOLE_SIZE, 0, &pData );
+	instances.pInstances = static_cast< InstanceData* >( pData );
+}
+
+void VulkanGraphicsInstance::RecordIndirectDraws( VkCommandBuffer commandBuffer, uint32_t imageIndex, bool bLate )
+{
+	const glm::vec4* pBounds = RenderScene.GetBounds();
+
+	if ( bStreamingEnabled && !bLate )
+	{
+		// Which objects survive isn't known on the CPU, so every drawable entity asks for its texture
+		const Scene::MeshId* pMeshRefs = RenderScene.GetMeshRefs();
+		const uint8_t* pVisibility = RenderScene.GetVisibility();
+
+		for ( uint32_t i = 0; i < RenderScene.GetEntityCount(); ++i )
+		{
+			if ( pMeshRefs[i] == Scene::INVALID_MESH || ( pVisibility[i] & Scene::VISIBILITY_HIDDEN ) != 0 )
+			{
+				continue;
+			}
+
+			Model* pModel = RenderScene.GetMesh( pMeshRefs[i] );
+			if ( pModel->pTexture != nullptr )
+			{
+				pModel->pTexture->RequestScreenSize( EstimateScreenSize( pBounds[i] ) );
+			}
+		}
+	}
+
+	// The object set follows the UBO and bindless sets already bound for the pass
+	vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipeline );
+	GPUCulling.RecordDraws( commandBuffer, static_cast< uint32_t >( currentFrame ), RenderScene, indirectPipelineLayout, 2, imageIndex, bLate );
 }
 
 void VulkanGraphicsInstance::CreateSyncObjects()
@@ -1287,6 +1851,22 @@ void VulkanGraphicsInstance::CopyBufferToImage( VkBuffer buffer, VkImage image,
 	EndSingleTimeCommands( commandBuffer );
 }
 
+void VulkanGraphicsInstance::CopyBufferToImage( VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions )
+{
+	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+
+	vkCmdCopyBufferToImage(
+		commandBuffer,
+		buffer,
+		image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast< uint32_t >( regions.size() ),
+		regions.data()
+	);
+
+	EndSingleTimeCommands( commandBuffer );
+}
+
 //////////////////////////////
 // Command Functions
 //////////////////////////////
@@ -1415,6 +1995,11 @@ void VulkanGraphicsInstance::CleanupSwapChain()
 	vkDestroyImage( vulkanDevice, DepthImage, nullptr );
 	vkFreeMemory( vulkanDevice, DepthImageMemory, nullptr );
 
+	if ( bOcclusionCullingEnabled )
+	{
+		OcclusionPyramid.Destroy();
+	}
+
 	for ( auto framebuffer : swapChainFramebuffers )
 	{
 		vkDestroyFramebuffer( vulkanDevice, framebuffer, nullptr );
@@ -1423,8 +2008,15 @@ void VulkanGraphicsInstance::CleanupSwapChain()
 	vkFreeCommandBuffers( vulkanDevice, commandPool, static_cast< uint32_t >( commandBuffers.size() ), commandBuffers.data() );
 
 	vkDestroyPipeline( vulkanDevice, graphicsPipeline, nullptr );
-	vkDestroyPipelineLayout( vulkanDevice, pipelineLayout, nullptr );
+	if ( bGPUCullingEnabled )
+	{
+		vkDestroyPipeline( vulkanDevice, indirectPipeline, nullptr );
+	}
 	vkDestroyRenderPass( vulkanDevice, renderPass, nullptr );
+	if ( bOcclusionCullingEnabled )
+	{
+		vkDestroyRenderPass( vulkanDevice, lateRenderPass, nullptr );
+	}
 
 	for ( auto imageView : swapChainImageViews )
 	{
@@ -1437,7 +2029,7 @@ void VulkanGraphicsInstance::CleanupSwapChain()
 		vkFreeMemory( vulkanDevice, UniformBuffersMemory[i], nullptr );
 	}
 
-	vkDestroyDescriptorPool( vulkanDevice, DescriptorPool, nullptr );
+	PersistentDescriptors.ResetPools();
 	vkDestroySwapchainKHR( vulkanDevice, swapChain, nullptr );
 }
 
@@ -1448,18 +2040,9 @@ void VulkanGraphicsInstance::CleanupSwapChain()
 
 void VulkanGraphicsInstance::UpdateUniformBuffer( uint32_t currentImage )
 {
-	// Rotate code
-	static auto startTime = std::chrono::high_resolution_clock::now();
-
-	auto currentTime = std::chrono::high_resolution_clock::now();
-	float time = std::chrono::duration<float, std::chrono::seconds::period>( currentTime - startTime ).count();
-
-	// Update Code
+	// Per-object model matrices are pushed while recording, see RecordCommandBuffer
 	UniformBufferObject ubo = {};
-	ubo.model = glm::rotate( glm::mat4( 1.0f ), time * glm::radians( 90.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
-	ubo.view = glm::lookAt( glm::vec3( 2.0f, 3.0f, 2.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
-	ubo.proj = glm::perspective( glm::radians( 45.0f ), swapChainExtent.width / ( float )swapChainExtent.height, 0.1f, 10.0f );
-	ubo.proj[1][1] *= -1;
+	GetCameraMatrices( ubo.view, ubo.proj );
 
 	void* data;
 	vkMapMemory( vulkanDevice, UniformBuffersMemory[currentImage], 0, sizeof( ubo ), 0, &data );
@@ -1467,15 +2050,141 @@ void VulkanGraphicsInstance::UpdateUniformBuffer( uint32_t currentImage )
 	vkUnmapMemory( vulkanDevice, UniformBuffersMemory[currentImage] );
 }
 
+void VulkanGraphicsInstance::GetCameraMatrices( glm::mat4& view, glm::mat4& projection ) const
+{
+	view = glm::lookAt( CameraPosition, glm::vec3( 0.0f, 0.0f, 0.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+	projection = glm::perspective( glm::radians( CameraFieldOfView ), swapChainExtent.width / ( float )swapChainExtent.height, 0.1f, 10.0f );
+	projection[1][1] *= -1;
+}
+
+float VulkanGraphicsInstance::EstimateScreenSize( const glm::vec4& boundingSphere ) const
+{
+	// Projected diameter in pixels of a world space bounding sphere
+	float radius = boundingSphere.w;
+	float distance = glm::length( glm::vec3( boundingSphere ) - CameraPosition );
+
+	if ( distance <= radius )
+	{
+		return static_cast< float >( swapChainExtent.height );
+	}
+
+	return radius / ( distance * std::tan( glm::radians( CameraFieldOfView ) * 0.5f ) ) * swapChainExtent.height;
+}
+
 //////////////////////////////
 // Public Functions
 //////////////////////////////
 
-void VulkanGraphicsInstance::InitializeModel( Model* pModel, const char* filename, const char* ptexname )
+Scene::Entity VulkanGraphicsInstance::InitializeModel( Model* pModel, const char* filename, const char* ptexname )
 {
 	pModel->Initialize( this, filename, ptexname );
 
-	renderObjects.push_back( pModel );
+	return RenderScene.CreateEntity( RenderScene.RegisterMesh( pModel ), pModel->MaterialIndex );
+}
+
+std::vector<Scene::Entity> VulkanGraphicsInstance::InitializeModels( const std::vector<Model*>& models, const std::vector<const char*>& filenames, const std::vector<const char*>& texnames )
+{
+	assert( models.size() == filenames.size() && models.size() == texnames.size() && "one model and texture file per model!" );
+
+	std::vector<VulkanTexture*> textures;
+	Textures.Acquire( texnames, textures );
+
+	std::vector<Scene::Entity> entities;
+
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		models[i]->Initialize( this, filenames[i], textures[i] );
+		entities.push_back( RenderScene.CreateEntity( RenderScene.RegisterMesh( models[i] ), models[i]->MaterialIndex ) );
+	}
+
+	return entities;
+}
+
+std::vector<Scene::Entity> VulkanGraphicsInstance::InitializeAtlasedModels( const std::vector<Model*>& models, const std::vector<const char*>& filenames, const std::vector<const char*>& texnames, const TextureAtlas::BuildOptions& options )
+{
+	assert( models.size() == filenames.size() && models.size() == texnames.size() && "one model and texture file per model!" );
+
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		models[i]->LoadModel( filenames[i] );
+	}
+
+	// A texture can only move into an atlas if none of its models rely on repeat addressing
+	std::unordered_map<std::string, bool> bAtlasable;
+
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		auto found = bAtlasable.emplace( texnames[i], true ).first;
+		found->second = found->second && models[i]->HasUnitRangeUVs();
+	}
+
+	std::vector<std::string> atlasPaths;
+	std::unordered_map<std::string, size_t> atlasIndices;
+
+	for ( const char* texname : texnames )
+	{
+		if ( bAtlasable[texname] && atlasIndices.emplace( texname, atlasPaths.size() ).second )
+		{
+			atlasPaths.push_back( std::string( TEXTURE_PATH ) + texname );
+		}
+	}
+
+	std::vector<TextureData> pages;
+	std::vector<TextureAtlas::Region> regions;
+	TextureAtlas::Build( TextureDecoding, atlasPaths, options, pages, regions );
+
+	std::vector<VulkanTexture*> pageTextures;
+	for ( const TextureData& page : pages )
+	{
+		pageTextures.push_back( Textures.Create( page ) );
+	}
+
+	// Atlased models share their page; the rest (too large, missing, repeating UVs) load as usual
+	std::vector<VulkanTexture*> textures( models.size(), nullptr );
+	std::vector<const char*> standaloneNames;
+	std::vector<size_t> standaloneModels;
+
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		auto found = atlasIndices.find( texnames[i] );
+
+		if ( found != atlasIndices.end() && regions[found->second].page != TextureAtlas::INVALID_PAGE )
+		{
+			const TextureAtlas::Region& region = regions[found->second];
+
+			models[i]->RemapUVs( region.uvOffset, region.uvScale );
+			textures[i] = pageTextures[region.page];
+			Textures.AddReference( textures[i] );
+			continue;
+		}
+
+		standaloneNames.push_back( texnames[i] );
+		standaloneModels.push_back( i );
+	}
+
+	std::vector<VulkanTexture*> standaloneTextures;
+	Textures.Acquire( standaloneNames, standaloneTextures );
+
+	for ( size_t i = 0; i < standaloneModels.size(); ++i )
+	{
+		textures[standaloneModels[i]] = standaloneTextures[i];
+	}
+
+	// Every page is now held by its models; drop the reference Create returned
+	for ( VulkanTexture* pPage : pageTextures )
+	{
+		Textures.Release( pPage );
+	}
+
+	std::vector<Scene::Entity> entities;
+
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		models[i]->Initialize( this, textures[i] );
+		entities.push_back( RenderScene.CreateEntity( RenderScene.RegisterMesh( models[i] ), models[i]->MaterialIndex ) );
+	}
+
+	return entities;
 }
 
 #ifdef _DEBUG
@@ -1,6 +1,17 @@
 #pragma once
 
 #include "GraphicsInstance.h"
+#include "DescriptorAllocator.h"
+#include "BindlessTextureTable.h"
+#include "SamplerCache.h"
+#include "LayoutCache.h"
+#include "TextureStreamer.h"
+#include "TextureDecodePool.h"
+#include "TextureCache.h"
+#include "TextureAtlas.h"
+#include "Scene.h"
+#include "GPUCulling.h"
+#include "DepthPyramid.h"
 
 #include <optional>
 #include <vector>
@@ -10,6 +21,7 @@
 
 class Texture;
 class Model;
+struct InstanceData;
 
 struct QueueFamilyIndices
 {
@@ -31,11 +43,42 @@ struct SwapChainSupportDetails
 
 struct UniformBufferObject
 {
-	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 proj;
 };
 
+// Small per-draw data written with vkCmdPushConstants while recording, so per-batch
+// state never needs its own descriptor set; per-instance data comes from InstanceData.
+// Must stay within the 128 byte minimum guaranteed by maxPushConstantsSize.
+struct PushConstantData
+{
+	uint32_t materialIndex;
+};
+
+static_assert( sizeof( PushConstantData ) <= 128, "push constant block exceeds the guaranteed minimum size" );
+
+// Running totals for the two mip generation paths, so the blit and CPU paths can be compared
+// on the same assets. Blit time is GPU time from timestamp queries, CPU time is wall clock.
+struct MipGenerationStats
+{
+	uint32_t blitTextures = 0;
+	double blitMilliseconds = 0.0;
+	uint32_t cpuTextures = 0;
+	double cpuMilliseconds = 0.0;
+};
+
+// State changes recorded for the last frame's draw list; the GPU culled path's draws are written by the GPU.
+// Drawn one at a time, every batch would bind the pipeline and its mesh's geometry and push its material;
+// bindsSkipped counts the ones already left in place by the batch before.
+struct DrawRecordingStats
+{
+	uint32_t batches = 0;
+	uint32_t pipelineBinds = 0;
+	uint32_t geometryBinds = 0;		// vertex and index buffers, and without bindless the model's descriptor set
+	uint32_t materialPushes = 0;
+	uint32_t bindsSkipped = 0;
+};
+
 class VulkanGraphicsInstance : public GraphicsInstance
 {
 public:
@@ -44,12 +87,64 @@ public:
 
 	void PreInitInstance( std::vector<const char*> requiredExtensions );
 
+	// Opt in before InitInstance; only takes effect when the device supports descriptor indexing
+	void EnableBindlessTextures() { bBindlessRequested = true; }
+	bool IsBindlessEnabled() const { return bBindlessEnabled; }
+	BindlessTextureTable& GetBindlessTextures() { return BindlessTextures; }
+
+	// Opt in before InitInstance; streams cooked textures under budgetBytes of VRAM. Needs bindless textures.
+	void EnableTextureStreaming( VkDeviceSize budgetBytes ) { bStreamingRequested = true; StreamingBudget = budgetBytes; }
+	bool IsTextureStreamingEnabled() const { return bStreamingEnabled; }
+	TextureStreamer& GetTextureStreamer() { return TextureStreaming; }
+
+	SamplerCache& GetSamplerCache() { return Samplers; }
+
+	// Shared by every texture load; its statistics report decode throughput (MB/s, textures/s)
+	TextureDecodePool& GetTextureDecodePool() { return TextureDecoding; }
+
+	// Models get their textures here so each image is loaded once however many models use it
+	TextureCache& GetTextureCache() { return Textures; }
+
+	// Every drawn object is an entity here; InitializeModel* register the mesh and create one entity per model
+	Scene& GetScene() { return RenderScene; }
+	// Tested and visible objects and submeshes of the last recorded frame
+	const Scene::CullingStatistics& GetCullingStatistics() const { return RenderScene.GetCullingStatistics(); }
+
+	// How far, in pixels, a coarser LOD may move a mesh's silhouette before a finer one is drawn; 0 always draws full detail
+	void SetLodPixelThreshold( float pixels ) { LodPixelThreshold = pixels; }
+	const Scene::LodStatistics& GetLodStatistics() const { return RenderScene.GetLodStatistics(); }
+
+	// Opt in before InitInstance; culls in a compute pass and draws with indirect count draws when the device supports them.
+	// Needs bindless textures. With bValidate the CPU culler still runs every frame and the statistics compare the two.
+	void EnableGPUCulling( bool bValidate = false ) { bGPUCullingRequested = true; bValidateGPUCulling = bValidate; }
+	bool IsGPUCullingEnabled() const { return bGPUCullingEnabled; }
+	// GPU culling down to meshlets: clusters facing away from the camera or outside the frustum are skipped too.
+	// Implies EnableGPUCulling; validation against the CPU culler doesn't apply to clusters.
+	void EnableClusterCulling() { bGPUCullingRequested = true; bClusterCullingRequested = true; }
+	bool IsClusterCullingEnabled() const { return bGPUCullingEnabled && bClusterCullingRequested; }
+	// GPU culling against a depth pyramid too: objects hidden behind what was drawn first are skipped. Implies
+	// EnableGPUCulling and renders the scene in two passes; not with cluster culling, which takes precedence.
+	void EnableOcclusionCulling() { bGPUCullingRequested = true; bOcclusionCullingRequested = true; }
+	bool IsOcclusionCullingEnabled() const { return bOcclusionCullingEnabled; }
+	// Counts read back from the GPU, a few frames behind the one being recorded
+	const GPUCuller::Statistics& GetGPUCullingStatistics() const { return GPUCulling.GetStatistics(); }
+
+	// Instanced draws of the last frame recorded without GPU culling, one per mesh, material and index range
+	const std::vector<Scene::DrawBatch>& GetDrawBatches() const { return DrawBatches; }
+	const DrawRecordingStats& GetDrawRecordingStats() const { return DrawStats; }
+
+	// Build mip chains with MipGenerator even where the device could blit them
+	void SetPreferCPUMips( bool bPrefer ) { bPreferCPUMips = bPrefer; }
+	void RecordCPUMipGeneration( double milliseconds );
+	const MipGenerationStats& GetMipGenerationStats() const { return MipStats; }
+
 	virtual void WaitForFrameComplete() override;
 
 	virtual void ResizeFrame( unsigned int width, unsigned int height ) override;
 
 	VkInstance* GetInstance() { return &vulkanInstance; }
 	VkDevice* GetDevice() { return &vulkanDevice; }
+	VkPhysicalDevice GetPhysicalDevice() const { return physicalDevice; }
 
 private:
 	VulkanGraphicsInstance( const VulkanGraphicsInstance& ) = delete;
@@ -77,6 +172,8 @@ private:
 	VkSampleCountFlagBits GetMaxUsableSampleCount();
 	QueueFamilyIndices FindQueueFamilies( VkPhysicalDevice device );
 	bool CheckDeviceExtensionSupport( VkPhysicalDevice device );
+	bool CheckDescriptorIndexingSupport( VkPhysicalDevice device );
+	uint32_t GetBindlessTextureCapacity();
 	SwapChainSupportDetails QuerySwapChainSupport( VkPhysicalDevice device );
 
 	void CreateLogicalDevice();
@@ -88,6 +185,8 @@ private:
 
 public:
 	VkImageView CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels );
+	bool IsFormatSampleable( VkFormat format );
+	bool ShouldGenerateMipsOnCPU( VkFormat format );
 private:
 	void CreateImageViews();
 
@@ -98,6 +197,8 @@ private:
 	void CreateDescriptorSetLayout();
 
 	void CreateGraphicsPipeline();
+	// bInstanced adds InstanceData as vertex binding 1
+	VkPipeline CreateScenePipeline( const char* vertexShaderName, const char* fragmentShaderName, VkPipelineLayout layout, bool bInstanced );
 	VkShaderModule CreateShaderModule( const std::vector<char>& code );
 
 	void CreateCommandPool();
@@ -118,6 +219,12 @@ private:
 	void CreateDescriptorPool();
 
 	void CreateCommandBuffers();
+	void RecordCommandBuffer( uint32_t imageIndex );
+	// The render pass contents: the CPU culled DrawList with per-draw push constants, or GPUCuller's indirect draws
+	void RecordDrawList( VkCommandBuffer commandBuffer, uint32_t imageIndex );
+	// bLate draws the late occlusion pass, inside lateRenderPass
+	void RecordIndirectDraws( VkCommandBuffer commandBuffer, uint32_t imageIndex, bool bLate = false );
+	void ReserveInstances( uint32_t count );
 
 	void CreateSyncObjects();
 
@@ -128,6 +235,7 @@ public:
 	void CreateBuffer( VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory );
 	void CopyBuffer( VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size );
 	void CopyBufferToImage( VkBuffer buffer, VkImage image, uint32_t width, uint32_t height );
+	void CopyBufferToImage( VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions );
 
 	//////////////////////////////
 	// Command Functions
@@ -141,6 +249,11 @@ public:
 
 	void CreateImageSamplerDescriptorSet( std::vector<VkDescriptorSet>& DescriptorSetVector, VkImageView TextureImageView, VkSampler TextureSampler );
 
+	// Valid until this frame slot comes around again; the pool is reset wholesale in DrawFrameInternal
+	VkDescriptorSet AllocateTransientDescriptorSet( VkDescriptorSetLayout layout );
+
+	DescriptorAllocator::Statistics GetDescriptorStatistics() const;
+
 /////////////////////////////////////////
 // Cleanup Functions
 /////////////////////////////////////////
@@ -153,12 +266,19 @@ private:
 /////////////////////////////////////////
 
 	void UpdateUniformBuffer( uint32_t );
+	// Shared by the uniform buffer and the frustum culling, so both always see the same camera
+	void GetCameraMatrices( glm::mat4& view, glm::mat4& projection ) const;
+	float EstimateScreenSize( const glm::vec4& boundingSphere ) const;
 
 /////////////////////////////////////////
 // Public Functions
 /////////////////////////////////////////
 public:
-	void InitializeModel( Model* pModel, const char* filename, const char* ptexname = "chaletTex.jpg" );
+	Scene::Entity InitializeModel( Model* pModel, const char* filename, const char* ptexname = "chaletTex.jpg" );
+	// Same as InitializeModel per entry, but every texture is decoded in one parallel batch first
+	std::vector<Scene::Entity> InitializeModels( const std::vector<Model*>& models, const std::vector<const char*>& filenames, const std::vector<const char*>& texnames );
+	// Same again, but small textures are packed into shared atlas pages and their models' UVs remapped to match
+	std::vector<Scene::Entity> InitializeAtlasedModels( const std::vector<Model*>& models, const std::vector<const char*>& filenames, const std::vector<const char*>& texnames, const TextureAtlas::BuildOptions& options = TextureAtlas::BuildOptions() );
 
 	void FinalizeInit(); // TODO remove
 
@@ -198,9 +318,12 @@ private:
 	std::vector<VkFramebuffer> swapChainFramebuffers;
 
 	VkRenderPass renderPass;
-	VkDescriptorSetLayout descriptorSetLayout;
-	VkPipelineLayout pipelineLayout;
+	VkRenderPass lateRenderPass = VK_NULL_HANDLE;	// occlusion culling only: renderPass again, loading what it stored
+	VkDescriptorSetLayout descriptorSetLayout;	// owned by DescriptorLayouts
+	VkPipelineLayout pipelineLayout;			// owned by PipelineLayouts, survives swapchain recreation
 	VkPipeline graphicsPipeline;
+	VkPipelineLayout indirectPipelineLayout = VK_NULL_HANDLE;	// pipelineLayout plus the GPUCuller object set
+	VkPipeline indirectPipeline = VK_NULL_HANDLE;				// GPU culling only
 
 	VkCommandPool commandPool;
 	std::vector<VkCommandBuffer> commandBuffers;
@@ -213,12 +336,44 @@ private:
 	VkDeviceMemory DepthImageMemory;
 	VkImageView DepthImageView;
 
-	VkDescriptorPool DescriptorPool;
-	std::vector<VkDescriptorSet> DescriptorSets;
+	DescriptorAllocator PersistentDescriptors;				// swapchain lifetime sets, reset on RecreateSwapChain
+	std::vector<DescriptorAllocator> FrameDescriptors;		// one per frame in flight
+	std::vector<VkDescriptorSet> DescriptorSets;			// UBO-only global sets, bindless mode only
+
+	SamplerCache Samplers;
+	DescriptorLayoutCache DescriptorLayouts;
+	PipelineLayoutCache PipelineLayouts;
+
+	bool bBindlessRequested = false;
+	bool bBindlessEnabled = false;
+	BindlessTextureTable BindlessTextures;
+
+	bool bStreamingRequested = false;
+	bool bStreamingEnabled = false;
+	VkDeviceSize StreamingBudget = 0;
+	TextureStreamer TextureStreaming;
+
+	bool bGPUCullingRequested = false;
+	bool bGPUCullingEnabled = false;
+	bool bValidateGPUCulling = false;
+	bool bClusterCullingRequested = false;
+	bool bOcclusionCullingRequested = false;
+	bool bOcclusionCullingEnabled = false;
+	GPUCuller GPUCulling;
+	DepthPyramid OcclusionPyramid;	// built from DepthImage between the two passes
+
+	TextureDecodePool TextureDecoding;
+	TextureCache Textures;
+
+	bool bPreferCPUMips = false;
+	MipGenerationStats MipStats;
 
 	std::vector<VkBuffer> UniformBuffers;
 	std::vector<VkDeviceMemory> UniformBuffersMemory;
 
+	glm::vec3 CameraPosition = glm::vec3( 2.0f, 3.0f, 2.0f );
+	float CameraFieldOfView = 45.0f;	// vertical, degrees
+	float LodPixelThreshold = 1.0f;
 
 	const int MAX_FRAMES_IN_FLIGHT = 2;
 	std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -229,7 +384,20 @@ private:
 
 	std::vector<const char*> extensions;
 
-	std::vector<Model*> renderObjects;
+	Scene RenderScene;
+	std::vector<Scene::DrawItem> DrawList;	// rebuilt every frame, kept to reuse its allocation
+	std::vector<Scene::DrawBatch> DrawBatches;
+	DrawRecordingStats DrawStats;
+
+	// InstanceData for DrawList, one host visible buffer per frame in flight, grown on demand
+	struct InstanceBuffer
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		InstanceData* pInstances = nullptr;
+		uint32_t capacity = 0;
+	};
+	std::vector<InstanceBuffer> InstanceBuffers;
 
 #ifdef _DEBUG
 	VkDebugUtilsMessengerEXT debugMessenger;
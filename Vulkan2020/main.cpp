@@ -1,5 +1,12 @@
 
 #include "Vulkan2020App.h"
+#include "TextureCooker.h"
+#include "AssetArchive.h"
+#include "AssetDatabase.h"
+#include "BoundingVolumeHierarchy.h"
+#include "VirtualFileSystem.h"
+
+#include <cstring>
 
 #ifdef _DEBUG
 #define _CRTDBG_MAP_ALLOC
@@ -7,13 +14,54 @@
 #include <crtdbg.h>
 #endif
 
-int main()
+int main( int argc, char** argv )
 {
 #ifdef _DEBUG
 	_CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
 #endif
 
-	Vulkan2020App app;
+	// Tool modes run without opening a window or creating a device
+	if ( argc > 1 && strcmp( argv[1], "-cook" ) == 0 )
+	{
+		return TextureCooker::RunCommandLine( argc - 2, argv + 2 );
+	}
+
+	if ( argc > 1 && strcmp( argv[1], "-benchmips" ) == 0 )
+	{
+		return TextureCooker::RunMipBenchmark( argc - 2, argv + 2 );
+	}
+
+	if ( argc > 1 && strcmp( argv[1], "-benchdecode" ) == 0 )
+	{
+		return TextureCooker::RunDecodeBenchmark( argc - 2, argv + 2 );
+	}
+
+	if ( argc > 1 && strcmp( argv[1], "-benchbvh" ) == 0 )
+	{
+		return BoundingVolumeHierarchy::RunBenchmark( argc - 2, argv + 2 );
+	}
+
+	if ( argc > 1 && strcmp( argv[1], "-build" ) == 0 )
+	{
+		return AssetDatabase::RunCommandLine( argc - 2, argv + 2 );
+	}
+
+	if ( argc > 1 && strcmp( argv[1], "-pack" ) == 0 )
+	{
+		return AssetArchive::RunCommandLine( argc - 2, argv + 2 );
+	}
+
+	Vulkan2020Options options;
+	if ( !options.Parse( argc - 1, argv + 1 ) )
+	{
+		return EXIT_FAILURE;
+	}
+
+	// Packed archives are optional; anything they don't contain is read from the loose files
+	VirtualFileSystem::Mount( "../assets.vpak", "../assets/" );
+	VirtualFileSystem::Mount( "shaders.vpak", "shaders/" );
+
+	Vulkan2020App app( options );
 
 	try
 	{
@@ -22,8 +70,11 @@ int main()
 	catch ( const std::exception & e )
 	{
 		std::cerr << e.what() << std::endl;
+		VirtualFileSystem::UnmountAll();
 		return EXIT_FAILURE;
 	}
 
+	VirtualFileSystem::UnmountAll();
+
 	return EXIT_SUCCESS;
 }
\ No newline at end of file